@@ -0,0 +1,116 @@
+// Collision detection per simulation step, half props and half cars spread at a fixed density, so the cost per
+// body should stay flat as the count grows. Items are bodies.
+// The contacts found are checked against testing every pair before the broadphase is timed.
+// Run with ./benchmarks --benchmark_filter=Collision
+
+#include <benchmark/benchmark.h>
+
+#include "../src/physics/Collision.h"
+#include "../src/physics/CollisionWorld.h"
+#include "../src/physics/SpatialHash.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+static const float AREA_PER_BODY = 100.0f;
+static const size_t CHECKED_BODIES = 2000;   // Largest count the pairwise check is run for
+
+static float randomRange(float min, float max){
+    return min + (max - min) * (rand() / float(RAND_MAX));
+}
+
+struct Bodies {
+    std::vector<OrientedBox> props;
+    std::vector<OrientedBox> cars;
+};
+
+static Bodies makeBodies(size_t count){
+    srand(1);
+    float half = std::sqrt(count * AREA_PER_BODY) * 0.5f;
+    Bodies bodies;
+    for(size_t i = 0; i < count; i++){
+        glm::vec2 centre(randomRange(-half, half), randomRange(-half, half));
+        float heading = randomRange(-M_PI, M_PI);
+        if(i % 2 == 0) bodies.props.push_back(OrientedBox(centre, glm::vec2(1.0f, 1.0f), heading));
+        else bodies.cars.push_back(OrientedBox(centre, glm::vec2(1.0f, 2.25f), heading));
+    }
+    return bodies;
+}
+
+static void addStatic(CollisionWorld& world, const Bodies& bodies){
+    for(size_t i = 0; i < bodies.props.size(); i++){
+        world.addStatic(bodies.props[i]);
+    }
+    world.buildStatic();
+}
+
+static void addDynamic(CollisionWorld& world, const Bodies& bodies){
+    world.clearDynamic();
+    for(size_t i = 0; i < bodies.cars.size(); i++){
+        world.addDynamic(bodies.cars[i]);
+    }
+}
+
+// Contacts every car has with every prop and every later car.
+static size_t countPairwise(const Bodies& bodies){
+    size_t count = 0;
+    glm::vec2 normal;
+    float depth;
+    for(size_t i = 0; i < bodies.cars.size(); i++){
+        for(size_t j = 0; j < bodies.props.size(); j++){
+            count += Collision::intersect(bodies.cars[i], bodies.props[j], normal, depth);
+        }
+        for(size_t j = i + 1; j < bodies.cars.size(); j++){
+            count += Collision::intersect(bodies.cars[i], bodies.cars[j], normal, depth);
+        }
+    }
+    return count;
+}
+
+static void BM_CollisionWorldStep(benchmark::State& state){
+    Bodies bodies = makeBodies(state.range(0));
+    CollisionWorld world;
+    addStatic(world, bodies);
+    if((size_t)state.range(0) <= CHECKED_BODIES){
+        addDynamic(world, bodies);
+        size_t found = world.findContacts().size();
+        size_t expected = countPairwise(bodies);
+        if(found != expected){
+            state.SkipWithError(("found " + std::to_string(found) + " contacts, expected "
+                                 + std::to_string(expected)).c_str());
+            return;
+        }
+    }
+
+    size_t contacts = 0;
+    for(auto _ : state){
+        addDynamic(world, bodies);
+        contacts = world.findContacts().size();
+        benchmark::DoNotOptimize(contacts);
+    }
+    state.counters["contacts"] = contacts;
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_SpatialHashBuild(benchmark::State& state){
+    Bodies bodies = makeBodies(state.range(0));
+    SpatialHash hash(8.0f);
+    for(auto _ : state){
+        hash.clear();
+        for(size_t i = 0; i < bodies.cars.size(); i++){
+            glm::vec2 min, max;
+            bodies.cars[i].getBounds(min, max);
+            hash.insert(i, min, max);
+        }
+        hash.build();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * bodies.cars.size());
+}
+
+BENCHMARK(BM_CollisionWorldStep)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_SpatialHashBuild)->Arg(1000)->Arg(10000)->Arg(100000);
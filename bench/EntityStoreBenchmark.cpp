@@ -0,0 +1,157 @@
+// Per frame cost of updating and submitting entities, old object-per-entity loop against EntityStore.
+// Run with ./benchmarks --benchmark_filter=Entity
+
+#include <benchmark/benchmark.h>
+
+#include "../src/objects/Entity.h"
+#include "../src/objects/EntityStore.h"
+#include "../src/utils/Frustum.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Share of entities with behaviour, the rest are props placed once. The game has 1 in ~540.
+static const int DYNAMIC_EVERY = 100;
+static const float WORLD_SIZE = 1000.0f;
+
+static Model* getPropModel(){
+    static Model* model = NULL;
+    if(model == NULL){
+        model = new Model();
+        model->addRange(std::vector<float>{-1.0f, 0.0f, -1.0f, 1.0f, 2.0f, 1.0f});
+    }
+    return model;
+}
+
+static glm::vec3 randomPosition(){
+    return glm::vec3((rand() / float(RAND_MAX) - 0.5f) * WORLD_SIZE, 0.0f,
+                     (rand() / float(RAND_MAX) - 0.5f) * WORLD_SIZE);
+}
+
+// The game's projection, looking along +z from the middle of the world.
+static Frustum getFrustum(){
+    glm::mat4 projection = glm::perspective(float(M_PI) / 4.0f, 4.0f / 3.0f, 1.0f, 800.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 5.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return Frustum(projection, view);
+}
+
+// What main.cpp and EntityRenderer did before: a virtual update() and a fresh model matrix for every entity.
+static void BM_EntityLegacyFrame(benchmark::State& state){
+    srand(1);
+    std::vector<Entity*> entities;
+    for(int i = 0; i < state.range(0); i++){
+        Entity* entity = new Entity(getPropModel());
+        entity->setPosition(randomPosition());
+        entity->setScale(glm::vec3(0.1f));
+        entities.push_back(entity);
+    }
+
+    for(auto _ : state){
+        glm::mat4 sum(0.0f);
+        for(size_t i = 0; i < entities.size(); i++){
+            Entity* entity = entities[i];
+            entity->update();
+            glm::mat4 rotation = Entity::calculateRotationMatrix(entity->getRotationX(), entity->getRotationY(),
+                                                                 entity->getRotationZ());
+            sum += Entity::calculateModelMatrix(entity->getPosition(), rotation, entity->getScale());
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+
+    for(size_t i = 0; i < entities.size(); i++){
+        delete entities[i];
+    }
+}
+
+static void fillStore(EntityStore& store, std::vector<Entity*>& behaviours, int count){
+    srand(1);
+    store.reserve(count);
+    for(int i = 0; i < count; i++){
+        if(i % DYNAMIC_EVERY == 0){
+            Entity* entity = new Entity(getPropModel());
+            entity->setPosition(randomPosition());
+            entity->setScale(glm::vec3(0.1f));
+            behaviours.push_back(entity);
+            store.add(entity);
+        } else {
+            store.add(getPropModel(), randomPosition(), glm::vec3(0.1f));
+        }
+    }
+    store.flushTransforms();
+}
+
+static void BM_EntityStoreUpdate(benchmark::State& state){
+    EntityStore store;
+    std::vector<Entity*> behaviours;
+    fillStore(store, behaviours, state.range(0));
+
+    for(auto _ : state){
+        store.update();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+
+    for(size_t i = 0; i < behaviours.size(); i++){
+        delete behaviours[i];
+    }
+}
+
+// Culling plus gathering the matrices the renderer would upload.
+static void BM_EntityStoreSubmit(benchmark::State& state){
+    EntityStore store;
+    std::vector<Entity*> behaviours;
+    fillStore(store, behaviours, state.range(0));
+    Frustum frustum = getFrustum();
+
+    std::vector<EntityHandle> visible;
+    std::vector<glm::mat4> uploads;
+    for(auto _ : state){
+        visible.clear();
+        uploads.clear();
+        store.collectVisible(frustum, visible);
+        for(size_t i = 0; i < visible.size(); i++){
+            uploads.push_back(store.getMatrix(visible[i]));
+        }
+        benchmark::DoNotOptimize(uploads.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["visible"] = visible.size();
+
+    for(size_t i = 0; i < behaviours.size(); i++){
+        delete behaviours[i];
+    }
+}
+
+// Entity::getModelMatrix for 1000 entities, either all turned since the last call so every matrix is rebuilt,
+// or all unchanged so the cached one is returned.
+static void BM_EntityGetModelMatrix(benchmark::State& state){
+    bool moving = state.range(0) != 0;
+    srand(1);
+    std::vector<Entity> entities(1000, Entity(getPropModel()));
+    for(size_t i = 0; i < entities.size(); i++){
+        entities[i].setPosition(randomPosition());
+        entities[i].setScale(glm::vec3(0.1f));
+    }
+
+    float angle = 0.0f;
+    for(auto _ : state){
+        glm::mat4 sum(0.0f);
+        angle += 0.01f;
+        for(size_t i = 0; i < entities.size(); i++){
+            if(moving) entities[i].setRotationY(angle);
+            sum += entities[i].getModelMatrix();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)entities.size());
+    state.SetLabel(moving ? "rebuilt" : "cached");
+}
+
+BENCHMARK(BM_EntityLegacyFrame)->Arg(540)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_EntityStoreUpdate)->Arg(540)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_EntityStoreSubmit)->Arg(540)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_EntityGetModelMatrix)->Arg(0)->Arg(1);
@@ -0,0 +1,69 @@
+// Loading the lights into a shader's uniforms, the way EntityShader and TerrainShader do for every pass.
+// There is no GL context here, so glad's uniform functions are pointed at stubs that only count the calls and what
+// is timed is the CPU side: looking up the locations and one call per light member.
+// Run with ./benchmarks --benchmark_filter=Light
+
+#include <benchmark/benchmark.h>
+
+#include "../src/utils/ShaderProgram.h"
+
+#include <vector>
+
+static long long uniformCalls = 0;
+
+static void APIENTRY stubUniform1i(GLint, GLint){ uniformCalls++; }
+static void APIENTRY stubUniform1f(GLint, GLfloat){ uniformCalls++; }
+static void APIENTRY stubUniformfv(GLint, GLsizei, const GLfloat*){ uniformCalls++; }
+
+// Stands in for a compiled shader, with made up uniform locations.
+class LightUniformShader : public ShaderProgram {
+public:
+    LightUniformShader() : ShaderProgram(0) {
+        bindUniformLocations();
+    }
+
+    virtual void bindUniformLocations(){
+        for(int i = 0; i < MAX_LIGHTS; i++){
+            GLuint first = 1 + i * 7;
+            LightLocations& locations = lightLocations[i];
+            locations.position = first;
+            locations.specular = first + 1;
+            locations.diffuse = first + 2;
+            locations.ambient = first + 3;
+            locations.radius = first + 4;
+            locations.coneAngle = first + 5;
+            locations.coneDirection = first + 6;
+        }
+    }
+
+    // Same as EntityShader::loadLights, num_lights at location 0.
+    void loadLights(const std::vector<Light*>& lights){
+        int count = std::min((int)lights.size(), MAX_LIGHTS);
+        loadUniformValue(0, count);
+        for(int i = 0; i < count; i++){
+            loadLight(lights[i], i);
+        }
+    }
+};
+
+static void BM_LightUniforms(benchmark::State& state){
+    glad_glUniform1i = stubUniform1i;
+    glad_glUniform1f = stubUniform1f;
+    glad_glUniform3fv = stubUniformfv;
+    glad_glUniform4fv = stubUniformfv;
+
+    std::vector<Light> storage(state.range(0));
+    std::vector<Light*> lights;
+    for(size_t i = 0; i < storage.size(); i++){
+        storage[i].position = glm::vec4((float)i, 10.0f, 0.0f, 1.0f);
+        storage[i].diffuse = glm::vec3(0.5f);
+        lights.push_back(&storage[i]);
+    }
+    LightUniformShader shader;
+    uniformCalls = 0;
+    for(auto _ : state){
+        shader.loadLights(lights);
+    }
+    state.counters["uniform_calls"] = benchmark::Counter((double)uniformCalls / state.iterations());
+}
+BENCHMARK(BM_LightUniforms)->Arg(1)->Arg(3)->Arg(10);
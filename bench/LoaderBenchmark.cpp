@@ -0,0 +1,86 @@
+// Model loading on the CPU: parsing OBJ text with tinyobj and Loader::generateNormals, on square grid meshes.
+// Run with ./benchmarks --benchmark_filter=Loader
+
+#include <benchmark/benchmark.h>
+
+#include "../src/utils/Loader.h"
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Grid of side x side quads with some relief, as positions and triangle indices.
+static void makeGrid(int side, std::vector<float>& vertices, std::vector<unsigned int>& indices){
+    vertices.clear();
+    indices.clear();
+    for(int z = 0; z <= side; z++){
+        for(int x = 0; x <= side; x++){
+            vertices.push_back((float)x);
+            vertices.push_back(std::sin(x * 0.3f) * std::cos(z * 0.2f));
+            vertices.push_back((float)z);
+        }
+    }
+    for(int z = 0; z < side; z++){
+        for(int x = 0; x < side; x++){
+            unsigned int corner = z * (side + 1) + x;
+            unsigned int below = corner + side + 1;
+            unsigned int quad[6] = {corner, below, corner + 1, corner + 1, below, below + 1};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+// The same grid as an OBJ file with texture coordinates and normals, like the exported models in res/.
+static std::string makeGridObj(int side){
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    makeGrid(side, vertices, indices);
+    std::ostringstream obj;
+    obj << "o grid\n";
+    for(size_t i = 0; i < vertices.size(); i += 3){
+        obj << "v " << vertices[i] << " " << vertices[i + 1] << " " << vertices[i + 2] << "\n";
+        obj << "vt " << vertices[i] / side << " " << vertices[i + 2] / side << "\n";
+        obj << "vn 0 1 0\n";
+    }
+    for(size_t i = 0; i < indices.size(); i += 3){
+        obj << "f";
+        for(int j = 0; j < 3; j++){
+            unsigned int index = indices[i + j] + 1;
+            obj << " " << index << "/" << index << "/" << index;
+        }
+        obj << "\n";
+    }
+    return obj.str();
+}
+
+static void BM_LoaderParseObj(benchmark::State& state){
+    std::string obj = makeGridObj((int)state.range(0));
+    tinyobj::MaterialFileReader materialReader("");
+    for(auto _ : state){
+        std::istringstream stream(obj);
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string err;
+        if(!tinyobj::LoadObj(shapes, materials, err, stream, materialReader)){
+            state.SkipWithError(err.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(shapes[0].mesh.indices.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)obj.size());
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0) * 2);
+}
+BENCHMARK(BM_LoaderParseObj)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+
+static void BM_LoaderGenerateNormals(benchmark::State& state){
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    makeGrid((int)state.range(0), vertices, indices);
+    for(auto _ : state){
+        std::vector<float> normals = Loader::getLoader()->generateNormals(vertices, indices);
+        benchmark::DoNotOptimize(normals.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)indices.size() / 3);
+}
+BENCHMARK(BM_LoaderGenerateNormals)->Arg(64)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
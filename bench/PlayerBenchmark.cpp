@@ -0,0 +1,48 @@
+// One fixed step of the player's car, driving in circles on rolling terrain, with the simple controls and with the
+// car physics. Run with ./benchmarks --benchmark_filter=Player
+
+#include <benchmark/benchmark.h>
+
+#include "../src/objects/Player.h"
+
+#include <cmath>
+#include <vector>
+
+static Terrain* getPlayerTerrain(){
+    static Terrain* terrain = NULL;
+    if(terrain == NULL){
+        const int SIDE = 1024;
+        std::vector<float> heights((size_t)SIDE * SIDE);
+        for(int z = 0; z < SIDE; z++){
+            for(int x = 0; x < SIDE; x++){
+                heights[(size_t)z * SIDE + x] = 0.5f + 0.25f * std::sin(x * 0.02f) * std::cos(z * 0.03f);
+            }
+        }
+        terrain = new Terrain(new Model(), std::vector<GLuint>(), HeightMap(heights, SIDE, SIDE));
+    }
+    return terrain;
+}
+
+// Bounds of the Mustang model, scaled like the game's player.
+static Model* getCarModel(){
+    static Model* model = NULL;
+    if(model == NULL){
+        model = new Model();
+        model->addRange(std::vector<float>{-9.0f, 0.0f, -22.0f, 9.0f, 13.0f, 22.0f});
+    }
+    return model;
+}
+
+static void BM_PlayerUpdate(benchmark::State& state){
+    bool basicControls = state.range(0) == 0;
+    Player player(getCarModel(), getPlayerTerrain(), basicControls);
+    player.setScale(glm::vec3(0.1f));
+    player.handleKeyboardEvents(NULL, GLFW_KEY_W, 0, GLFW_PRESS, 0);
+    player.handleKeyboardEvents(NULL, GLFW_KEY_A, 0, GLFW_PRESS, 0);
+    for(auto _ : state){
+        player.beginStep();
+        benchmark::DoNotOptimize(player.update());
+    }
+    state.SetLabel(basicControls ? "basic" : "physics");
+}
+BENCHMARK(BM_PlayerUpdate)->Arg(0)->Arg(1);
@@ -0,0 +1,85 @@
+// Terrain on the CPU: building the mesh of a height map and the height and slope queries the cars make every step.
+// Terrain::generateTerrainModel is buildTerrainMesh plus the upload to GL, only the first part is timed here.
+// Run with ./benchmarks --benchmark_filter=Terrain
+
+#include <benchmark/benchmark.h>
+
+#include "../src/objects/Terrain.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Rolling hills with the game's 1024 pixel height map by default.
+static HeightMap makeHeightMap(int side){
+    std::vector<float> heights((size_t)side * side);
+    for(int z = 0; z < side; z++){
+        for(int x = 0; x < side; x++){
+            heights[(size_t)z * side + x] = 0.5f + 0.25f * std::sin(x * 0.02f) * std::cos(z * 0.03f)
+                    + 0.05f * std::sin(x * 0.3f + z * 0.2f);
+        }
+    }
+    return HeightMap(heights, side, side);
+}
+
+static Terrain* getTerrain(){
+    static Terrain* terrain = NULL;
+    if(terrain == NULL){
+        terrain = new Terrain(new Model(), std::vector<GLuint>(), makeHeightMap(1024));
+    }
+    return terrain;
+}
+
+// Points spread over the whole terrain, which is centred on the origin.
+static std::vector<glm::vec2> makeQueryPoints(size_t count){
+    srand(1);
+    std::vector<glm::vec2> points(count);
+    float half = Terrain::TERRAIN_SIZE * 0.49f;
+    for(size_t i = 0; i < count; i++){
+        points[i] = glm::vec2((rand() / float(RAND_MAX) * 2.0f - 1.0f) * half,
+                              (rand() / float(RAND_MAX) * 2.0f - 1.0f) * half);
+    }
+    return points;
+}
+
+static void BM_TerrainBuildMesh(benchmark::State& state){
+    HeightMap heightMap = makeHeightMap((int)state.range(0));
+    for(auto _ : state){
+        TerrainMesh mesh;
+        Terrain::buildTerrainMesh(heightMap, Terrain::TERRAIN_SIZE, Terrain::TERRAIN_MAX_HEIGHT, mesh);
+        benchmark::DoNotOptimize(mesh.indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_TerrainBuildMesh)->Arg(257)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_TerrainGetHeight(benchmark::State& state){
+    Terrain* terrain = getTerrain();
+    std::vector<glm::vec2> points = makeQueryPoints(4096);
+    for(auto _ : state){
+        float sum = 0.0f;
+        for(size_t i = 0; i < points.size(); i++){
+            sum += terrain->getHeight(points[i].x, points[i].y);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_TerrainGetHeight);
+
+// Both angles, as Player::update asks for them every step.
+static void BM_TerrainGetAngle(benchmark::State& state){
+    Terrain* terrain = getTerrain();
+    std::vector<glm::vec2> points = makeQueryPoints(4096);
+    for(auto _ : state){
+        float sum = 0.0f;
+        for(size_t i = 0; i < points.size(); i++){
+            float heading = (float)i * 0.01f;
+            sum += terrain->getAngleX(points[i].x, points[i].y, heading);
+            sum += terrain->getAngleZ(points[i].x, points[i].y, heading);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_TerrainGetAngle);
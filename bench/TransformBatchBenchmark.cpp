@@ -0,0 +1,96 @@
+// Batched model matrices against one Entity::calculateModelMatrix call per entity.
+// Each batched path is checked against the glm result before it is timed.
+// Run with ./benchmarks --benchmark_filter=Transform
+
+#include <benchmark/benchmark.h>
+
+#include "../src/objects/Entity.h"
+#include "../src/utils/TransformBatch.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Relative to the larger of 1 and the element, so positions far from the origin get the same bound.
+static const float MAX_ERROR = 2e-6f;
+
+static float randomRange(float min, float max){
+    return min + (max - min) * (rand() / float(RAND_MAX));
+}
+
+static TransformSoA makeTransforms(size_t count){
+    srand(1);
+    TransformSoA transforms;
+    transforms.resize(count);
+    for(size_t i = 0; i < count; i++){
+        glm::vec3 position(randomRange(-500.0f, 500.0f), randomRange(-10.0f, 50.0f), randomRange(-500.0f, 500.0f));
+        glm::vec3 rotation(randomRange(-0.5f, 0.5f), randomRange(-2.0f * M_PI, 2.0f * M_PI), randomRange(-0.5f, 0.5f));
+        float scale = randomRange(0.001f, 2.0f);
+        transforms.set(i, position, rotation, glm::vec3(scale));
+    }
+    return transforms;
+}
+
+static glm::mat4 referenceMatrix(const TransformSoA& in, size_t i){
+    glm::mat4 rotation = Entity::calculateRotationMatrix(in.rotationX[i], in.rotationY[i], in.rotationZ[i]);
+    return Entity::calculateModelMatrix(glm::vec3(in.positionX[i], in.positionY[i], in.positionZ[i]), rotation,
+                                        glm::vec3(in.scaleX[i], in.scaleY[i], in.scaleZ[i]));
+}
+
+static float maxError(const TransformSoA& in, const std::vector<glm::mat4>& out){
+    float worst = 0.0f;
+    for(size_t i = 0; i < in.size(); i++){
+        glm::mat4 expected = referenceMatrix(in, i);
+        for(int c = 0; c < 4; c++){
+            for(int r = 0; r < 4; r++){
+                float error = std::fabs(out[i][c][r] - expected[c][r]) / std::max(1.0f, std::fabs(expected[c][r]));
+                worst = std::max(worst, error);
+            }
+        }
+    }
+    return worst;
+}
+
+static void BM_TransformGlm(benchmark::State& state){
+    TransformSoA in = makeTransforms(state.range(0));
+    std::vector<glm::mat4> out(in.size());
+    for(auto _ : state){
+        for(size_t i = 0; i < in.size(); i++){
+            out[i] = referenceMatrix(in, i);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_TransformBatch(benchmark::State& state, TransformBatch::Path path){
+    if(path > TransformBatch::getBestPath()){
+        state.SkipWithError("not supported by this CPU");
+        return;
+    }
+    TransformSoA in = makeTransforms(state.range(0));
+    std::vector<glm::mat4> out(in.size());
+
+    TransformBatch::calculateModelMatrices(in, &out[0], path);
+    float error = maxError(in, out);
+    if(error > MAX_ERROR){
+        state.SkipWithError(("differs from Entity::calculateModelMatrix by " + std::to_string(error)).c_str());
+        return;
+    }
+
+    for(auto _ : state){
+        TransformBatch::calculateModelMatrices(in, &out[0], path);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["max_error"] = error;
+}
+
+// Odd counts exercise the scalar tail after the vector loop.
+BENCHMARK(BM_TransformGlm)->Arg(541)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_TransformBatch, scalar, TransformBatch::SCALAR)->Arg(541)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_TransformBatch, sse2, TransformBatch::SSE2)->Arg(541)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_TransformBatch, avx2, TransformBatch::AVX2)->Arg(541)->Arg(10000)->Arg(100000);
@@ -0,0 +1,89 @@
+// Stepping many cars through VehicleSim, scalar against AVX2. Items are car steps.
+// The AVX2 path is checked against the scalar one on a single step before it is timed.
+// Run with ./benchmarks --benchmark_filter=Vehicle
+
+#include <benchmark/benchmark.h>
+
+#include "../src/physics/VehicleSim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+#include <glm/glm.hpp>
+
+static const float STEP = 1.0f / 120.0f;
+// Velocity difference after one step, relative to the larger of 1 m/s and the speed. The paths use different
+// sine, cosine and arc tangent. Over many steps cars near a threshold, e.g. the stopping speed, can part ways.
+static const float MAX_ERROR = 1e-5f;
+
+static float randomRange(float min, float max){
+    return min + (max - min) * (rand() / float(RAND_MAX));
+}
+
+static VehicleSim makeCars(size_t count){
+    srand(1);
+    VehicleSim sim;
+    sim.reserve(count);
+    for(size_t i = 0; i < count; i++){
+        VehicleParams params;
+        params.mass *= randomRange(0.8f, 1.2f);
+        params.engineForce *= randomRange(0.8f, 1.2f);
+        sim.add(params, glm::vec2(randomRange(-500.0f, 500.0f), randomRange(-500.0f, 500.0f)),
+                randomRange(-2.0f * M_PI, 2.0f * M_PI));
+
+        VehicleInput input;
+        input.throttle = randomRange(0.0f, 1.0f) < 0.8f ? 1.0f : 0.0f;
+        input.brake = randomRange(0.0f, 1.0f) < 0.1f ? 1.0f : 0.0f;
+        input.steer = randomRange(-0.6f, 0.6f);
+        sim.setInput(i, input);
+    }
+    return sim;
+}
+
+// Cars get moving first, so the compared step covers turning, sliding and braking rather than standing starts.
+static float maxStepError(size_t count){
+    VehicleSim scalar = makeCars(count);
+    for(int step = 0; step < 120; step++){
+        scalar.step(STEP, VehicleSim::SCALAR);
+    }
+    VehicleSim avx2 = scalar;
+    scalar.step(STEP, VehicleSim::SCALAR);
+    avx2.step(STEP, VehicleSim::AVX2);
+
+    float worst = 0.0f;
+    for(size_t i = 0; i < count; i++){
+        glm::vec2 expected = scalar.getVelocity(i);
+        float error = glm::length(avx2.getVelocity(i) - expected) / std::max(1.0f, glm::length(expected));
+        worst = std::max(worst, error);
+    }
+    return worst;
+}
+
+static void BM_VehicleSim(benchmark::State& state, VehicleSim::Path path){
+    if(path > VehicleSim::getBestPath()){
+        state.SkipWithError("not supported by this CPU");
+        return;
+    }
+    float error = 0.0f;
+    if(path != VehicleSim::SCALAR){
+        error = maxStepError(state.range(0));
+        if(error > MAX_ERROR){
+            state.SkipWithError(("differs from the scalar path by " + std::to_string(error)).c_str());
+            return;
+        }
+    }
+
+    VehicleSim sim = makeCars(state.range(0));
+    for(auto _ : state){
+        sim.step(STEP, path);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["max_error"] = error;
+}
+
+// Odd counts exercise the scalar tail, 100000 is above VehicleSim::PARALLEL_THRESHOLD.
+BENCHMARK_CAPTURE(BM_VehicleSim, scalar, VehicleSim::SCALAR)->Arg(541)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_VehicleSim, avx2, VehicleSim::AVX2)->Arg(541)->Arg(10000)->Arg(100000);
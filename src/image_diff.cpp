@@ -0,0 +1,128 @@
+// Golden image check: compares every PNG in a reference directory with the image of the same name rendered by
+// ./Lab_4 --golden-views, and writes a diff image for each one that does not match. Exits with 1 on any mismatch.
+//
+//     ./image_diff reference_dir actual_dir diff_dir [--threshold 0.1] [--max-differing 0.001]
+//
+// threshold is the perceptual difference (0 - 1) above which a pixel differs, max-differing the fraction of
+// differing pixels an image may have and still pass.
+
+#include "utils/ImageDiff.h"
+#include "utils/ImageWriter.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+// PNG files directly in the directory, sorted by name.
+static std::vector<std::string> listImages(const std::string& directory){
+    std::vector<std::string> names;
+    DIR* dir = opendir(directory.c_str());
+    if(dir == NULL){
+        std::cerr << "[image_diff] Failed to open " << directory << std::endl;
+        exit(1);
+    }
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL){
+        std::string name = entry->d_name;
+        if(name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0){
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static bool loadRGB(const std::string& filename, int& width, int& height, std::vector<unsigned char>& rgb){
+    int channels;
+    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 3);
+    if(data == NULL) return false;
+    rgb.assign(data, data + (size_t)width * height * 3);
+    stbi_image_free(data);
+    return true;
+}
+
+int main(int argc, char** argv){
+    if(argc < 4){
+        std::cerr << "Usage: " << argv[0]
+                  << " reference_dir actual_dir diff_dir [--threshold 0.1] [--max-differing 0.001]" << std::endl;
+        return 1;
+    }
+    std::string referenceDir = argv[1];
+    std::string actualDir = argv[2];
+    std::string diffDir = argv[3];
+    float threshold = 0.1f;
+    double maxDiffering = 0.001;
+    for(int i = 4; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--threshold" && i + 1 < argc){
+            threshold = (float)atof(argv[++i]);
+        }
+        else if(arg == "--max-differing" && i + 1 < argc){
+            maxDiffering = atof(argv[++i]);
+        }
+    }
+
+    std::vector<std::string> names = listImages(referenceDir);
+    if(names.empty()){
+        std::cerr << "[image_diff] No reference images in " << referenceDir << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    std::vector<unsigned char> reference, actual, diff;
+    for(size_t i = 0; i < names.size(); i++){
+        int referenceWidth, referenceHeight, width, height;
+        if(!loadRGB(referenceDir + "/" + names[i], referenceWidth, referenceHeight, reference)){
+            std::cerr << "[image_diff] Failed to read " << referenceDir + "/" + names[i] << std::endl;
+            return 1;
+        }
+        if(ImageDiff::isUniform(referenceWidth, referenceHeight, reference, threshold)){
+            std::cerr << "[image_diff] Reference " << referenceDir + "/" + names[i]
+                      << " is a single colour, it was not rendered properly" << std::endl;
+            return 1;
+        }
+        if(!loadRGB(actualDir + "/" + names[i], width, height, actual)){
+            std::cout << "FAIL " << names[i] << ": not rendered" << std::endl;
+            failures++;
+            continue;
+        }
+        if(width != referenceWidth || height != referenceHeight){
+            std::cout << "FAIL " << names[i] << ": " << width << "x" << height << ", reference is "
+                      << referenceWidth << "x" << referenceHeight << std::endl;
+            failures++;
+            continue;
+        }
+        if(ImageDiff::isUniform(width, height, actual, threshold)){
+            std::cout << "FAIL " << names[i] << ": the render is a single colour" << std::endl;
+            failures++;
+            continue;
+        }
+
+        ImageDiff::Result result = ImageDiff::compare(width, height, reference, actual, threshold, diff);
+        double fraction = (double)result.differingPixels / (double)result.totalPixels;
+        bool passed = fraction <= maxDiffering;
+        printf("%s %s: %zu of %zu pixels differ (%.4f%%), max difference %.3f\n", passed ? "PASS" : "FAIL",
+               names[i].c_str(), result.differingPixels, result.totalPixels, fraction * 100.0,
+               result.maxDifference);
+        if(passed) continue;
+
+        failures++;
+        mkdir(diffDir.c_str(), 0755);   // Fails harmlessly if it exists
+        std::string diffFilename = diffDir + "/" + names[i];
+        if(!ImageWriter::writePNG(diffFilename, width, height, diff)){
+            std::cerr << "[image_diff] Failed to write " << diffFilename << std::endl;
+            return 1;
+        }
+    }
+    printf("%d of %zu images differ from the references\n", failures, names.size());
+    return failures == 0 ? 0 : 1;
+}
@@ -1,7 +1,10 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <sys/stat.h>
  
 #include <stb_image.h>
 
@@ -13,17 +16,38 @@
 #include "utils/Loader.h"
 #include "utils/GameTime.h"
 #include "utils/InputState.h"
+#include "utils/InputLog.h"
 #include "utils/FrameBuffer.h"
+#include "utils/GpuTimer.h"
+#include "utils/GLCallCounter.h"
+#include "utils/HeadlessContext.h"
+#include "utils/ImageDiff.h"
+#include "utils/ImageWriter.h"
+#include "utils/RenderStats.h"
+#include "utils/AllocationCounter.h"
+#include "utils/BenchmarkReport.h"
+#include "utils/Arena.h"
+#include "utils/Pool.h"
+#include "utils/Profiler.h"
 
 #include "objects/Entity.h"
+#include "objects/EntityStore.h"
+#include "objects/SceneGraph.h"
+#include "objects/SceneFile.h"
 #include "objects/Player.h"
 #include "objects/Light.h"
 #include "objects/Terrain.h"
+#include "objects/TerrainStreamer.h"
 #include "objects/Camera.h"
+#include "objects/Traffic.h"
+
+#include "physics/CollisionWorld.h"
 
 #include "renderers/EntityRenderer.h"
 #include "renderers/TerrainRenderer.h"
 #include "renderers/SkyboxRenderer.h"
+#include "renderers/StaticBatcher.h"
+#include "renderers/HudRenderer.h"
 
 unsigned int SCR_WIDTH = 800;
 unsigned int SCR_HEIGHT = 600;
@@ -31,9 +55,15 @@ const float SKYBOX_SIZE = 200.0f;
 
 // Data structure storing mouse input info
 InputState input;
+// Recording of the input, or a recording being replayed instead of the live input
+InputLog inputLog;
+bool dispatchingReplay = false;
 
 glm::mat4 projection;
 
+// Long lived scene objects are created here at load and all released together at exit
+Arena sceneArena;
+
 // Player must be declared here so that keyboard callbacks can be sent
 Player* player;
 
@@ -42,15 +72,21 @@ Player* player;
 enum CameraType {
     tracking, // Camera that shows driver perspective
     moving, // Moves past the car
-    standing // Camera standing on the ground
+    standing, // Camera standing on the ground
+    scripted // Flies a fixed path over the map, for benchmarks
 };
 CameraType cameraType = tracking;
 Camera* trackingCamera;
 Camera* movingCamera;
 Camera* staticCamera;
+Camera* scriptedCamera = NULL;
 
 //EntityRenderer* renderer;
 //TerrainRenderer* terrainRenderer;
+// Both skyboxes are loaded once, the day / night switch only changes which one is drawn
+Pool<SkyboxRenderer> skyboxPool(sceneArena, 2);
+PoolHandle<SkyboxRenderer> daySkyboxHandle;
+PoolHandle<SkyboxRenderer> nightSkyboxHandle;
 SkyboxRenderer* skyboxRenderer; // global to enable skybox switch in key callback
 std::vector<std::string> daySkybox = std::vector<std::string>{
     "../res/textures/hw_sahara/sahara_left.tga",
@@ -69,15 +105,84 @@ std::vector<std::string> nightSkybox = std::vector<std::string>{
         "../res/textures/ame_nebula/purplenebula_back.tga"
 };
 
-Light* skyLight;
-Light* headlight;
-Light* sheriffLight;
+// Benchmark and headless runs place the props and cars the same way every time, and simulate frames of a fixed
+// length, so they draw the same frames every time
+const uint32_t FIXED_SEED = 1;
+const double FIXED_FRAME_DT = 1.0 / 60.0;
+const size_t BENCHMARK_WARM_UP_FRAMES = 60;
+
+// Views of the fixed scene saved by --golden-views, for comparing with the reference images. Eye and target are
+// heightmap pixels at a height above the terrain, except the first view, which is the chase camera behind the car.
+struct GoldenView {
+    const char* name;
+    int eyeX, eyeY;
+    float eyeHeight;
+    int targetX, targetY;
+    float targetHeight;
+    bool phong;
+};
+const GoldenView GOLDEN_VIEWS[] = {
+        {"car", 0, 0, 0.0f, 0, 0, 0.0f, true},
+        {"track_corner", 300, 300, 6.0f, 226, 250, 0.0f, true},
+        {"track_corner_gouraud", 300, 300, 6.0f, 226, 250, 0.0f, false},
+        {"traffic", 790, 430, 4.0f, 850, 500, 0.0f, true},
+        {"overview", 200, 200, 120.0f, 512, 512, 0.0f, true},
+        {"horizon", 512, 900, 3.0f, 512, 100, 20.0f, true}
+};
+
+// Barrels on the corners of the track, as heightmap pixel x, y pairs. The AI traffic laps a track through them.
+const std::vector<int> TRACK_BARREL_PIXELS = {
+        263, 262, 226, 250, 209, 273,
+        213, 299, 342, 717, 329, 734,
+        326, 751, 354, 755, 372, 754,
+        750, 400, 765, 396, 748, 381,
+        828, 480, 842, 476, 854, 478,
+        852, 500, 852, 521, 842, 547,
+        772, 402
+};
+
+// Same as the number of lights the shaders take
+const size_t MAX_LIGHTS = 10;
+Pool<Light> lightPool(sceneArena, MAX_LIGHTS);
+PoolHandle<Light> skyLight;
+PoolHandle<Light> headlight;
+PoolHandle<Light> sheriffLight;
 float headlightPitch;
 float headlightYaw;
 std::vector<Light*> lights;
 
+// Transform hierarchy, the car lights hang off the player's node
+SceneGraph scene;
+SceneNode playerNode;
+SceneNode headlightNode;
+SceneNode sheriffNode;
+
 bool use_fog = true;
 bool use_phong = true;
+bool use_horizon_culling = false;
+bool use_static_batching = true;
+bool leave_ruts = false;
+bool crater_requested = false;
+
+// GPU time of each pass in renderScene, read back a few frames later
+GpuTimer* gpuTimer;
+
+// CPU trace captures, started with --profile or F9
+const int PROFILE_HOTKEY_FRAMES = 300;
+std::string profileFilename = "profile.json";
+
+// Performance overlay, toggled with H. Times are the previous frame's, the current one is still being drawn.
+const int HUD_HISTORY = 120;
+const float HUD_GRAPH_MAX_MS = 100.0f / 3.0f;
+bool show_hud = false;
+struct HudTimes {
+    float frameMs[HUD_HISTORY];     // Rings of the last frames, oldest at next
+    float gpuMs[HUD_HISTORY];       // Sum of the passes
+    int next;
+    double sectionSeconds[BenchmarkReport::SECTION_COUNT];
+    double passSeconds[GpuTimer::PASS_COUNT];   // Latest result of each pass
+};
+HudTimes hudTimes;
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
@@ -88,23 +193,136 @@ void mouse_pos_callback(GLFWwindow* window, double x, double y);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
 void setProjection(int winX, int winY);
-void renderScene(const std::vector<Entity*>& entities, const std::vector<Light*>& lights, Terrain* terrain,
-                 SkyboxRenderer& skyboxRenderer, EntityRenderer& entityRenderer, TerrainRenderer& terrainRenderer,
-                 const glm::mat4& projection);
+void renderScene(const EntityStore& entities, const StaticBatcher& staticBatcher, const Traffic* traffic,
+                 const std::vector<Light*>& lights, Terrain* terrain, SkyboxRenderer& skyboxRenderer,
+                 EntityRenderer& entityRenderer, TerrainRenderer& terrainRenderer, const glm::mat4& projection);
 
 void setHeadlightAngles(GLFWwindow* window, int key, int scancode, int action, int mods);
-void updateHeadlightsDirections();
+void updateHeadlightNode();
 void createSunAndPushBack();
 void createNightLightAndPushBack();
 void createSheriffLightAndPushBack();
-
-GLFWwindow* initWindow();
-
- int main()
+void removeLight(PoolHandle<Light>& handle);
+void placeRandomProps(EntityStore& entities, Terrain* terrain, const std::vector<Model*>& propModels);
+void replayEvents(GLFWwindow* window);
+Traffic* createTraffic(Model* model, Terrain* terrain, size_t count);
+void addPropColliders(CollisionWorld& collisions, const EntityStore& entities);
+void resolveCollisions(CollisionWorld& collisions, Player* player, Traffic* traffic);
+void renderGoldenViews(const std::string& directory, const EntityStore& entities, const StaticBatcher& staticBatcher,
+                       const Traffic* traffic, Terrain* terrain, EntityRenderer& entityRenderer,
+                       TerrainRenderer& terrainRenderer, FrameBuffer* renderTarget);
+void updateHudTimes(const double sectionSeconds[BenchmarkReport::SECTION_COUNT]);
+void drawHud(HudRenderer& hud, const RenderStats& stats);
+
+GLFWwindow* initWindow(bool vsync);
+void initGLState();
+
+ int main(int argc, char** argv)
  {
-    GLFWwindow* window = initWindow();
+    // Optional large world, streamed in tiles: ./Lab_4 --world ../res/terrain/world/world.txt
+    // Fixed scene instead of random props: ./Lab_4 --scene scene.wws, made with ./Lab_4 --export-scene scene.wws
+    // Number of AI cars on the track: ./Lab_4 --traffic 200, 0 for none
+    // Input saved for replaying the same drive: ./Lab_4 --record drive.wwi, then ./Lab_4 --replay drive.wwi
+    // Timed flight over the map, without vsync: ./Lab_4 --benchmark 2000 [--benchmark-report report.json]
+    // No window, through EGL: ./Lab_4 --headless [--frames 100] [--dump-frames out/frame], with either of the above
+    // Fixed views for the golden image test, then exit: ./Lab_4 --headless --golden-views out/golden
+    // CPU trace of loading and the first frames: ./Lab_4 --profile 300 [--profile-report profile.json], F9 later on
+    // Performance overlay from the start, e.g. in dumped frames: ./Lab_4 --hud, H toggles it
+    std::string worldManifest;
+    std::string sceneFilename;
+    std::string exportFilename;
+    std::string recordFilename;
+    std::string replayFilename;
+    std::string reportFilename = "benchmark.json";
+    int benchmarkFrames = 0;
+    bool headlessMode = false;
+    int maxFrames = 0;
+    std::string dumpPrefix;
+    std::string goldenDirectory;
+    int trafficCount = 50;
+    int profileFrames = 0;
+    for(int i = 1; i < argc; i++){
+        if(std::string(argv[i]) == "--world" && i + 1 < argc){
+            worldManifest = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--scene" && i + 1 < argc){
+            sceneFilename = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--export-scene" && i + 1 < argc){
+            exportFilename = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--record" && i + 1 < argc){
+            recordFilename = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--replay" && i + 1 < argc){
+            replayFilename = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--benchmark" && i + 1 < argc){
+            benchmarkFrames = std::max(1, atoi(argv[++i]));
+        }
+        else if(std::string(argv[i]) == "--benchmark-report" && i + 1 < argc){
+            reportFilename = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--headless"){
+            headlessMode = true;
+        }
+        else if(std::string(argv[i]) == "--frames" && i + 1 < argc){
+            maxFrames = std::max(1, atoi(argv[++i]));
+        }
+        else if(std::string(argv[i]) == "--dump-frames" && i + 1 < argc){
+            dumpPrefix = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--golden-views" && i + 1 < argc){
+            goldenDirectory = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--traffic" && i + 1 < argc){
+            trafficCount = std::max(0, atoi(argv[++i]));
+        }
+        else if(std::string(argv[i]) == "--profile" && i + 1 < argc){
+            profileFrames = std::max(1, atoi(argv[++i]));
+        }
+        else if(std::string(argv[i]) == "--profile-report" && i + 1 < argc){
+            profileFilename = argv[++i];
+        }
+        else if(std::string(argv[i]) == "--hud"){
+            show_hud = true;
+        }
+    }
+
+    PROFILE_THREAD_NAME("main");
+    if(profileFrames > 0) {
+        Profiler::getProfiler()->startCapture(profileFrames, profileFilename);
+    }
 
-    srand(time(NULL));
+    bool benchmarking = benchmarkFrames > 0;
+    // Headless runs draw into a frame buffer and stop by themselves, after one frame unless told otherwise
+    HeadlessContext headless;
+    GLFWwindow* window = NULL;
+    if(headlessMode){
+        headless.create(SCR_WIDTH, SCR_HEIGHT);
+        initGLState();
+        if(maxFrames == 0 && !benchmarking && replayFilename.empty()) maxFrames = 1;
+    }
+    else {
+        window = initWindow(!benchmarking);
+    }
+    gpuTimer = new GpuTimer();
+#ifdef USE_GL_CALL_COUNTER
+    GLCallCounter::install();
+#endif
+    bool fixedFrames = benchmarking || headlessMode || !goldenDirectory.empty();
+
+    // A replay places the props and cars with the recording's seed, benchmark and headless runs always with the
+    // same one
+    uint32_t seed = fixedFrames ? FIXED_SEED : (uint32_t)time(NULL);
+    if(!replayFilename.empty()){
+        inputLog.startReplay(replayFilename);
+        seed = inputLog.getSeed();
+    }
+    else if(!recordFilename.empty()){
+        inputLog.startRecording(recordFilename, seed);
+    }
+    srand(seed);
 
     // Create Terrain using blend map, height map and all of the remaining texture components.
     std::vector<std::string> terrainImages = {
@@ -113,149 +331,357 @@ GLFWwindow* initWindow();
             "../res/terrain/sand.jpeg",
             "../res/terrain/mud.jpg"
     };
-    Terrain* terrain = Terrain::loadTerrain(terrainImages,
-            "../res/terrain/heightmap.png");
-    // Moves the terrain model to be centered about the origin.
-    terrain->setPosition(glm::vec3(-Terrain::TERRAIN_SIZE/2, 0.0f, -Terrain::TERRAIN_SIZE/2));
+    Terrain* terrain;
+    TerrainStreamer* streamer = NULL;
+    if(worldManifest.empty()){
+        terrain = Terrain::loadTerrain(terrainImages,
+                "../res/terrain/heightmap.png");
+        // Moves the terrain model to be centered about the origin.
+        terrain->setPosition(glm::vec3(-Terrain::TERRAIN_SIZE/2, 0.0f, -Terrain::TERRAIN_SIZE/2));
+    }
+    else {
+        std::vector<GLuint> textures;
+        for(size_t i = 0; i < terrainImages.size(); i++){
+            textures.push_back(Loader::getLoader()->loadTexture(terrainImages[i]));
+        }
+        streamer = new TerrainStreamer(worldManifest, textures);
+        terrain = streamer;
+    }
     TerrainRenderer* terrainRenderer = new TerrainRenderer();
 
-    // Vector to hold all of the world entities.
-    std::vector<Entity*> entities;
+    // All of the world entities, props are stored by value and only the player is updated each frame.
+    EntityStore entities;
 
     Model playerModel = Loader::getLoader()->loadModel("../res/objects/mustang_shelby_gt500_1967/mustang.obj");
-    Model wagonModel = Loader::getLoader()->loadModel("../res/objects/wild_west_wagon/wild_west_wagon.obj");
-    Model barrelModel = Loader::getLoader()->loadModel("../res/objects/barrel/barrel.obj");
-    Model horseModel = Loader::getLoader()->loadModel("../res/objects/horse/horse.obj");
-    Model windmillModel = Loader::getLoader()->loadModel("../res/objects/wooden_windmill/windmill.obj");
-    Model bisonCraniumModel = Loader::getLoader()->loadModel("../res/objects/baby_bison_cranium/bison_cranium.obj");
-    Model woodenHouseModel = Loader::getLoader()->loadModel("../res/objects/wooden_house/wooden_house.obj");
+
+    // Models the props are made from, a scene file names its own
+    SceneFile sceneFile;
+    std::vector<std::string> propModelFiles;
+    if(sceneFilename.empty()){
+        propModelFiles = {
+            "../res/objects/wild_west_wagon/wild_west_wagon.obj",
+            "../res/objects/barrel/barrel.obj",
+            "../res/objects/wooden_windmill/windmill.obj",
+            "../res/objects/horse/horse.obj",
+            "../res/objects/baby_bison_cranium/bison_cranium.obj",
+            "../res/objects/wooden_house/wooden_house.obj"
+        };
+    }
+    else {
+        sceneFile.load(sceneFilename);
+        for(size_t i = 0; i < sceneFile.getModelCount(); i++){
+            propModelFiles.push_back(sceneFile.getModelPath(i));
+        }
+    }
+    std::vector<Model*> propModels;
+    for(size_t i = 0; i < propModelFiles.size(); i++){
+        propModels.push_back(sceneArena.create<Model>(Loader::getLoader()->loadModel(propModelFiles[i])));
+    }
 
     // Create the player object, scaling for the model, and setting its position in the world to somewhere interesting.
-    player = new Player(&playerModel, terrain, true);
+    player = sceneArena.create<Player>(&playerModel, terrain, true);
     player->setScale(glm::vec3(0.1f, 0.1f, 0.1f));
-    player->setPosition(terrain->getPositionFromPixel(300, 400));
-    entities.push_back(player);
+    glm::vec3 spawnPosition;
+    float spawnRotation;
+    if(!sceneFilename.empty() && sceneFile.getSpawn(SceneFile::PLAYER_SPAWN, spawnPosition, spawnRotation)){
+        player->setPosition(spawnPosition);
+        player->setRotationY(spawnRotation);
+    }
+    else {
+        player->setPosition(terrain->getPositionFromPixel(300, 400));
+        player->placeBottomEdge(terrain->getHeight(player->getPosition().x, player->getPosition().z));
+    }
+    entities.add(player);
+
+    playerNode = scene.createNode();
+    scene.follow(playerNode, player);
 
     // Initialisation of camera, projection matrix
     setProjection(SCR_WIDTH, SCR_HEIGHT);
-    trackingCamera = new TrackingCamera(player);
-    movingCamera = new PlayerCamera(player);
-    staticCamera = new StaticCamera(player->getPosition());
+    trackingCamera = sceneArena.create<TrackingCamera>(player);
+    movingCamera = sceneArena.create<PlayerCamera>(player);
+    glm::vec3 cameraPosition = player->getPosition();
+    if(!sceneFilename.empty()){
+        sceneFile.getSpawn(SceneFile::CAMERA_SPAWN, cameraPosition, spawnRotation);
+    }
+    staticCamera = sceneArena.create<StaticCamera>(cameraPosition);
+    if(benchmarking){
+        // Loop around the middle of the map, over the track and past most of the props, as heightmap pixels
+        const int FLIGHT_PIXELS[] = {200, 220, 520, 160, 860, 260, 880, 700, 520, 880, 160, 720};
+        std::vector<glm::vec2> flightPath;
+        for(size_t i = 0; i < sizeof(FLIGHT_PIXELS) / sizeof(FLIGHT_PIXELS[0]); i+= 2){
+            glm::vec3 point = terrain->getPositionFromPixel(FLIGHT_PIXELS[i], FLIGHT_PIXELS[i+1]);
+            flightPath.push_back(glm::vec2(point.x, point.z));
+        }
+        scriptedCamera = sceneArena.create<PathCamera>(terrain, flightPath, 12.0f, 20.0f);
+        cameraType = scripted;
+    }
 
     // Lights
+    lights.reserve(MAX_LIGHTS);
     createSunAndPushBack();
 
-    headlight = new Light();
-    headlight->position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-    headlight->specular = glm::vec3(0.8f, 0.8f, 0.4f);
-    headlight->diffuse = glm::vec3(0.8f, 0.8f, 0.4f);
-    headlight->coneDirection = glm::vec3(0.0f, 0.0f, 0.0f);
-    headlight->coneAngle = (float)M_PI/8.0f;
-    headlight->radius = 5.0f;
+    headlight = lightPool.create();
+    Light* car = lightPool.get(headlight);
+    car->position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    car->specular = glm::vec3(0.8f, 0.8f, 0.4f);
+    car->diffuse = glm::vec3(0.8f, 0.8f, 0.4f);
+    car->coneDirection = glm::vec3(0.0f, 0.0f, 0.0f);
+    car->coneAngle = (float)M_PI/8.0f;
+    car->radius = 5.0f;
     headlightYaw = (float)M_PI/2.0f;
     headlightPitch = 0.0f;
-    lights.push_back(headlight);
+    lights.push_back(car);
+    // Shines along the car's +z axis, turned by the headlight angles
+    headlightNode = scene.createNode(playerNode);
+    scene.attachLight(headlightNode, car, glm::vec3(0.0f, 0.0f, 1.0f));
+    updateHeadlightNode();
+    sheriffNode = scene.createNode(playerNode);
+
+    if(sceneFilename.empty()){
+        placeRandomProps(entities, terrain, propModels);
+    }
+    else {
+        // World lights from the file, a directional one takes the place of the sun
+        for(size_t i = 0; i < sceneFile.getLightCount(); i++){
+            PoolHandle<Light> handle = lightPool.create(sceneFile.getLight(i));
+            if(lightPool.get(handle)->position.w == 0.0f){
+                removeLight(skyLight);
+                skyLight = handle;
+            }
+            lights.push_back(lightPool.get(handle));
+        }
+        sceneFile.addProps(entities, propModels);
+    }
 
-    // Adds entities to random positions on the map
-    const size_t RAND_ENTITIES = 500;
-    for(size_t i = 0; i < RAND_ENTITIES; i++){
-        Entity* ent;
-        int selection = rand() % 6;
-        switch(selection) {
-            case 0:
-                ent = new Entity(&wagonModel);
-                ent->setScale(glm::vec3(0.1f, 0.1f, 0.1f));
-                break;
-            case 1:
-                ent = new Entity(&barrelModel);
-                ent->setScale(glm::vec3(0.1f, 0.1f, 0.1f));
-                break;
-            case 2:
-                ent = new Entity(&windmillModel);
-                ent->setScale(glm::vec3(0.005f, 0.005f, 0.005f));
-                break;
-            case 3:
-                ent = new Entity(&horseModel);
-                ent->setScale(glm::vec3(0.001f, 0.001f, 0.001f));
-                break;
-            case 4:
-                ent = new Entity(&bisonCraniumModel);
-                ent->setScale(glm::vec3(0.05f, 0.05f, 0.05f));
-                break;
-            case 5:
-                ent = new Entity(&woodenHouseModel);
-                ent->setScale(glm::vec3(0.005f, 0.005f, 0.005f));
-                break;
-        }
-        ent->setPosition(terrain->getPositionFromPixel(rand() % 1024, rand() % 1024));
-        entities.push_back(ent);
-    }
-
-     // Set of pre calculated barrel positions on corners of the track
-     std::vector<int> barrelPositions = {
-             263, 262, 226, 250, 209, 273,
-             213, 299, 342, 717, 329, 734,
-             326, 751, 354, 755, 372, 754,
-             750, 400, 765, 396, 748, 381,
-             828, 480, 842, 476, 854, 478,
-             852, 500, 852, 521, 842, 547,
-             772, 402
-     };
-
-     // Creates barrels from the positions and adds them.
-     for(size_t i = 0; i < barrelPositions.size(); i+= 2){
-         Entity* barrel = new Entity(&barrelModel);
-         barrel->setPosition(terrain->getPositionFromPixel(barrelPositions[i], barrelPositions[i+1]));
-         barrel->setScale(glm::vec3(0.1f, 0.1f, 0.1f));
-         entities.push_back(barrel);
-     }
+    if(!exportFilename.empty()){
+        std::vector<Light*> worldLights;
+        worldLights.push_back(lightPool.get(skyLight));
+        std::vector<SceneFile::SpawnRecord> spawns;
+        spawns.push_back(SceneFile::makeSpawn(SceneFile::PLAYER_SPAWN, player->getPosition(), player->getRotationY()));
+        spawns.push_back(SceneFile::makeSpawn(SceneFile::CAMERA_SPAWN, cameraPosition, 0.0f));
+        SceneFile::save(exportFilename, entities, propModelFiles, propModels, worldLights, spawns);
+        std::cout << "[main] Scene with " << entities.size() - 1 << " props written to " << exportFilename << std::endl;
+        glfwTerminate();
+        return 0;
+    }
 
-    // Goes through each entity and aligns its bottom edge with the terrain at that position.
-    for(size_t i = 0; i < entities.size(); i++){
-        entities[i]->placeBottomEdge(terrain->getHeight(entities[i]->getPosition().x, entities[i]->getPosition().z));
+    // AI cars share the player's model and are drawn as instances of it
+    Traffic* traffic = NULL;
+    if(trafficCount > 0){
+        traffic = createTraffic(&playerModel, terrain, trafficCount);
     }
 
-    skyboxRenderer = new SkyboxRenderer(daySkybox, SKYBOX_SIZE);
+    // Props block the player's car, the cars are added again every step
+    CollisionWorld collisions;
+    addPropColliders(collisions, entities);
+
+    // Props never move once placed, so their meshes are merged into a few draws per map cell.
+    StaticBatcher* staticBatcher = new StaticBatcher();
+    staticBatcher->build(entities);
+    bool batching = use_static_batching;
+
+    daySkyboxHandle = skyboxPool.create(daySkybox, SKYBOX_SIZE);
+    nightSkyboxHandle = skyboxPool.create(nightSkybox, SKYBOX_SIZE);
+    skyboxRenderer = skyboxPool.get(daySkyboxHandle);
     EntityRenderer* entityRenderer = new EntityRenderer();
+    HudRenderer* hudRenderer = new HudRenderer();
+
+    double lastTitleUpdate = GameTime::getClock();
+    int framesSinceTitleUpdate = 0;
+    double replayStart = GameTime::getClock();
+    int replayFrames = 0;
+    BenchmarkReport report(BENCHMARK_WARM_UP_FRAMES);
+    std::vector<unsigned char> pixels;
+    report.reserve(benchmarkFrames);
+
+    // From here on, terrain queries on tiles still being read must not stall the frame. Golden views are set up
+    // inside the loop and still need the real heights.
+    if(streamer && goldenDirectory.empty()) {
+        streamer->setWaitForTiles(false);
+    }
 
-    while (!glfwWindowShouldClose(window)) {
-        GameTime::getGameTime()->update();
-        if(cameraType == tracking) {
-            trackingCamera->update(input);
+    int frameIndex = 0;
+    while (window == NULL || !glfwWindowShouldClose(window)) {
+        double frameStart = GameTime::getClock();
+        unsigned long long allocationsBefore = AllocationCounter::getAllocationCount();
+        GameTime* gameTime = GameTime::getGameTime();
+        if(inputLog.isReplaying()) {
+            double frameDt;
+            if(!inputLog.readFrame(frameDt)) break;
+            gameTime->advance(frameDt);
+            replayFrames++;
         }
-        else if(cameraType == standing) {
-            staticCamera->update(input);
+        else if(fixedFrames) {
+            gameTime->advance(FIXED_FRAME_DT);
         }
         else {
-            movingCamera->update(input);
+            gameTime->update();
+        }
+        if(inputLog.isRecording()) {
+            inputLog.recordFrame(gameTime->getExactFrameDt());
+        }
+        RenderStats::getRenderStats()->reset();
+
+        // Fixed rate simulation, then everything is drawn part way into the latest step
+        while(gameTime->step()) {
+            PROFILE_SCOPE("fixed step");
+            entities.step();
+            if(traffic) traffic->step(gameTime->getDt());
+            resolveCollisions(collisions, player, traffic);
+        }
+        {
+            PROFILE_SCOPE("interpolate");
+            entities.interpolate(gameTime->getAlpha());
+            if(traffic) traffic->updateMatrices(gameTime->getAlpha());
+        }
+        double sceneStart = GameTime::getClock();
+        report.addSectionTime(BenchmarkReport::SIMULATION, sceneStart - frameStart);
+
+        {
+            PROFILE_SCOPE("camera");
+            if(cameraType == tracking) {
+                trackingCamera->update(input);
+            }
+            else if(cameraType == standing) {
+                staticCamera->update(input);
+            }
+            else if(cameraType == scripted) {
+                scriptedCamera->update(input);
+            }
+            else {
+                movingCamera->update(input);
+            }
+        }
+
+        if(batching != use_static_batching) {
+            if(use_static_batching) staticBatcher->build(entities);
+            else staticBatcher->release(entities);
+            batching = use_static_batching;
         }
 
-        for(size_t i = 0; i < entities.size(); i++){
-            entities[i]->update();
+        // Terrain deformation, uploaded once per frame for everything changed this frame
+        if(leave_ruts && (player->getThrottle() > 0.0f || player->getBrake() > 0.0f)) {
+            float yRot = player->getRotationY();
+            glm::vec3 side = glm::vec3(glm::cos(yRot), 0.0f, -glm::sin(yRot)) * 0.6f;
+            glm::vec3 leftWheel = player->getPosition() + side;
+            glm::vec3 rightWheel = player->getPosition() - side;
+            terrain->addRut(leftWheel.x, leftWheel.z, 0.3f, 0.08f);
+            terrain->addRut(rightWheel.x, rightWheel.z, 0.3f, 0.08f);
+        }
+        if(crater_requested) {
+            glm::vec3 target = player->getPosition() + player->getDirectionVector() * 4.0f;
+            terrain->addCrater(target.x, target.z, 2.0f, 0.75f);
+            crater_requested = false;
+        }
+        terrain->flushDeformations();
+
+        if(streamer) {
+            streamer->update(player->getPosition());
         }
 
-        // Update the postion of the car headlights
-        headlight->position = glm::vec4(player->getPosition(), 1.0f);
-        if(sheriffLight) {
-            sheriffLight->position = glm::vec4(player->getPosition(), 1.0f);
+        // Attached lights follow the car
+        if(lightPool.isValid(sheriffLight)) {
+            float sheriffLightYaw = (float) gameTime->getTime() * 3.0f;
+            scene.setLocal(sheriffNode, glm::rotate(glm::mat4(1.0f), -sheriffLightYaw, glm::vec3(0.0f, 1.0f, 0.0f)));
         }
-        updateHeadlightsDirections();
+        scene.update();
+        double renderStart = GameTime::getClock();
+        report.addSectionTime(BenchmarkReport::SCENE, renderStart - sceneStart);
 
         // Render entire scene
-        renderScene(entities, lights, terrain, *skyboxRenderer, *entityRenderer, *terrainRenderer, projection);
+        if(headlessMode) headless.bind();
+        if(!goldenDirectory.empty()) {
+            renderGoldenViews(goldenDirectory, entities, *staticBatcher, traffic, terrain, *entityRenderer,
+                              *terrainRenderer, headlessMode ? headless.getTarget() : NULL);
+            break;
+        }
+        renderScene(entities, *staticBatcher, traffic, lights, terrain, *skyboxRenderer, *entityRenderer,
+                    *terrainRenderer, projection);
+        if(show_hud) {
+            PROFILE_SCOPE("hud");
+            // The overlay's own GL calls would change the counts it shows
+            GLCallCounter::pause();
+            drawHud(*hudRenderer, *RenderStats::getRenderStats());
+            GLCallCounter::resume();
+        }
+        double presentStart = GameTime::getClock();
+        report.addSectionTime(BenchmarkReport::RENDER, presentStart - renderStart);
+        RenderStats::getRenderStats()->allocations =
+                (int)(AllocationCounter::getAllocationCount() - allocationsBefore);
+
+        // Frame rate and culling results in the window title, refreshed once a second
+        framesSinceTitleUpdate++;
+        if(window != NULL && GameTime::getClock() - lastTitleUpdate >= 1.0) {
+            RenderStats* stats = RenderStats::getRenderStats();
+            char title[160];
+            snprintf(title, sizeof(title),
+                     "The Wild West - %d FPS, terrain tiles %d/%d, %d draws, %d matrices, %d allocations",
+                     framesSinceTitleUpdate, stats->terrainTilesDrawn, stats->terrainTilesTotal, stats->drawCalls,
+                     stats->matricesRecomputed, stats->allocations);
+            glfwSetWindowTitle(window, title);
+            lastTitleUpdate = GameTime::getClock();
+            framesSinceTitleUpdate = 0;
+        }
+
+        if(!dumpPrefix.empty()) {
+            char filename[32];
+            snprintf(filename, sizeof(filename), "_%05d.png", frameIndex);
+            ImageWriter::readPixels(SCR_WIDTH, SCR_HEIGHT, pixels);
+            if(!ImageWriter::writePNG(dumpPrefix + filename, SCR_WIDTH, SCR_HEIGHT, pixels)) {
+                std::cerr << "[main] Failed to write " << dumpPrefix + filename << std::endl;
+                exit(1);
+            }
+        }
 
-        glFlush();
+        if(window != NULL) {
+            PROFILE_SCOPE("present");
+            glFlush();
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        else {
+            // Nothing is presented, wait for the frame to be drawn so it is timed like one
+            PROFILE_SCOPE("present");
+            glFinish();
+        }
+        if(inputLog.isReplaying()) {
+            replayEvents(window);
+        }
+        frameIndex++;
+
+        gpuTimer->endFrame();
+        for(int pass = 0; pass < GpuTimer::PASS_COUNT; pass++) {
+            if(gpuTimer->hasResult((GpuTimer::Pass)pass)) {
+                report.addGpuTime(GpuTimer::getPassName((GpuTimer::Pass)pass),
+                                  gpuTimer->getPassSeconds((GpuTimer::Pass)pass));
+            }
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        double frameEnd = GameTime::getClock();
+        report.addSectionTime(BenchmarkReport::PRESENT, frameEnd - presentStart);
+        const double sectionSeconds[BenchmarkReport::SECTION_COUNT] = {
+                sceneStart - frameStart, renderStart - sceneStart, presentStart - renderStart, frameEnd - presentStart};
+        updateHudTimes(sectionSeconds);
+        report.endFrame(frameEnd - frameStart, *RenderStats::getRenderStats());
+        Profiler::getProfiler()->endFrame();
+        if(benchmarking && report.getFrameCount() == (size_t)benchmarkFrames) {
+            report.write(reportFilename, seed, trafficCount, SCR_WIDTH, SCR_HEIGHT);
+            std::cout << "[main] Benchmark of " << benchmarkFrames << " frames written to " << reportFilename
+                      << std::endl;
+            break;
+        }
+        if(maxFrames > 0 && frameIndex == maxFrames) break;
     }
 
-    // Cleanup program, delete all the dynamic entities.
-    delete player;
-    for(size_t i = 0; i < entities.size(); i++){
-        delete entities[i];
+    if(inputLog.isReplaying()) {
+        double replayTime = GameTime::getClock() - replayStart;
+        std::cout << "[main] Replayed " << replayFrames << " frames in " << replayTime << " s, "
+                  << replayTime * 1000.0 / std::max(replayFrames, 1) << " ms per frame" << std::endl;
     }
+    inputLog.stopRecording();
 
+    // Cleanup program, the player and cameras go with the scene arena.
     glfwTerminate();
     return 0;
 }
@@ -275,20 +701,37 @@ void error_callback(int error, const char* description) {
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     // Terminate program if escape is pressed
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+        inputLog.stopRecording();
         glfwTerminate();
         exit(0);
     }
+
+    // Trace of the next frames, not part of the input so it also works during a replay
+    if(key == GLFW_KEY_F9 && action == GLFW_PRESS && !Profiler::isCapturing()) {
+        Profiler::getProfiler()->startCapture(PROFILE_HOTKEY_FRAMES, profileFilename);
+    }
+
+    // Performance overlay, also not part of the input
+    if(key == GLFW_KEY_H && action == GLFW_PRESS) {
+        show_hud = !show_hud;
+    }
+
+    // A replay ignores the live input, and a recording saves it
+    if(inputLog.isReplaying() && !dispatchingReplay) return;
+    if(inputLog.isRecording()) inputLog.recordKey(key, action, mods);
     
     // Day / night switch
     if(key == GLFW_KEY_C && action == GLFW_PRESS) {
         createNightLightAndPushBack();
         use_fog = false;
-        skyboxRenderer = new SkyboxRenderer(nightSkybox, SKYBOX_SIZE);
+        skyboxRenderer = skyboxPool.get(nightSkyboxHandle);
+        skyboxRenderer->enable();
     }
     if(key == GLFW_KEY_Z && action == GLFW_PRESS) {
         createSunAndPushBack();
         use_fog = true;
-        skyboxRenderer = new SkyboxRenderer(daySkybox, SKYBOX_SIZE);
+        skyboxRenderer = skyboxPool.get(daySkyboxHandle);
+        skyboxRenderer->enable();
     }
     if(key == GLFW_KEY_X && action == GLFW_PRESS) {
         skyboxRenderer->disable();
@@ -299,6 +742,24 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         use_fog = !use_fog;
     }
 
+    // Horizon occlusion culling of terrain tiles
+    if(key == GLFW_KEY_O && action == GLFW_PRESS) {
+        use_horizon_culling = !use_horizon_culling;
+    }
+
+    // Terrain deformation: tyre ruts on / off, crater in front of the car
+    if(key == GLFW_KEY_R && action == GLFW_PRESS) {
+        leave_ruts = !leave_ruts;
+    }
+    if(key == GLFW_KEY_V && action == GLFW_PRESS) {
+        crater_requested = true;
+    }
+
+    // Static batching of props on / off, to compare draw counts
+    if(key == GLFW_KEY_B && action == GLFW_PRESS) {
+        use_static_batching = !use_static_batching;
+    }
+
     // Phong / Gouraud switch
     if(key == GLFW_KEY_P && action == GLFW_PRESS) {
         use_phong = !use_phong;
@@ -320,13 +781,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
     // Sheriff switch
     if(key == GLFW_KEY_Q && action == GLFW_PRESS) {
-        if(!sheriffLight) {
+        if(!lightPool.isValid(sheriffLight)) {
             createSheriffLightAndPushBack();
         }
         else {
-            lights.erase(remove(lights.begin(), lights.end(), sheriffLight));
-            free(sheriffLight);
-            sheriffLight = NULL; // otherwise getting SEGV
+            removeLight(sheriffLight);
         }
     }
 
@@ -335,10 +794,14 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 }
 
 void mouse_pos_callback(GLFWwindow* window, double x, double y) {
+     if(inputLog.isReplaying() && !dispatchingReplay) return;
+     if(inputLog.isRecording()) inputLog.recordCursor(x, y);
      input.update((float) x, (float) y);
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset){
+     if(inputLog.isReplaying() && !dispatchingReplay) return;
+     if(inputLog.isRecording()) inputLog.recordScroll(xoffset, yoffset);
      input.updateScroll((float)xoffset, (float)yoffset);
      if(cameraType == standing)
          projection = glm::perspective(glm::radians(staticCamera->zoom),
@@ -346,6 +809,9 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset){
 }
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if(inputLog.isReplaying() && !dispatchingReplay) return;
+    if(inputLog.isRecording()) inputLog.recordMouseButton(button, action, mods);
+
     if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
         input.rMousePressed = true;
     }
@@ -360,13 +826,42 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
     }
 }
 
+// Sends the current frame's recorded events to the callbacks, as if the window had just delivered them.
+void replayEvents(GLFWwindow* window) {
+    InputLog::Event event;
+    dispatchingReplay = true;
+    while(inputLog.readEvent(event)) {
+        if(event.type == InputLog::KEY) {
+            key_callback(window, event.code, 0, event.action, event.mods);
+        }
+        else if(event.type == InputLog::CURSOR) {
+            mouse_pos_callback(window, event.x, event.y);
+        }
+        else if(event.type == InputLog::MOUSE_BUTTON) {
+            mouse_button_callback(window, event.code, event.action, event.mods);
+        }
+        else if(event.type == InputLog::SCROLL) {
+            scroll_callback(window, event.x, event.y);
+        }
+    }
+    dispatchingReplay = false;
+}
+
 void setProjection(int winX, int winY) {
     // float aspect = (float) winX / winY;
     // FOV angle is in radians
     projection = glm::perspective(M_PI/4.0, double(winX) / double(winY), 1.0, 800.0);
 }
 
-GLFWwindow* initWindow() {
+// State every context starts with, windowed or headless.
+void initGLState() {
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// Without vsync frames are presented as soon as they are drawn, so frame times show the real cost.
+GLFWwindow* initWindow(bool vsync) {
      glfwInit();
     glfwSetErrorCallback(error_callback);
     if (!glfwInit()) exit(1);
@@ -382,16 +877,14 @@ GLFWwindow* initWindow() {
         exit(1);
      }
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
+    glfwSwapInterval(vsync ? 1 : 0);
 
     if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
         std::cout << "Failed to initialize GLAD" << std::endl;
         exit(1);
     }
 
-    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
-    glEnable(GL_DEPTH_TEST);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    initGLState();
     //glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     glfwSetKeyCallback(window, key_callback);
@@ -429,71 +922,192 @@ void setHeadlightAngles(GLFWwindow* window, int key, int scancode, int action, i
     if (headlightYaw < (float) M_PI * -2.0f) {
         headlightYaw += (float) M_PI * 2.0f;
     }
+    updateHeadlightNode();
+}
+
+// Yaw of pi/2 points the headlights straight ahead, pitch tilts them up.
+void updateHeadlightNode() {
+    glm::mat4 local = glm::rotate(glm::mat4(1.0f), (float)M_PI/2.0f - headlightYaw, glm::vec3(0.0f, 1.0f, 0.0f));
+    local = glm::rotate(local, -headlightPitch, glm::vec3(1.0f, 0.0f, 0.0f));
+    scene.setLocal(headlightNode, local);
+}
+
+// Takes the light out of the scene and returns its slot to the pool, the handle is stale afterwards.
+void removeLight(PoolHandle<Light>& handle) {
+    Light* light = lightPool.get(handle);
+    if(light == NULL) return;
+    lights.erase(remove(lights.begin(), lights.end(), light), lights.end());
+    scene.detachLight(light);
+    lightPool.destroy(handle);
+    handle = PoolHandle<Light>();
+}
+
+void createSunAndPushBack() {
+    removeLight(skyLight);
+    skyLight = lightPool.create();
+    Light* sun = lightPool.get(skyLight);
+    sun->position = glm::vec4(-1.25*SKYBOX_SIZE/10, 2.5*SKYBOX_SIZE/10, 3*SKYBOX_SIZE/10, 0.0f); // w = 0 - directional
+    sun->specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    sun->diffuse = glm::vec3(0.5f, 0.5f, 0.5f);
+    sun->ambient = glm::vec3(0.2f, 0.2f, 0.2f);
+    lights.push_back(sun);
+}
+
+void createNightLightAndPushBack() {
+    removeLight(skyLight);
+    skyLight = lightPool.create();
+    Light* moon = lightPool.get(skyLight);
+    moon->position = glm::vec4(-1.25*SKYBOX_SIZE/10, 2.5*SKYBOX_SIZE/10, 3*SKYBOX_SIZE/10, 0.0f); // w = 0 - directional
+    moon->specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    moon->diffuse = glm::vec3(0.1f, 0.1f, 0.1f);
+    moon->ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+    lights.push_back(moon);
 }
 
-void updateHeadlightsDirections() {
-    float angle = headlightYaw - player->getRotationY();
+void createSheriffLightAndPushBack() {
+    sheriffLight = lightPool.create();
+    Light* sheriff = lightPool.get(sheriffLight);
+    sheriff->position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    sheriff->specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    sheriff->diffuse = glm::vec3(0.0f, 0.0f, 1.0f);
+    sheriff->coneDirection = glm::vec3(0.0f, 0.0f, 0.0f);
+    sheriff->coneAngle = (float)M_PI/8.0f;
+    sheriff->radius = 5.0f;
+    lights.push_back(sheriff);
+    // Spins about the car, see the main loop
+    scene.attachLight(sheriffNode, sheriff, glm::vec3(1.0f, 0.0f, 0.0f));
+}
 
-    glm::vec3 front;
-    front.x = cos(headlightPitch) * cos(angle);
-    front.y = sin(headlightPitch);
-    front.z = cos(headlightPitch) * sin(angle);
+// Scatters props over the map at random and lines the corners of the track with barrels.
+// propModels are the wagon, barrel, windmill, horse, bison cranium and wooden house, in that order.
+void placeRandomProps(EntityStore& entities, Terrain* terrain, const std::vector<Model*>& propModels) {
+    const glm::vec3 scales[] = {
+        glm::vec3(0.1f, 0.1f, 0.1f),
+        glm::vec3(0.1f, 0.1f, 0.1f),
+        glm::vec3(0.005f, 0.005f, 0.005f),
+        glm::vec3(0.001f, 0.001f, 0.001f),
+        glm::vec3(0.05f, 0.05f, 0.05f),
+        glm::vec3(0.005f, 0.005f, 0.005f)
+    };
+    Model* barrelModel = propModels[1];
 
-    headlight->coneDirection = glm::normalize(front);
+    // Adds entities to random positions on the map
+    const size_t RAND_ENTITIES = 500;
+    entities.reserve(RAND_ENTITIES + 64);
+    for(size_t i = 0; i < RAND_ENTITIES; i++){
+        int selection = rand() % 6;
+        glm::vec3 position = terrain->getPositionFromPixel(rand() % 1024, rand() % 1024);
+        EntityHandle ent = entities.add(propModels[selection], position, scales[selection]);
+        entities.placeBottomEdge(ent, terrain->getHeight(position.x, position.z));
+    }
 
-    if(sheriffLight) {
-        float sheriffLightYaw = (float) glfwGetTime() * 3.0f;// GameTime::getGameTime()->getTime();
-        glm::vec3 sheriffDir;
-        sheriffDir.x = cos(sheriffLightYaw);
-        sheriffDir.y = 0.0f;
-        sheriffDir.z = sin(sheriffLightYaw);
+    // Creates barrels from the positions and adds them.
+    // Each is aligned with its bottom edge on the terrain at that position.
+    for(size_t i = 0; i < TRACK_BARREL_PIXELS.size(); i+= 2){
+        glm::vec3 position = terrain->getPositionFromPixel(TRACK_BARREL_PIXELS[i], TRACK_BARREL_PIXELS[i+1]);
+        EntityHandle barrel = entities.add(barrelModel, position, glm::vec3(0.1f, 0.1f, 0.1f));
+        entities.placeBottomEdge(barrel, terrain->getHeight(position.x, position.z));
+    }
+}
 
-        sheriffLight->coneDirection = glm::normalize(sheriffDir);
+// Cars spread around the track through the barrel corners. Barrels within 80 pixels of a corner's first barrel
+// belong to that corner.
+Traffic* createTraffic(Model* model, Terrain* terrain, size_t count) {
+    std::vector<glm::vec3> barrels;
+    for(size_t i = 0; i < TRACK_BARREL_PIXELS.size(); i+= 2){
+        barrels.push_back(terrain->getPositionFromPixel(TRACK_BARREL_PIXELS[i], TRACK_BARREL_PIXELS[i+1]));
     }
+    float mergeDistance = 80.0f * Terrain::TERRAIN_SIZE / 1024.0f;
+    std::vector<glm::vec2> corners = Traffic::findTrackCorners(barrels, mergeDistance);
+    return new Traffic(model, terrain, corners, count, glm::vec3(0.1f, 0.1f, 0.1f));
 }
 
-void createSunAndPushBack() {
-    if(skyLight) {
-        lights.erase(remove(lights.begin(), lights.end(), skyLight));
-        free(skyLight);
-        skyLight = NULL; // otherwise getting SEGV
-    }
-    skyLight = new Light();
-    skyLight->position = glm::vec4(-1.25*SKYBOX_SIZE/10, 2.5*SKYBOX_SIZE/10, 3*SKYBOX_SIZE/10, 0.0f); // w = 0 - directional
-    skyLight->specular = glm::vec3(1.0f, 1.0f, 1.0f);
-    skyLight->diffuse = glm::vec3(0.5f, 0.5f, 0.5f);
-    skyLight->ambient = glm::vec3(0.2f, 0.2f, 0.2f);
-    lights.push_back(skyLight);
+// Every visible plain prop becomes a static box from its model's bounds.
+void addPropColliders(CollisionWorld& collisions, const EntityStore& entities) {
+    for(EntityHandle handle = 0; handle < entities.size(); handle++){
+        Model* model = entities.getModel(handle);
+        if(model == NULL || entities.hasBehaviour(handle)) continue;
+        if(entities.getFlags(handle) & EntityStore::HIDDEN) continue;
+        glm::vec3 min, max;
+        for(int dim = 0; dim < 3; dim++){
+            min[dim] = model->getRangeInDim(dim).first;
+            max[dim] = model->getRangeInDim(dim).second;
+        }
+        if(min.x > max.x) continue;     // No vertices
+        collisions.addStatic(OrientedBox::fromLocalBounds(min, max, entities.getPosition(handle),
+                entities.getScale(handle), entities.getRotation(handle).y));
+    }
+    collisions.buildStatic();
 }
 
-void createNightLightAndPushBack() {
-     if(skyLight) {
-         lights.erase(remove(lights.begin(), lights.end(), skyLight));
-         free(skyLight);
-         skyLight = NULL; // otherwise getting SEGV
-     }
-    skyLight = new Light();
-    skyLight->position = glm::vec4(-1.25*SKYBOX_SIZE/10, 2.5*SKYBOX_SIZE/10, 3*SKYBOX_SIZE/10, 0.0f); // w = 0 - directional
-    skyLight->specular = glm::vec3(1.0f, 1.0f, 1.0f);
-    skyLight->diffuse = glm::vec3(0.1f, 0.1f, 0.1f);
-    skyLight->ambient = glm::vec3(0.05f, 0.05f, 0.05f);
-    lights.push_back(skyLight);
- }
+// Pushes overlapping cars apart, after the step has moved them. Two cars share the push between them.
+void resolveCollisions(CollisionWorld& collisions, Player* player, Traffic* traffic) {
+    PROFILE_SCOPE("collisions");
+    collisions.clearDynamic();
+    int playerBody = collisions.addDynamic(player->getCollisionBox());
+    int firstCar = traffic ? traffic->addColliders(collisions) : 0;
+
+    const std::vector<CollisionWorld::Contact>& contacts = collisions.findContacts();
+    for(size_t i = 0; i < contacts.size(); i++){
+        const CollisionWorld::Contact& contact = contacts[i];
+        float share = contact.isStatic ? contact.depth : contact.depth * 0.5f;
+        if(contact.body == playerBody) player->resolveCollision(contact.normal, share);
+        else traffic->resolveCollision(contact.body - firstCar, contact.normal, share);
+        if(contact.isStatic) continue;
+        if(contact.other == playerBody) player->resolveCollision(-contact.normal, share);
+        else traffic->resolveCollision(contact.other - firstCar, -contact.normal, share);
+    }
+}
 
-void createSheriffLightAndPushBack() {
-    sheriffLight = new Light();
-    sheriffLight->position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-    sheriffLight->specular = glm::vec3(1.0f, 1.0f, 1.0f);
-    sheriffLight->diffuse = glm::vec3(0.0f, 0.0f, 1.0f);
-    sheriffLight->coneDirection = glm::vec3(0.0f, 0.0f, 0.0f);
-    sheriffLight->coneAngle = (float)M_PI/8.0f;
-    sheriffLight->radius = 5.0f;
-    lights.push_back(sheriffLight);
- }
+// Draws and saves every golden view as directory/<name>.png, in the day with the default settings.
+void renderGoldenViews(const std::string& directory, const EntityStore& entities, const StaticBatcher& staticBatcher,
+                       const Traffic* traffic, Terrain* terrain, EntityRenderer& entityRenderer,
+                       TerrainRenderer& terrainRenderer, FrameBuffer* renderTarget) {
+    mkdir(directory.c_str(), 0755);     // Fails harmlessly if it exists
+    Camera viewCamera;
+    Camera* previousScriptedCamera = scriptedCamera;
+    scriptedCamera = &viewCamera;
+    std::vector<unsigned char> pixels;
+    for(size_t i = 0; i < sizeof(GOLDEN_VIEWS) / sizeof(GOLDEN_VIEWS[0]); i++) {
+        const GoldenView& golden = GOLDEN_VIEWS[i];
+        if(i == 0) {
+            cameraType = tracking;
+        }
+        else {
+            glm::vec3 eye = terrain->getPositionFromPixel(golden.eyeX, golden.eyeY);
+            glm::vec3 target = terrain->getPositionFromPixel(golden.targetX, golden.targetY);
+            viewCamera.setPosition(glm::vec3(eye.x, terrain->getHeight(eye.x, eye.z) + golden.eyeHeight, eye.z));
+            viewCamera.look(glm::vec3(target.x, terrain->getHeight(target.x, target.z) + golden.targetHeight,
+                                      target.z));
+            cameraType = scripted;
+        }
+        use_phong = golden.phong;
+        // Bound again for every view, in case drawing the last one left something else bound
+        if(renderTarget != NULL) renderTarget->bind();
+        else glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        renderScene(entities, staticBatcher, traffic, lights, terrain, *skyboxPool.get(daySkyboxHandle),
+                    entityRenderer, terrainRenderer, projection);
+
+        std::string filename = directory + "/" + golden.name + ".png";
+        ImageWriter::readPixels(SCR_WIDTH, SCR_HEIGHT, pixels);
+        if(ImageDiff::isUniform(SCR_WIDTH, SCR_HEIGHT, pixels, 0.1f)) {
+            std::cerr << "[main] Golden view " << golden.name << " is a single colour, not writing it" << std::endl;
+            exit(1);
+        }
+        if(!ImageWriter::writePNG(filename, SCR_WIDTH, SCR_HEIGHT, pixels)) {
+            std::cerr << "[main] Failed to write " << filename << std::endl;
+            exit(1);
+        }
+    }
+    scriptedCamera = previousScriptedCamera;
+    use_phong = true;
+    std::cout << "[main] Golden views written to " << directory << std::endl;
+}
 
-void renderScene(const std::vector<Entity*>& entities, const std::vector<Light*>& lights, Terrain* terrain,
-        SkyboxRenderer& skybox, EntityRenderer& renderer, TerrainRenderer& terrainRenderer,
-        const glm::mat4& projection) {
+void renderScene(const EntityStore& entities, const StaticBatcher& staticBatcher, const Traffic* traffic,
+        const std::vector<Light*>& lights, Terrain* terrain, SkyboxRenderer& skybox, EntityRenderer& renderer,
+        TerrainRenderer& terrainRenderer, const glm::mat4& projection) {
+    PROFILE_SCOPE("renderScene");
     glDisable(GL_CLIP_DISTANCE0);
     glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
     glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
@@ -508,8 +1122,104 @@ void renderScene(const std::vector<Entity*>& entities, const std::vector<Light*>
     else if(cameraType == standing) {
         view = staticCamera->getViewMtx();
     }
+    else if(cameraType == scripted) {
+        view = scriptedCamera->getViewMtx();
+    }
 
+    gpuTimer->begin(GpuTimer::SKYBOX);
     skybox.render(view, projection);
-    renderer.render(entities, lights, view, projection, use_fog, use_phong);
-    terrainRenderer.render(terrain, lights, view, projection, use_fog);
- }
\ No newline at end of file
+    gpuTimer->end(GpuTimer::SKYBOX);
+    gpuTimer->begin(GpuTimer::ENTITIES);
+    renderer.render(entities, lights, view, projection, use_fog, use_phong, &staticBatcher);
+    gpuTimer->end(GpuTimer::ENTITIES);
+    if(traffic) {
+        gpuTimer->begin(GpuTimer::TRAFFIC);
+        renderer.renderInstances(traffic->getModel(), traffic->getMatrices(), lights, view, projection, use_fog,
+                                 use_phong);
+        gpuTimer->end(GpuTimer::TRAFFIC);
+    }
+    gpuTimer->begin(GpuTimer::TERRAIN);
+    terrainRenderer.render(terrain, lights, view, projection, use_fog, use_horizon_culling);
+    gpuTimer->end(GpuTimer::TERRAIN);
+ }
+
+// Adds the frame that just ended to the overlay's history.
+void updateHudTimes(const double sectionSeconds[BenchmarkReport::SECTION_COUNT]) {
+    float gpuMs = 0.0f;
+    for(int pass = 0; pass < GpuTimer::PASS_COUNT; pass++) {
+        if(gpuTimer->hasResult((GpuTimer::Pass)pass)) {
+            hudTimes.passSeconds[pass] = gpuTimer->getPassSeconds((GpuTimer::Pass)pass);
+        }
+        gpuMs += (float)(hudTimes.passSeconds[pass] * 1000.0);
+    }
+    for(int i = 0; i < BenchmarkReport::SECTION_COUNT; i++) {
+        hudTimes.sectionSeconds[i] = sectionSeconds[i];
+    }
+    hudTimes.frameMs[hudTimes.next] = GameTime::getGameTime()->getFrameDt() * 1000.0f;
+    hudTimes.gpuMs[hudTimes.next] = gpuMs;
+    hudTimes.next = (hudTimes.next + 1) % HUD_HISTORY;
+}
+
+// Counters in a panel in the top left corner, with the frame time history graphed underneath.
+void drawHud(HudRenderer& hud, const RenderStats& stats) {
+    const float SCALE = 2.0f;
+    const float MARGIN = 8.0f;
+    const float PADDING = 6.0f;
+    const float GRAPH_HEIGHT = 80.0f;
+    const glm::vec4 TEXT_COLOUR(1.0f, 1.0f, 1.0f, 1.0f);
+    const glm::vec4 FRAME_COLOUR(0.3f, 1.0f, 0.3f, 1.0f);
+    const glm::vec4 GPU_COLOUR(1.0f, 0.6f, 0.2f, 1.0f);
+    const char* SECTION_LABELS[BenchmarkReport::SECTION_COUNT] = {"SIM", "SCENE", "RENDER", "PRESENT"};
+
+    GameTime* gameTime = GameTime::getGameTime();
+    char text[640];
+    size_t length = 0;
+    length += snprintf(text + length, sizeof(text) - length, "%.0f FPS  %.2f MS\nCPU MS", gameTime->getFPS(),
+                       gameTime->getFrameDt() * 1000.0f);
+    for(int i = 0; i < BenchmarkReport::SECTION_COUNT && length < sizeof(text); i++) {
+        length += snprintf(text + length, sizeof(text) - length, "%s %s %.2f", i == 2 ? "\n      " : "",
+                           SECTION_LABELS[i], hudTimes.sectionSeconds[i] * 1000.0);
+    }
+    for(int pass = 0; pass < GpuTimer::PASS_COUNT && length < sizeof(text); pass++) {
+        length += snprintf(text + length, sizeof(text) - length, "%s %s %.2f",
+                           pass == 0 ? "\nGPU MS" : pass % 2 == 0 ? "\n      " : "",
+                           GpuTimer::getPassName((GpuTimer::Pass)pass), hudTimes.passSeconds[pass] * 1000.0);
+    }
+    if(length < sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length,
+                 "\nDRAWS %d  TRIS %lld\nENTITIES %d  CULLED %d\nTEXTURES %.1f MB\nBUFFERS %.1f MB\nLIGHTS %d/%d",
+                 stats.drawCalls, stats.triangles, stats.entitiesDrawn, stats.entitiesCulled,
+                 stats.textureBytes / (1024.0 * 1024.0), stats.bufferBytes / (1024.0 * 1024.0), (int)lights.size(),
+                 (int)MAX_LIGHTS);
+    }
+    length = strlen(text);
+    if(stats.glCallsCounted && length < sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length, "\nGL STATE %d  TEXTURES %d\n   UNIFORMS %d  REDUNDANT %d",
+                 stats.glStateChanges, stats.glTextureBinds, stats.glUniformCalls, stats.glRedundantBinds);
+    }
+    const char* GRAPH_LABEL = "FRAME / GPU MS, 0 TO 33";
+    int lines = 1;
+    for(const char* c = text; *c != '\0'; c++) {
+        if(*c == '\n') lines++;
+    }
+
+    float width = std::max(HudRenderer::textWidth(text, SCALE), HudRenderer::textWidth(GRAPH_LABEL, SCALE));
+    float textHeight = lines * HudRenderer::LINE_HEIGHT * SCALE;
+    float labelHeight = HudRenderer::LINE_HEIGHT * SCALE;
+    float graphTop = MARGIN + PADDING + textHeight + labelHeight;
+
+    hud.beginFrame(SCR_WIDTH, SCR_HEIGHT);
+    hud.rect(MARGIN, MARGIN, width + 2 * PADDING, textHeight + labelHeight + GRAPH_HEIGHT + 2 * PADDING,
+             glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+    hud.text(MARGIN + PADDING, MARGIN + PADDING, text, SCALE, TEXT_COLOUR);
+    hud.text(MARGIN + PADDING, graphTop - labelHeight, GRAPH_LABEL, SCALE, TEXT_COLOUR);
+    // 60 FPS line half way up
+    float targetY = graphTop + GRAPH_HEIGHT * 0.5f;
+    hud.line(glm::vec2(MARGIN + PADDING, targetY), glm::vec2(MARGIN + PADDING + width, targetY), 1.0f,
+             glm::vec4(1.0f, 1.0f, 1.0f, 0.3f));
+    hud.graph(MARGIN + PADDING, graphTop, width, GRAPH_HEIGHT, hudTimes.gpuMs, HUD_HISTORY, hudTimes.next,
+              HUD_GRAPH_MAX_MS, GPU_COLOUR);
+    hud.graph(MARGIN + PADDING, graphTop, width, GRAPH_HEIGHT, hudTimes.frameMs, HUD_HISTORY, hudTimes.next,
+              HUD_GRAPH_MAX_MS, FRAME_COLOUR);
+    hud.draw();
+}
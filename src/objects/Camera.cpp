@@ -69,7 +69,7 @@ void PlayerCamera::update(InputState &input){
     input.deltaY = 0;
     input.deltaX = 0;
 
-    float change = RESET_SPEED * GameTime::getGameTime()->getDt();
+    float change = RESET_SPEED * GameTime::getGameTime()->getFrameDt();
 
     if(player->getThrottle() > 0.1f){
         if(fabs(yaw) < change){
@@ -81,14 +81,16 @@ void PlayerCamera::update(InputState &input){
         }
     }
 
-    float angle = yaw + player->getRotationY();
+    // Follows the car as drawn, between simulation steps
+    float alpha = GameTime::getGameTime()->getAlpha();
+    float angle = yaw + player->getInterpolatedRotation(alpha).y;
 
     float hDist = distance * glm::cos(pitch);
     float vDist = distance * glm::sin(pitch);
     float offsetX = hDist * glm::sin(angle);
     float offsetZ = hDist * glm::cos(angle);
 
-    this->focalPoint = player->getPosition();
+    this->focalPoint = player->getInterpolatedPosition(alpha);
     this->position = glm::vec3(-offsetX, vDist, -offsetZ) + this->focalPoint;
 
     look(this->focalPoint);
@@ -153,7 +155,8 @@ void TrackingCamera::update(InputState &input) {
     input.deltaY = 0;
     input.deltaX = 0;
 
-    float angle = yaw - player->getRotationY();
+    float alpha = GameTime::getGameTime()->getAlpha();
+    float angle = yaw - player->getInterpolatedRotation(alpha).y;
 
     glm::vec3 front;
     front.x = cos(pitch) * cos(angle);
@@ -161,8 +164,30 @@ void TrackingCamera::update(InputState &input) {
     front.z = cos(pitch) * sin(angle);
     front = glm::normalize(front);
 
-    this->position = player->getPosition() + glm::vec3(0.0f, 1.0f, 0.0f);
+    this->position = player->getInterpolatedPosition(alpha) + glm::vec3(0.0f, 1.0f, 0.0f);
 
     this->focalPoint = this->position + front;
     look(this->focalPoint);
 }
+
+PathCamera::PathCamera(Terrain* terrain, const std::vector<glm::vec2>& points, float height, float speed)
+        : Camera(), path(points), terrain(terrain), height(height), speed(speed), travelled(0.0f) {
+}
+
+void PathCamera::update(InputState &input) {
+    input.scrollDeltaY = 0.0;
+    input.deltaY = 0;
+    input.deltaX = 0;
+
+    travelled = path.wrap(travelled + speed * GameTime::getGameTime()->getFrameDt());
+
+    // Off the map the terrain reports negative heights, hold the height at the edge instead
+    glm::vec2 ground = path.getPoint(travelled);
+    glm::vec2 ahead = path.getPoint(travelled + 4.0f * height);
+    float groundHeight = std::max(terrain->getHeight(ground.x, ground.y), 0.0f);
+    float aheadHeight = std::max(terrain->getHeight(ahead.x, ahead.y), 0.0f);
+
+    this->position = glm::vec3(ground.x, groundHeight + height, ground.y);
+    this->focalPoint = glm::vec3(ahead.x, aheadHeight, ahead.y);
+    look(this->focalPoint);
+}
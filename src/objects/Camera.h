@@ -8,7 +8,11 @@
 #include <cmath>
 
 #include "../utils/InputState.h"
+#include "../utils/CatmullRomSpline.h"
 #include "Player.h"
+#include "Terrain.h"
+
+#include <vector>
 
 #include <glm/glm.hpp>
 
@@ -71,4 +75,17 @@ public:
     virtual void update(InputState &input);
 };
 
+// Flies a fixed loop at a height above the terrain, looking ahead along it. Input has no effect.
+class PathCamera : public Camera {
+private:
+    CatmullRomSpline path;
+    Terrain* terrain;
+    float height;
+    float speed;
+    float travelled;
+public:
+    PathCamera(Terrain* terrain, const std::vector<glm::vec2>& points, float height, float speed);
+    virtual void update(InputState &input);
+};
+
 #endif
\ No newline at end of file
@@ -11,6 +11,10 @@ Entity::Entity(Model* model){
     xRot = 0.0f;
     yRot = 0.0f;
     zRot = 0.0f;
+
+    dirty = true;
+    transformVersion = 0;
+    beginStep();
 }
 
 Entity::Entity(){
@@ -21,19 +25,68 @@ Entity::Entity(){
     xRot = 0.0f;
     yRot = 0.0f;
     zRot = 0.0f;
+
+    dirty = true;
+    transformVersion = 0;
+    beginStep();
+}
+
+Entity::~Entity(){
 }
 
 bool Entity::update(){
     return false;
 }
 
+void Entity::beginStep(){
+    previousPosition = position;
+    previousRotation = glm::vec3(xRot, yRot, zRot);
+}
+
+bool Entity::isInterpolating() const {
+    return previousPosition != position || previousRotation != glm::vec3(xRot, yRot, zRot);
+}
+
+glm::vec3 Entity::getInterpolatedPosition(float alpha) const {
+    return glm::mix(previousPosition, position, alpha);
+}
+
+glm::vec3 Entity::getInterpolatedRotation(float alpha) const {
+    // Angles are wrapped at 2*pi, so a step may jump by a whole turn. Turn the short way round.
+    glm::vec3 change = glm::vec3(xRot, yRot, zRot) - previousRotation;
+    change -= (float)(2.0 * M_PI) * glm::round(change / (float)(2.0 * M_PI));
+    return previousRotation + change * alpha;
+}
+
 Model* Entity::getModel() const {
     return model;
 }
 
-glm::mat4 Entity::getModelMatrix(){
+const glm::mat4& Entity::getModelMatrix(){
+    if(dirty) updateMatrices();
+    return modelMatrix;
+}
+
+const glm::mat3& Entity::getNormalMatrix(){
+    if(dirty) updateMatrices();
+    return normalMatrix;
+}
+
+unsigned int Entity::getTransformVersion() const {
+    return transformVersion;
+}
+
+void Entity::markDirty(){
+    dirty = true;
+    transformVersion++;
+}
+
+void Entity::updateMatrices(){
     glm::mat4 rotation = calculateRotationMatrix(xRot, yRot, zRot);
-    return calculateModelMatrix(position, rotation, scale);
+    modelMatrix = calculateModelMatrix(position, rotation, scale);
+    normalMatrix = glm::inverseTranspose(glm::mat3(modelMatrix));
+    dirty = false;
+    RenderStats::getRenderStats()->matricesRecomputed++;
 }
 
 
@@ -62,46 +115,57 @@ glm::vec3 Entity::getDirectionVector(){
     return glm::normalize(glm::vec3(glm::sin(yRot), glm::sin(xRot), glm::cos(yRot)));
 }
 
+// Setting a value equal to the current one keeps the cached matrix.
 void Entity::setPosition(glm::vec3 position){
+    if(this->position == position) return;
     this->position = position;
+    markDirty();
 }
 
 void Entity::placeBottomEdge(float surfaceY){
     if(model != NULL){
-        position.y = surfaceY - model->getRangeInDim(1).first * scale.y;
+        setPosition(glm::vec3(position.x, surfaceY - model->getRangeInDim(1).first * scale.y, position.z));
     }
 }
 
 void Entity::setScale(glm::vec3 scale){
+    if(this->scale == scale) return;
     this->scale = scale;
+    markDirty();
 }
 
 void Entity::setRotationX(float rot){
+    if(xRot == rot) return;
     xRot = rot;
+    markDirty();
 }
 
 void Entity::setRotationY(float rot){
+    if(yRot == rot) return;
     yRot = rot;
+    markDirty();
 }
 
 void Entity::setRotationZ(float rot){
+    if(zRot == rot) return;
     zRot = rot;
+    markDirty();
 }
 // Set the value of rotation or position relatively (Takes into account current value)
 void Entity::rotateX(float rot){
-    xRot += rot;
+    setRotationX(xRot + rot);
 }
 
 void Entity::rotateY(float rot){
-    yRot += rot;
+    setRotationY(yRot + rot);
 }
 
 void Entity::rotateZ(float rot){
-    zRot += rot;
+    setRotationZ(zRot + rot);
 }
 
 void Entity::move(glm::vec3 movement){
-    position = position + movement;
+    setPosition(position + movement);
 }
 
 glm::mat4 Entity::calculateModelMatrix(glm::vec3 position, glm::mat4 rotationMat, glm::vec3 scale) {
@@ -7,6 +7,7 @@
 #include <GLFW/glfw3.h>
 
 #include "../utils/Model.h"
+#include "../utils/RenderStats.h"
 
 #include <assert.h>
 #include <string>
@@ -15,23 +16,52 @@
 #include <glm/ext.hpp>
 
 class Entity {
+private:
+    // Cached transform, rebuilt on the first request after the position, rotation or scale changed.
+    glm::mat4 modelMatrix;
+    glm::mat3 normalMatrix;
+    bool dirty;
+    unsigned int transformVersion;
+
+    // Transform when the last simulation step began, see beginStep().
+    glm::vec3 previousPosition;
+    glm::vec3 previousRotation;
+
+    void updateMatrices();
+
 protected:
     Model* model;
 
+    // Inheriting classes should change these through the setters, or call markDirty() after writing them.
     glm::vec3 position;
     glm::vec3 scale;
     float xRot;
     float yRot;
     float zRot;
 
+    void markDirty();
+
 public:
     Entity(Model* model);
     Entity();
+    virtual ~Entity();
 
     virtual bool update();
 
+    // Remembers the current transform as the state the next simulation step starts from.
+    // Should be called before every fixed step, and after the entity is placed so it does not appear to move there.
+    void beginStep();
+    // True if the last step changed the position or rotation, so it has to be drawn part way between the two.
+    bool isInterpolating() const;
+    // Transform alpha of the way from the start to the end of the last step.
+    glm::vec3 getInterpolatedPosition(float alpha) const;
+    glm::vec3 getInterpolatedRotation(float alpha) const;   // Angles about x, y and z
+
     Model* getModel() const;
-    glm::mat4 getModelMatrix();
+    const glm::mat4& getModelMatrix();
+    const glm::mat3& getNormalMatrix();     // Inverse transpose of the model matrix, for transforming normals
+    // Increases every time the transform changes, lets copies of the matrix tell whether they are stale.
+    unsigned int getTransformVersion() const;
 
     glm::vec3 getPosition() const;
     glm::vec3 getScale() const;
@@ -0,0 +1,275 @@
+#include "EntityStore.h"
+
+#include "../utils/Profiler.h"
+
+EntityStore::EntityStore(){
+}
+
+void EntityStore::reserve(size_t count){
+    positions.reserve(count);
+    rotations.reserve(count);
+    scales.reserve(count);
+    matrices.reserve(count);
+    normalMatrices.reserve(count);
+    bounds.reserve(count);
+    models.reserve(count);
+    flags.reserve(count);
+    behaviours.reserve(count);
+    versions.reserve(count);
+    isPending.reserve(count);
+}
+
+size_t EntityStore::size() const {
+    return positions.size();
+}
+
+EntityHandle EntityStore::allocate(Model* model, unsigned char entityFlags){
+    EntityHandle handle = positions.size();
+    positions.push_back(glm::vec3(0.0f));
+    rotations.push_back(glm::vec3(0.0f));
+    scales.push_back(glm::vec3(1.0f));
+    matrices.push_back(glm::mat4(1.0f));
+    normalMatrices.push_back(glm::mat3(1.0f));
+    bounds.push_back(glm::vec4(0.0f));
+    models.push_back(model);
+    flags.push_back(entityFlags);
+    behaviours.push_back(NULL);
+    versions.push_back(0);
+    isPending.push_back(false);
+    return handle;
+}
+
+EntityHandle EntityStore::add(Model* model, glm::vec3 position, glm::vec3 scale, glm::vec3 rotation,
+        unsigned char entityFlags){
+    EntityHandle handle = allocate(model, entityFlags);
+    positions[handle] = position;
+    scales[handle] = scale;
+    rotations[handle] = rotation;
+    updateMatrix(handle);
+    return handle;
+}
+
+EntityHandle EntityStore::add(Entity* entity){
+    EntityHandle handle = allocate(entity->getModel(), 0);
+    behaviours[handle] = entity;
+    dynamic.push_back(handle);
+    entity->beginStep();    // Starts at rest where it was placed
+    copyFromBehaviour(handle);
+    return handle;
+}
+
+void EntityStore::update(){
+    step();
+    interpolate(1.0f);
+}
+
+void EntityStore::step(){
+    PROFILE_SCOPE("entities step");
+    for(size_t i = 0; i < dynamic.size(); ++i){
+        EntityHandle handle = dynamic[i];
+        if(flags[handle] & STATIC) continue;
+
+        behaviours[handle]->beginStep();
+        behaviours[handle]->update();
+    }
+}
+
+void EntityStore::interpolate(float alpha){
+    PROFILE_SCOPE("entities interpolate");
+    int recomputed = 0;
+    for(size_t i = 0; i < dynamic.size(); ++i){
+        EntityHandle handle = dynamic[i];
+        if(flags[handle] & STATIC) continue;
+
+        Entity* entity = behaviours[handle];
+        if(!entity->isInterpolating()){
+            // At rest, the entity's own cached matrix is exact.
+            if(entity->getTransformVersion() != versions[handle]){
+                copyFromBehaviour(handle);
+            }
+            continue;
+        }
+
+        positions[handle] = entity->getInterpolatedPosition(alpha);
+        rotations[handle] = entity->getInterpolatedRotation(alpha);
+        scales[handle] = entity->getScale();
+        glm::mat4 rotation = Entity::calculateRotationMatrix(rotations[handle].x, rotations[handle].y,
+                                                             rotations[handle].z);
+        matrices[handle] = Entity::calculateModelMatrix(positions[handle], rotation, scales[handle]);
+        normalMatrices[handle] = glm::inverseTranspose(glm::mat3(matrices[handle]));
+        updateBounds(handle);
+        // Not the entity's own state, so copy it again once the entity comes to rest.
+        versions[handle] = entity->getTransformVersion() - 1;
+        recomputed++;
+    }
+    RenderStats::getRenderStats()->matricesRecomputed += recomputed;
+    flushTransforms();
+}
+
+void EntityStore::flushTransforms(){
+    if(pending.empty()) return;
+
+    batch.resize(pending.size());
+    batchMatrices.resize(pending.size());
+    for(size_t i = 0; i < pending.size(); ++i){
+        EntityHandle handle = pending[i];
+        batch.set(i, positions[handle], rotations[handle], scales[handle]);
+    }
+    TransformBatch::calculateModelMatrices(batch, &batchMatrices[0]);
+
+    int recomputed = 0;
+    for(size_t i = 0; i < pending.size(); ++i){
+        EntityHandle handle = pending[i];
+        if(!isPending[handle]) continue;    // Placed by setWorldMatrix since
+        isPending[handle] = false;
+
+        // The matrix is a rotation times a scale, so the inverse transpose is each column over its length squared.
+        const glm::mat4& matrix = batchMatrices[i];
+        matrices[handle] = matrix;
+        for(int c = 0; c < 3; ++c){
+            glm::vec3 column = glm::vec3(matrix[c]);
+            normalMatrices[handle][c] = column / glm::dot(column, column);
+        }
+        updateBounds(handle);
+        recomputed++;
+    }
+    RenderStats::getRenderStats()->matricesRecomputed += recomputed;
+    pending.clear();
+}
+
+void EntityStore::copyFromBehaviour(EntityHandle handle){
+    Entity* entity = behaviours[handle];
+    positions[handle] = entity->getPosition();
+    scales[handle] = entity->getScale();
+    rotations[handle] = glm::vec3(entity->getRotationX(), entity->getRotationY(), entity->getRotationZ());
+    versions[handle] = entity->getTransformVersion();
+    updateMatrix(handle);
+}
+
+void EntityStore::updateMatrix(EntityHandle handle){
+    if(behaviours[handle] != NULL){
+        // The entity keeps its own cached copy.
+        matrices[handle] = behaviours[handle]->getModelMatrix();
+        normalMatrices[handle] = behaviours[handle]->getNormalMatrix();
+        updateBounds(handle);
+    } else if(!isPending[handle]){
+        isPending[handle] = true;
+        pending.push_back(handle);
+    }
+}
+
+void EntityStore::updateBounds(EntityHandle handle){
+    // Sphere around the model's bounding box, carried into world space. Models without a range are never culled.
+    Model* model = models[handle];
+    if(model == NULL || model->getRangeInDim(0).first > model->getRangeInDim(0).second){
+        bounds[handle] = glm::vec4(positions[handle], FLT_MAX);
+        return;
+    }
+    glm::vec3 min, max;
+    for(int dim = 0; dim < 3; ++dim){
+        std::pair<float, float> range = model->getRangeInDim(dim);
+        min[dim] = range.first;
+        max[dim] = range.second;
+    }
+    const glm::mat4& matrix = matrices[handle];
+    float maxScale = std::max(glm::length(matrix[0]), std::max(glm::length(matrix[1]), glm::length(matrix[2])));
+    glm::vec3 centre = glm::vec3(matrices[handle] * glm::vec4((min + max) * 0.5f, 1.0f));
+    bounds[handle] = glm::vec4(centre, glm::length(max - min) * 0.5f * maxScale);
+}
+
+void EntityStore::setPosition(EntityHandle handle, glm::vec3 position){
+    if(behaviours[handle] != NULL){
+        behaviours[handle]->setPosition(position);
+        copyFromBehaviour(handle);
+        return;
+    }
+    positions[handle] = position;
+    updateMatrix(handle);
+}
+
+void EntityStore::setScale(EntityHandle handle, glm::vec3 scale){
+    if(behaviours[handle] != NULL){
+        behaviours[handle]->setScale(scale);
+        copyFromBehaviour(handle);
+        return;
+    }
+    scales[handle] = scale;
+    updateMatrix(handle);
+}
+
+void EntityStore::setRotation(EntityHandle handle, glm::vec3 rotation){
+    if(behaviours[handle] != NULL){
+        behaviours[handle]->setRotationX(rotation.x);
+        behaviours[handle]->setRotationY(rotation.y);
+        behaviours[handle]->setRotationZ(rotation.z);
+        copyFromBehaviour(handle);
+        return;
+    }
+    rotations[handle] = rotation;
+    updateMatrix(handle);
+}
+
+void EntityStore::setWorldMatrix(EntityHandle handle, const glm::mat4& matrix){
+    assert(behaviours[handle] == NULL);
+    isPending[handle] = false;
+    positions[handle] = glm::vec3(matrix[3]);
+    matrices[handle] = matrix;
+    normalMatrices[handle] = glm::inverseTranspose(glm::mat3(matrix));
+    updateBounds(handle);
+}
+
+void EntityStore::setFlags(EntityHandle handle, unsigned char entityFlags){
+    flags[handle] = entityFlags;
+}
+
+void EntityStore::placeBottomEdge(EntityHandle handle, float surfaceY){
+    if(models[handle] == NULL) return;
+    glm::vec3 position = positions[handle];
+    position.y = surfaceY - models[handle]->getRangeInDim(1).first * scales[handle].y;
+    setPosition(handle, position);
+}
+
+glm::vec3 EntityStore::getPosition(EntityHandle handle) const {
+    return positions[handle];
+}
+
+glm::vec3 EntityStore::getScale(EntityHandle handle) const {
+    return scales[handle];
+}
+
+glm::vec3 EntityStore::getRotation(EntityHandle handle) const {
+    return rotations[handle];
+}
+
+bool EntityStore::hasBehaviour(EntityHandle handle) const {
+    return behaviours[handle] != NULL;
+}
+
+Model* EntityStore::getModel(EntityHandle handle) const {
+    return models[handle];
+}
+
+const glm::mat4& EntityStore::getMatrix(EntityHandle handle) const {
+    return matrices[handle];
+}
+
+const glm::mat3& EntityStore::getNormalMatrix(EntityHandle handle) const {
+    return normalMatrices[handle];
+}
+
+unsigned char EntityStore::getFlags(EntityHandle handle) const {
+    return flags[handle];
+}
+
+int EntityStore::collectVisible(const Frustum& frustum, std::vector<EntityHandle>& visible) const {
+    int culled = 0;
+    for(size_t i = 0; i < bounds.size(); ++i){
+        if((flags[i] & HIDDEN) || models[i] == NULL) continue;
+        if(!frustum.intersectsSphere(glm::vec3(bounds[i]), bounds[i].w)){
+            culled++;
+            continue;
+        }
+        visible.push_back(i);
+    }
+    return culled;
+}
@@ -0,0 +1,107 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Entity.h"
+#include "../utils/Model.h"
+#include "../utils/Frustum.h"
+#include "../utils/TransformBatch.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+typedef unsigned int EntityHandle;
+
+/*
+    All of the world's entities, stored as parallel arrays indexed by handle rather than one heap object each.
+
+    Plain props are added with a model and a transform. Their matrices are computed in one batch on the next
+    update() or flushTransforms() after they were placed or moved, and left alone after that.
+    Entities with behaviour (the player) are added as an Entity object, which is updated every simulation step and
+    has its transform, interpolated between steps, copied back into the arrays. Only those slots are visited by
+    step() and interpolate().
+*/
+class EntityStore {
+public:
+    enum Flags {
+        STATIC = 1 << 0,    // Never moves on its own, skipped by update()
+        HIDDEN = 1 << 1     // Kept in the store but never collected for rendering
+    };
+
+private:
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> rotations;   // Angles about x, y and z, applied in the same order as Entity
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> matrices;
+    std::vector<glm::mat3> normalMatrices;
+    std::vector<glm::vec4> bounds;      // World space bounding sphere, xyz - centre, w - radius
+    std::vector<Model*> models;
+    std::vector<unsigned char> flags;
+    std::vector<Entity*> behaviours;    // Object driving the slot, NULL for plain props
+    std::vector<unsigned int> versions; // Transform version of the behaviour when last copied
+
+    std::vector<EntityHandle> dynamic;  // Slots with a behaviour, in handle order
+
+    // Props placed or moved since the last flush, their matrices are built together by TransformBatch.
+    std::vector<EntityHandle> pending;
+    std::vector<unsigned char> isPending;
+    TransformSoA batch;
+    std::vector<glm::mat4> batchMatrices;
+
+    void updateMatrix(EntityHandle handle);
+    void updateBounds(EntityHandle handle);
+    void copyFromBehaviour(EntityHandle handle);
+    EntityHandle allocate(Model* model, unsigned char flags);
+
+public:
+    EntityStore();
+
+    void reserve(size_t count);
+    size_t size() const;
+
+    EntityHandle add(Model* model, glm::vec3 position, glm::vec3 scale, glm::vec3 rotation = glm::vec3(0.0f),
+            unsigned char flags = STATIC);
+    // The store does not take ownership of the entity.
+    EntityHandle add(Entity* entity);
+
+    // One simulation step followed by interpolate(1), i.e. drawing the latest state.
+    void update();
+    // Runs the behaviour of every dynamic slot once, should be called for every fixed simulation step.
+    void step();
+    // Places dynamic slots alpha of the way through their last step, so motion is smooth when frames and
+    // steps do not line up, then flushes. Should be called once per frame after the steps.
+    void interpolate(float alpha);
+    // Builds the matrices and bounds of props placed or moved since the last flush.
+    void flushTransforms();
+
+    void setPosition(EntityHandle handle, glm::vec3 position);
+    void setScale(EntityHandle handle, glm::vec3 scale);
+    void setRotation(EntityHandle handle, glm::vec3 rotation);
+    void setFlags(EntityHandle handle, unsigned char flags);
+    // Places a plain prop by its final matrix, for props attached to a SceneGraph node. Rotation and scale
+    // are left as they were, only the position is taken from the matrix.
+    void setWorldMatrix(EntityHandle handle, const glm::mat4& matrix);
+    // Moves the entity vertically so the bottom of its model rests at surfaceY.
+    void placeBottomEdge(EntityHandle handle, float surfaceY);
+
+    glm::vec3 getPosition(EntityHandle handle) const;
+    glm::vec3 getScale(EntityHandle handle) const;
+    glm::vec3 getRotation(EntityHandle handle) const;
+    // True for slots added as an Entity object, whose transform is owned by that object.
+    bool hasBehaviour(EntityHandle handle) const;
+    Model* getModel(EntityHandle handle) const;
+    const glm::mat4& getMatrix(EntityHandle handle) const;
+    const glm::mat3& getNormalMatrix(EntityHandle handle) const;
+    unsigned char getFlags(EntityHandle handle) const;
+
+    // Appends the handles of all visible entities with a model inside the frustum, in handle order. Returns how many
+    // visible entities with a model were outside it.
+    int collectVisible(const Frustum& frustum, std::vector<EntityHandle>& visible) const;
+};
+
+#endif //ENTITY_STORE_H
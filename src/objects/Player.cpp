@@ -8,42 +8,13 @@ Car physics calculation has been modified from
     #1 https://github.com/spacejack/carphysics2d
 which is an adaptation of
     http://www.asawicki.info/Mirror/Car%20Physics%20for%20Games/Car%20Physics%20for%20Games.html
-I didnt make many changes since it is a complete equation, but I did add code to stop when there is no throttle.
+It now lives in VehicleSim, which steps many cars at once, the player is a simulation of one car.
 */
 
-// Static variables used for car physics
-float gravity = 9.81f;           // m/s^2
-float mass = 2000.0f;            // kg
-float inertiaScale = 1.0f;       // Multiply by mass for inertia
-float halfWidth = 0.8f;          // Centre to side of chassis (metres)
-float cgToFront = 1.5f;          // Centre of gravity to front of chassis (metres)
-float cgToRear = 1.5f;           // Centre of gravity to rear of chassis
-float cgToFrontAxle = 1.25f;     // Centre gravity to front axle
-float cgToRearAxle = 1.25f;      // Centre gravity to rear axle
-float cgHeight = 0.55f;          // Centre gravity height
-float wheelRadius = 0.3f;        // Includes tire (also represents height of axle)
-float wheelWidth = 0.2f;         // Used for render only
-float tireGrip = 3.0f;           // How much grip tires have
-float lockGrip = 0.8f;           // % of grip available when wheel is locked
-float engineForce = 8000.0f;
-float brakeForce = 12000.0f;
-float eBrakeForce = brakeForce / 2.5f;
-float weightTransfer = 0.2f;             // How much weight is transferred during acceleration/braking
-float maxSteer = 0.6f;                   // Maximum steering angle in radians
-float cornerStiffnessFront = 5.0f;
-float cornerStiffnessRear = 5.2f;
-float airResist = 3.0f;                    // air resistance (* vel)
-float rollResist = 5.0f;
-float inertia = mass * inertiaScale;    // will be = mass
-float wheelBase = cgToFrontAxle + cgToRearAxle;         // set from axle to CG lengths
-float axleWeightRatioFront = cgToRearAxle / wheelBase;  // % car weight on the front axle
-float axleWeightRatioRear = cgToFrontAxle / wheelBase;  // % car weight on the rear axle
-
-
 Player::Player(Model* model, Terrain* terrain, bool basic_controls): Entity(model){
     this->terrain = terrain;
     this->absVel = 0.0f;
-    this->yawRate = 0.0f;
+    this->physics.add(VehicleParams(), glm::vec2(0.0f), 0.0f);
     this->steerAngle = 0.0f;
     this->steerChange = 0.0f;
     this->throttle_input = 0.0f;
@@ -57,8 +28,23 @@ Player::Player(Model* model, Terrain* terrain, bool basic_controls): Entity(mode
     }
 }
 
-template <typename T> int sgn(T val) {
-return (T(0) < val) - (val < T(0));
+OrientedBox Player::getCollisionBox(){
+    glm::vec3 min, max;
+    for(int dim = 0; dim < 3; dim++){
+        min[dim] = model->getRangeInDim(dim).first;
+        max[dim] = model->getRangeInDim(dim).second;
+    }
+    return OrientedBox::fromLocalBounds(min, max, position, scale, yRot);
+}
+
+void Player::resolveCollision(glm::vec2 normal, float depth){
+    move(glm::vec3(normal.x, 0.0f, normal.y) * depth);
+    if(!basic_controls){
+        // The next update poses the simulation at the new position, only the velocity needs changing here
+        glm::vec2 velocity = Collision::respond(physics.getVelocity(0), normal, Collision::CAR_RESTITUTION);
+        physics.setVelocity(0, velocity);
+        absVel = physics.getSpeed(0);
+    }
 }
 
 float Player::getThrottle(){
@@ -83,9 +69,9 @@ bool Player::update(){
         rotateY(steerAngle * dt);
 
         if(yRot > (float)M_PI*2){
-            yRot -= M_PI*2;
+            setRotationY(yRot - M_PI*2);
         } else if (yRot < (float)-M_PI*2){
-            yRot += M_PI*2;
+            setRotationY(yRot + M_PI*2);
         }
 
         float distance = (throttle_input - brake_input) *  MOVE_SPEED * dt;
@@ -93,95 +79,28 @@ bool Player::update(){
         dx = distance * glm::sin(yRot);
         dz = distance * glm::cos(yRot);
     } else {
-        /* Following is code from #1 and adapted to this program */
-        // Pre-calc heading vector
-        float sn = sin(yRot);
-        float cs = cos(yRot);
-
-        // Get velocity in local car coordinates
-        velocity_c.y = cs * velocity.y + sn * velocity.x;
-        velocity_c.x = cs * velocity.x - sn * velocity.y;
-
-        // Weight on axles based on centre of gravity and weight shift due to forward/reverse acceleration
-        float axleWeightFront = mass * (axleWeightRatioFront * gravity - weightTransfer * accel_c.y * cgHeight / wheelBase);
-        float axleWeightRear = mass * (axleWeightRatioRear * gravity + weightTransfer * accel_c.y * cgHeight / wheelBase);
-
-        // Resulting velocity of the wheels as result of the yaw rate of the car body.
-        // v = yawrate * r where r is distance from axle to CG and yawRate (angular velocity) in rad/s.
-        float yawSpeedFront = cgToFrontAxle * yawRate;
-        float yawSpeedRear = -cgToRearAxle * yawRate;
-
-        // Calculate slip angles for front and rear wheels (a.k.a. alpha)
-        float slipAngleFront = atan2(velocity_c.x + yawSpeedFront, abs(velocity_c.y)) - sgn(velocity_c.y) * steerAngle;
-        float slipAngleRear  = atan2(velocity_c.x + yawSpeedRear,  abs(velocity_c.y));
-
-        float tireGripFront = tireGrip;
-        float tireGripRear = tireGrip * (1.0 - ebrake_input * (1.0 - lockGrip)); // reduce rear grip when ebrake is on
-
-        float frictionForceFront_cy = clamp(-cornerStiffnessFront * slipAngleFront, -tireGripFront, tireGripFront) * axleWeightFront;
-        float frictionForceRear_cy = clamp(-cornerStiffnessRear * slipAngleRear, -tireGripRear, tireGripRear) * axleWeightRear;
-
-        //  Get amount of brake/throttle from our inputs
-        float brake = std::min(brake_input * brakeForce + ebrake_input * eBrakeForce, brakeForce);
-        float throttle = throttle_input * engineForce;
-
-        //  Resulting force in local car coordinates.
-        //  is implemented as a RWD car only.
-        float tractionForce_cx = throttle - brake * sgn(velocity_c.y);
-        float tractionForce_cy = 0;
-
-        float dragForce_cx = -rollResist * velocity_c.y - airResist * velocity_c.y * abs(velocity_c.y);
-        float dragForce_cy = -rollResist * velocity_c.x - airResist * velocity_c.x * abs(velocity_c.x);
-
-        // total force in car coordinates
-        float totalForce_cx = dragForce_cx + tractionForce_cx;
-        float totalForce_cy = dragForce_cy + tractionForce_cy + cos(steerAngle) * frictionForceFront_cy + frictionForceRear_cy;
-
-        // acceleration along car axes
-        accel_c.y = totalForce_cx / mass;  // forward/reverse accel
-        accel_c.x = totalForce_cy / mass;  // sideways accel
-
-        // acceleration in world coordinates
-        accel.y = cs * accel_c.y - sn * accel_c.x;
-        accel.x = sn * accel_c.y + cs * accel_c.x;
-
-        // update velocity
-        velocity.y += accel.y * dt;
-        velocity.x += accel.x * dt;
-
-        absVel = length(velocity);
-
-        // Slow the car down when no throttle, the overall equation doesn't seem to do this very well.
-        if(throttle < 0.5f){
-            velocity = velocity - (velocity * 0.5f * dt);
-        }
-
-        // calculate rotational forces
-        float angularTorque = (frictionForceFront_cy + tractionForce_cy) * cgToFrontAxle - frictionForceRear_cy * cgToRearAxle;
-
-        float angularAccel = angularTorque / inertia;
-
-        //  Sim gets unstable at very slow speeds, so just stop the car
-        if(abs(absVel) < 2.0f && throttle < 0.5f) {
-            velocity.y = 0.0f;
-            velocity.x = 0.0f;
-            absVel = 0.0f;
-            yawRate = 0.0f;
-        } else {
-            yawRate += angularAccel * dt;
-            yRot += yawRate * dt;
-
-            dx = velocity.x * dt;
-            dz = velocity.y * dt;
-        }
-        /* End code from #1 */
+        // The simulation starts from wherever the car was left, e.g. after being stopped at the edge of the terrain.
+        VehicleInput controls;
+        controls.throttle = throttle_input;
+        controls.brake = brake_input;
+        controls.ebrake = ebrake_input;
+        controls.steer = steerAngle;
+        physics.setPose(0, glm::vec2(position.x, position.z), yRot);
+        physics.setInput(0, controls);
+        physics.step(dt, VehicleSim::SCALAR);
+
+        absVel = physics.getSpeed(0);
+        setRotationY(physics.getHeading(0));
+        glm::vec2 moved = physics.getPosition(0) - glm::vec2(position.x, position.z);
+        dx = moved.x;
+        dz = moved.y;
     }
 
     // Wrap rotation around once it reaches 2*pi
     if(yRot > (float)M_PI*2){
-        yRot -= M_PI*2;
+        setRotationY(yRot - M_PI*2);
     } else if (yRot < (float)-M_PI*2){
-        yRot += M_PI*2;
+        setRotationY(yRot + M_PI*2);
     }
 
     // Assumes constant scale
@@ -10,6 +10,8 @@
 #include "../utils/Model.h"
 #include "../utils/GameTime.h"
 #include "Terrain.h"
+#include "../physics/VehicleSim.h"
+#include "../physics/Collision.h"
 
 #include <assert.h>
 #include <string>
@@ -24,13 +26,8 @@ private:
     const float MOVE_SPEED = 10.0f;
     float ROTATION_SPEED;
 
-    // Extra parameters if physics mode is being used
-    glm::vec2 velocity;
-    glm::vec2 velocity_c;
-    glm::vec2 accel;
-    glm::vec2 accel_c;
-
-    float yawRate;
+    // Car model used if physics mode is being used, holding just this car
+    VehicleSim physics;
 
     // Input parameters
     float steerAngle;
@@ -51,6 +48,10 @@ public:
     float getThrottle();
     float getBrake();
     float getSteer();
+    // Footprint of the car on the ground, for collision detection.
+    OrientedBox getCollisionBox();
+    // Moves the car out of something it hit, by depth along normal, and takes away its speed into it.
+    void resolveCollision(glm::vec2 normal, float depth);
     float absVel;
 
     void handleKeyboardEvents(GLFWwindow* window, int key, int scancode, int action, int mods);
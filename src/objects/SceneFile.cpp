@@ -0,0 +1,220 @@
+#include "SceneFile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const uint32_t SceneFile::VERSION = 1;
+
+static const char SCENE_MAGIC[4] = {'W', 'W', 'S', 'C'};
+
+template <typename T>
+static bool writeRecords(FILE* file, const std::vector<T>& records){
+    if(records.empty()) return true;
+    return fwrite(&records[0], sizeof(T), records.size(), file) == records.size();
+}
+
+SceneFile::SceneFile(): mapping(NULL), mappingSize(0), header(NULL), modelRecords(NULL), propRecords(NULL),
+        lightRecords(NULL), spawnRecords(NULL) {
+}
+
+SceneFile::~SceneFile(){
+    if(mapping != NULL){
+        munmap(mapping, mappingSize);
+    }
+}
+
+void SceneFile::load(std::string filename){
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0){
+        std::cerr << "[SceneFile] Failed to open " << filename << std::endl;
+        exit(1);
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header)){
+        std::cerr << "[SceneFile] " << filename << " is too small to be a scene file" << std::endl;
+        exit(1);
+    }
+    mappingSize = info.st_size;
+    mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file alive
+    if(mapping == MAP_FAILED){
+        std::cerr << "[SceneFile] Failed to map " << filename << std::endl;
+        exit(1);
+    }
+
+    header = (const Header*)mapping;
+    if(memcmp(header->magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0 || header->version != VERSION){
+        std::cerr << "[SceneFile] " << filename << " is not a version " << VERSION << " scene file" << std::endl;
+        exit(1);
+    }
+
+    // Records are all multiples of 4 bytes long, so each array starts suitably aligned.
+    const char* cursor = (const char*)mapping + sizeof(Header);
+    modelRecords = (const ModelRecord*)cursor;
+    cursor += sizeof(ModelRecord) * header->modelCount;
+    propRecords = (const PropRecord*)cursor;
+    cursor += sizeof(PropRecord) * header->propCount;
+    lightRecords = (const LightRecord*)cursor;
+    cursor += sizeof(LightRecord) * header->lightCount;
+    spawnRecords = (const SpawnRecord*)cursor;
+    cursor += sizeof(SpawnRecord) * header->spawnCount;
+    if((size_t)(cursor - (const char*)mapping) != mappingSize){
+        std::cerr << "[SceneFile] " << filename << " does not match the record counts in its header" << std::endl;
+        exit(1);
+    }
+
+    for(size_t i = 0; i < header->propCount; i++){
+        if(propRecords[i].model >= header->modelCount){
+            std::cerr << "[SceneFile] Prop " << i << " refers to missing model " << propRecords[i].model << std::endl;
+            exit(1);
+        }
+    }
+}
+
+size_t SceneFile::getModelCount() const {
+    return header->modelCount;
+}
+
+std::string SceneFile::getModelPath(size_t index) const {
+    const char* path = modelRecords[index].path;
+    return std::string(path, strnlen(path, MAX_PATH_LENGTH));
+}
+
+size_t SceneFile::getPropCount() const {
+    return header->propCount;
+}
+
+const SceneFile::PropRecord* SceneFile::getProps() const {
+    return propRecords;
+}
+
+size_t SceneFile::getLightCount() const {
+    return header->lightCount;
+}
+
+Light SceneFile::getLight(size_t index) const {
+    const LightRecord& record = lightRecords[index];
+    Light light;
+    light.position = glm::vec4(record.position[0], record.position[1], record.position[2], record.position[3]);
+    light.specular = glm::vec3(record.specular[0], record.specular[1], record.specular[2]);
+    light.diffuse = glm::vec3(record.diffuse[0], record.diffuse[1], record.diffuse[2]);
+    light.ambient = glm::vec3(record.ambient[0], record.ambient[1], record.ambient[2]);
+    light.coneDirection = glm::vec3(record.coneDirection[0], record.coneDirection[1], record.coneDirection[2]);
+    light.radius = record.radius;
+    light.coneAngle = record.coneAngle;
+    return light;
+}
+
+bool SceneFile::getSpawn(SpawnType type, glm::vec3& position, float& rotationY) const {
+    for(size_t i = 0; i < header->spawnCount; i++){
+        if(spawnRecords[i].type != (uint32_t)type) continue;
+        position = glm::vec3(spawnRecords[i].position[0], spawnRecords[i].position[1], spawnRecords[i].position[2]);
+        rotationY = spawnRecords[i].rotationY;
+        return true;
+    }
+    return false;
+}
+
+void SceneFile::addProps(EntityStore& entities, const std::vector<Model*>& models) const {
+    entities.reserve(entities.size() + header->propCount);
+    for(size_t i = 0; i < header->propCount; i++){
+        const PropRecord& prop = propRecords[i];
+        entities.add(models[prop.model],
+                glm::vec3(prop.position[0], prop.position[1], prop.position[2]),
+                glm::vec3(prop.scale[0], prop.scale[1], prop.scale[2]),
+                glm::vec3(prop.rotation[0], prop.rotation[1], prop.rotation[2]),
+                (unsigned char)prop.flags);
+    }
+}
+
+void SceneFile::save(std::string filename, const EntityStore& entities, const std::vector<std::string>& modelFiles,
+        const std::vector<Model*>& models, const std::vector<Light*>& lights, const std::vector<SpawnRecord>& spawns){
+    std::vector<ModelRecord> modelRecords(modelFiles.size());
+    for(size_t i = 0; i < modelFiles.size(); i++){
+        if(modelFiles[i].size() >= MAX_PATH_LENGTH){
+            std::cerr << "[SceneFile] Model path too long: " << modelFiles[i] << std::endl;
+            exit(1);
+        }
+        memset(modelRecords[i].path, 0, MAX_PATH_LENGTH);
+        memcpy(modelRecords[i].path, modelFiles[i].c_str(), modelFiles[i].size());
+    }
+
+    std::vector<PropRecord> propRecords;
+    for(EntityHandle handle = 0; handle < entities.size(); handle++){
+        if(entities.hasBehaviour(handle)) continue;
+        size_t model = 0;
+        while(model < models.size() && models[model] != entities.getModel(handle)) model++;
+        if(model == models.size()) continue;
+
+        glm::vec3 position = entities.getPosition(handle);
+        glm::vec3 rotation = entities.getRotation(handle);
+        glm::vec3 scale = entities.getScale(handle);
+        PropRecord prop;
+        prop.model = model;
+        prop.flags = entities.getFlags(handle);
+        for(int c = 0; c < 3; c++){
+            prop.position[c] = position[c];
+            prop.rotation[c] = rotation[c];
+            prop.scale[c] = scale[c];
+        }
+        propRecords.push_back(prop);
+    }
+
+    std::vector<LightRecord> lightRecords(lights.size());
+    for(size_t i = 0; i < lights.size(); i++){
+        const Light* light = lights[i];
+        LightRecord& record = lightRecords[i];
+        for(int c = 0; c < 4; c++){
+            record.position[c] = light->position[c];
+        }
+        for(int c = 0; c < 3; c++){
+            record.specular[c] = light->specular[c];
+            record.diffuse[c] = light->diffuse[c];
+            record.ambient[c] = light->ambient[c];
+            record.coneDirection[c] = light->coneDirection[c];
+        }
+        record.radius = light->radius;
+        record.coneAngle = light->coneAngle;
+    }
+
+    Header header;
+    memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+    header.version = VERSION;
+    header.modelCount = modelRecords.size();
+    header.propCount = propRecords.size();
+    header.lightCount = lightRecords.size();
+    header.spawnCount = spawns.size();
+
+    FILE* file = fopen(filename.c_str(), "wb");
+    if(file == NULL){
+        std::cerr << "[SceneFile] Failed to open " << filename << " for writing" << std::endl;
+        exit(1);
+    }
+    bool written = fwrite(&header, sizeof(Header), 1, file) == 1;
+    written &= writeRecords(file, modelRecords);
+    written &= writeRecords(file, propRecords);
+    written &= writeRecords(file, lightRecords);
+    written &= writeRecords(file, spawns);
+    written &= fclose(file) == 0;
+    if(!written){
+        std::cerr << "[SceneFile] Failed to write " << filename << std::endl;
+        exit(1);
+    }
+}
+
+SceneFile::SpawnRecord SceneFile::makeSpawn(SpawnType type, glm::vec3 position, float rotationY){
+    SpawnRecord spawn;
+    spawn.type = type;
+    spawn.position[0] = position.x;
+    spawn.position[1] = position.y;
+    spawn.position[2] = position.z;
+    spawn.rotationY = rotationY;
+    return spawn;
+}
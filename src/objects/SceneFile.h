@@ -0,0 +1,118 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "EntityStore.h"
+#include "Light.h"
+#include "../utils/Model.h"
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/*
+    Binary description of a scene: the model files it uses, every prop's transform, the world lights and the spawn
+    points. Loading one instead of placing props at random makes every run render exactly the same scene.
+
+    Layout, all little endian and tightly packed, each record type follows the previous one:
+        Header
+        ModelRecord[modelCount]     # model file paths, relative to the working directory
+        PropRecord[propCount]       # final transforms, props are not placed on the terrain again
+        LightRecord[lightCount]
+        SpawnRecord[spawnCount]
+
+    The file is mapped into memory rather than read, and the records are used in place.
+*/
+class SceneFile {
+public:
+    static const uint32_t VERSION;
+    static const int MAX_PATH_LENGTH = 128;
+
+    enum SpawnType {
+        PLAYER_SPAWN = 0,
+        CAMERA_SPAWN = 1    // Where the standing camera is put
+    };
+
+    struct Header {
+        char magic[4];      // "WWSC"
+        uint32_t version;
+        uint32_t modelCount;
+        uint32_t propCount;
+        uint32_t lightCount;
+        uint32_t spawnCount;
+    };
+
+    struct ModelRecord {
+        char path[MAX_PATH_LENGTH];     // Zero terminated
+    };
+
+    struct PropRecord {
+        uint32_t model;     // Index into the model records
+        uint32_t flags;     // EntityStore::Flags
+        float position[3];
+        float rotation[3];
+        float scale[3];
+    };
+
+    struct LightRecord {
+        float position[4];  // w = 0 - directional
+        float specular[3];
+        float diffuse[3];
+        float ambient[3];
+        float coneDirection[3];
+        float radius;
+        float coneAngle;
+    };
+
+    struct SpawnRecord {
+        uint32_t type;      // SpawnType
+        float position[3];
+        float rotationY;
+    };
+
+private:
+    void* mapping;
+    size_t mappingSize;
+    const Header* header;
+    const ModelRecord* modelRecords;
+    const PropRecord* propRecords;
+    const LightRecord* lightRecords;
+    const SpawnRecord* spawnRecords;
+
+    SceneFile(const SceneFile&);
+    SceneFile& operator=(const SceneFile&);
+
+public:
+    SceneFile();
+    ~SceneFile();
+
+    // Maps the file, exits if it cannot be read or is not a scene file of this version.
+    void load(std::string filename);
+
+    size_t getModelCount() const;
+    std::string getModelPath(size_t index) const;
+    size_t getPropCount() const;
+    const PropRecord* getProps() const;
+    size_t getLightCount() const;
+    Light getLight(size_t index) const;
+    // False if the file has no spawn point of this type.
+    bool getSpawn(SpawnType type, glm::vec3& position, float& rotationY) const;
+
+    // Adds every prop to the store, models[i] being the loaded model of the i-th model record.
+    void addProps(EntityStore& entities, const std::vector<Model*>& models) const;
+
+    // Writes the plain props of the store, those with a model in models, along with the given lights and spawns.
+    static void save(std::string filename, const EntityStore& entities, const std::vector<std::string>& modelFiles,
+            const std::vector<Model*>& models, const std::vector<Light*>& lights,
+            const std::vector<SpawnRecord>& spawns);
+    static SpawnRecord makeSpawn(SpawnType type, glm::vec3 position, float rotationY);
+};
+
+#endif //SCENE_FILE_H
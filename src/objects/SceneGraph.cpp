@@ -0,0 +1,136 @@
+#include "SceneGraph.h"
+
+#include "../utils/Profiler.h"
+
+const SceneNode SceneGraph::NO_PARENT = -1;
+
+SceneGraph::SceneGraph(){
+}
+
+SceneNode SceneGraph::createNode(SceneNode parent, glm::mat4 local){
+    assert(parent < (SceneNode)parents.size());
+    parents.push_back(parent);
+    locals.push_back(local);
+    worlds.push_back(local);
+    dirty.push_back(true);
+    changed.push_back(false);
+    return parents.size() - 1;
+}
+
+size_t SceneGraph::size() const {
+    return parents.size();
+}
+
+void SceneGraph::setLocal(SceneNode node, const glm::mat4& local){
+    locals[node] = local;
+    dirty[node] = true;
+}
+
+const glm::mat4& SceneGraph::getLocal(SceneNode node) const {
+    return locals[node];
+}
+
+const glm::mat4& SceneGraph::getWorld(SceneNode node) const {
+    return worlds[node];
+}
+
+glm::vec3 SceneGraph::getWorldPosition(SceneNode node) const {
+    return glm::vec3(worlds[node][3]);
+}
+
+bool SceneGraph::hasChanged(SceneNode node) const {
+    return changed[node];
+}
+
+void SceneGraph::follow(SceneNode node, Entity* entity){
+    Follower follower;
+    follower.node = node;
+    follower.entity = entity;
+    follower.version = entity->getTransformVersion() - 1;   // Picked up on the next update
+    followers.push_back(follower);
+}
+
+void SceneGraph::attachLight(SceneNode node, Light* light, glm::vec3 direction){
+    LightAttachment attachment;
+    attachment.node = node;
+    attachment.light = light;
+    attachment.direction = direction;
+    lights.push_back(attachment);
+    dirty[node] = true;
+}
+
+void SceneGraph::detachLight(Light* light){
+    for(size_t i = 0; i < lights.size(); i++){
+        if(lights[i].light == light){
+            lights.erase(lights.begin() + i);
+            return;
+        }
+    }
+}
+
+void SceneGraph::attachEntity(SceneNode node, EntityStore* store, EntityHandle handle, glm::mat4 offset){
+    EntityAttachment attachment;
+    attachment.node = node;
+    attachment.store = store;
+    attachment.handle = handle;
+    attachment.offset = offset;
+    entities.push_back(attachment);
+    dirty[node] = true;
+}
+
+void SceneGraph::attachCamera(SceneNode node, Camera* camera){
+    CameraAttachment attachment;
+    attachment.node = node;
+    attachment.camera = camera;
+    cameras.push_back(attachment);
+    dirty[node] = true;
+}
+
+void SceneGraph::update(){
+    PROFILE_SCOPE("scene graph");
+    for(size_t i = 0; i < followers.size(); i++){
+        Follower& follower = followers[i];
+        Entity* entity = follower.entity;
+        bool interpolating = entity->isInterpolating();
+        if(!interpolating && entity->getTransformVersion() == follower.version) continue;
+        // Placed where the entity is drawn, between its last two simulation steps
+        float alpha = GameTime::getGameTime()->getAlpha();
+        glm::vec3 angles = entity->getInterpolatedRotation(alpha);
+        glm::mat4 rotation = Entity::calculateRotationMatrix(angles.x, angles.y, angles.z);
+        setLocal(follower.node, Entity::calculateModelMatrix(entity->getInterpolatedPosition(alpha), rotation,
+                                                             glm::vec3(1.0f)));
+        // An in-between transform is picked up again once the entity comes to rest
+        follower.version = interpolating ? entity->getTransformVersion() - 1 : entity->getTransformVersion();
+    }
+
+    // Parents come before their children, so a parent's flag is final by the time its children are visited.
+    for(size_t i = 0; i < parents.size(); i++){
+        SceneNode parent = parents[i];
+        bool parentChanged = parent != NO_PARENT && changed[parent];
+        changed[i] = dirty[i] || parentChanged;
+        if(!changed[i]) continue;
+
+        worlds[i] = parent == NO_PARENT ? locals[i] : worlds[parent] * locals[i];
+        dirty[i] = false;
+    }
+
+    for(size_t i = 0; i < lights.size(); i++){
+        if(!changed[lights[i].node]) continue;
+        const glm::mat4& world = worlds[lights[i].node];
+        lights[i].light->position = glm::vec4(glm::vec3(world[3]), lights[i].light->position.w);
+        if(lights[i].direction != glm::vec3(0.0f)){
+            lights[i].light->coneDirection = glm::normalize(glm::mat3(world) * lights[i].direction);
+        }
+    }
+    for(size_t i = 0; i < entities.size(); i++){
+        if(!changed[entities[i].node]) continue;
+        entities[i].store->setWorldMatrix(entities[i].handle, worlds[entities[i].node] * entities[i].offset);
+    }
+    for(size_t i = 0; i < cameras.size(); i++){
+        if(!changed[cameras[i].node]) continue;
+        const glm::mat4& world = worlds[cameras[i].node];
+        glm::vec3 position = glm::vec3(world[3]);
+        cameras[i].camera->setPosition(position);
+        cameras[i].camera->look(position + glm::vec3(world[2]));
+    }
+}
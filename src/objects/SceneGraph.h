@@ -0,0 +1,95 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Entity.h"
+#include "EntityStore.h"
+#include "Light.h"
+#include "Camera.h"
+#include "../utils/GameTime.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+typedef int SceneNode;
+
+/*
+    Parent / child transform hierarchy for things that move together, e.g. lights attached to the car.
+
+    Nodes live in flat arrays and a parent is always created before its children, so the arrays are in topological
+    order and update() is one pass front to back. Only nodes whose own transform changed, or whose parent's world
+    transform changed this pass, have their world transform recomputed.
+
+    Lights, cameras and entity store slots can be attached to a node and follow it. A node can in turn follow an
+    Entity, taking its position and rotation (not its scale) whenever the entity moves.
+*/
+class SceneGraph {
+private:
+    struct LightAttachment {
+        SceneNode node;
+        Light* light;
+        glm::vec3 direction;    // Cone direction in node space, zero leaves the light's direction alone
+    };
+
+    struct EntityAttachment {
+        SceneNode node;
+        EntityStore* store;
+        EntityHandle handle;
+        glm::mat4 offset;       // Placed under the node with this transform, including the entity's scale
+    };
+
+    struct CameraAttachment {
+        SceneNode node;
+        Camera* camera;
+    };
+
+    struct Follower {
+        SceneNode node;
+        Entity* entity;
+        unsigned int version;
+    };
+
+    std::vector<SceneNode> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<unsigned char> dirty;
+    std::vector<unsigned char> changed;     // World transform recomputed during the last update()
+
+    std::vector<Follower> followers;
+    std::vector<LightAttachment> lights;
+    std::vector<EntityAttachment> entities;
+    std::vector<CameraAttachment> cameras;
+
+public:
+    static const SceneNode NO_PARENT;
+
+    SceneGraph();
+
+    SceneNode createNode(SceneNode parent = NO_PARENT, glm::mat4 local = glm::mat4(1.0f));
+    size_t size() const;
+
+    void setLocal(SceneNode node, const glm::mat4& local);
+    const glm::mat4& getLocal(SceneNode node) const;
+    // Valid after update().
+    const glm::mat4& getWorld(SceneNode node) const;
+    glm::vec3 getWorldPosition(SceneNode node) const;
+    bool hasChanged(SceneNode node) const;
+
+    void follow(SceneNode node, Entity* entity);
+    void attachLight(SceneNode node, Light* light, glm::vec3 direction = glm::vec3(0.0f));
+    void detachLight(Light* light);
+    void attachEntity(SceneNode node, EntityStore* store, EntityHandle handle, glm::mat4 offset);
+    // The camera looks along the node's +z axis.
+    void attachCamera(SceneNode node, Camera* camera);
+
+    // Propagates changed transforms down the hierarchy, then moves whatever is attached to changed nodes.
+    void update();
+};
+
+#endif //SCENE_GRAPH_H
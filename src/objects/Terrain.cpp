@@ -1,19 +1,33 @@
 #include "Terrain.h"
 
+#include "../utils/Profiler.h"
+
 using namespace std;
 
 const float Terrain::TERRAIN_SIZE = 301.43f;    // Set so that the fences fit better
 const float Terrain::TERRAIN_MAX_HEIGHT = 10.0f;
+const int Terrain::CHUNK_QUADS = 32;
 
 // Constructor accepts a model defining vertex, colour and index data for this Terrain.
-Terrain::Terrain(Model* model, std::vector<GLuint> textures, Image heightMap) :
+Terrain::Terrain(Model* model, std::vector<GLuint> textures, HeightMap heightMap, float size, float maxHeight) :
         Entity(model),
         textures(textures),
-        heightMap(heightMap) {
+        heightMap(heightMap),
+        size(size),
+        maxHeight(maxHeight),
+        dirtyMinX(1), dirtyMinZ(1), dirtyMaxX(0), dirtyMaxZ(0),
+        chunksPerSide(0) {
+    if(heightMap.width > 1){
+        getChunkLayout(heightMap.width, chunks, chunksPerSide);
+        updateChunkBounds(0, 0, heightMap.width - 1, heightMap.height - 1);
+    }
+}
+
+Terrain::~Terrain() {
 }
 
 Terrain* Terrain::loadTerrain(std::vector<std::string> images, std::string heightMapFile){
-    Image heightMap = Loader::getLoader()->loadImage(heightMapFile);
+    HeightMap heightMap = Loader::getLoader()->loadHeightMap(heightMapFile);
     Model* model = Terrain::generateTerrainModel(heightMap);
     std::vector<GLuint> textures;
     for(size_t i =0; i < images.size(); i++){
@@ -23,49 +37,148 @@ Terrain* Terrain::loadTerrain(std::vector<std::string> images, std::string heigh
     return new Terrain(model, textures, heightMap);
 }
 
-Model* Terrain::generateTerrainModel(Image heightMap){
-    std::vector<float> vertices;
-    std::vector<float> textureCoords;
-    std::vector<unsigned int> indices;
-    const int TERRAIN_NUM_VERTS = heightMap.width;
-
-    for(int z_off = 0; z_off < TERRAIN_NUM_VERTS; z_off++){
-        for(int x_off = 0; x_off < TERRAIN_NUM_VERTS; x_off++){
-            glm::vec3 colour = heightMap.getPixel(x_off, z_off);
-            float height = (colour.r + colour.g + colour.b)/3*TERRAIN_MAX_HEIGHT;
-
-            vertices.push_back((float)x_off / ((float)TERRAIN_NUM_VERTS - 1) * TERRAIN_SIZE);
-            vertices.push_back(height);
-            vertices.push_back((float)z_off / ((float)TERRAIN_NUM_VERTS - 1) * TERRAIN_SIZE);
-            textureCoords.push_back((float) x_off /((float)TERRAIN_NUM_VERTS - 1));
-            textureCoords.push_back((float) z_off /((float)TERRAIN_NUM_VERTS - 1));
+// Splits a grid of numVerts^2 vertices into chunks of CHUNK_QUADS^2 quads, the ones along the far edges may be smaller.
+// Chunks are stored row by row and each one takes a contiguous range of the index buffer in the same order.
+void Terrain::getChunkLayout(int numVerts, std::vector<TerrainChunk>& chunks, int& chunksPerSide){
+    const int numQuads = numVerts - 1;
+    chunksPerSide = (numQuads + CHUNK_QUADS - 1) / CHUNK_QUADS;
+    chunks.resize(chunksPerSide * chunksPerSide);
+
+    int indexOffset = 0;
+    for(int cz = 0; cz < chunksPerSide; cz++){
+        for(int cx = 0; cx < chunksPerSide; cx++){
+            TerrainChunk& chunk = chunks[cz * chunksPerSide + cx];
+            chunk.x0 = cx * CHUNK_QUADS;
+            chunk.z0 = cz * CHUNK_QUADS;
+            chunk.x1 = std::min(chunk.x0 + CHUNK_QUADS, numQuads);
+            chunk.z1 = std::min(chunk.z0 + CHUNK_QUADS, numQuads);
+            chunk.indexOffset = indexOffset;
+            chunk.indexCount = (chunk.x1 - chunk.x0) * (chunk.z1 - chunk.z0) * 6;
+            chunk.minHeight = 0.0f;
+            chunk.maxHeight = 0.0f;
+            indexOffset += chunk.indexCount;
         }
     }
+}
 
-    for(int z_off=0; z_off < TERRAIN_NUM_VERTS - 1; z_off++){
-        for(int x_off = 0; x_off < TERRAIN_NUM_VERTS - 1; x_off++){
-            int topLeft = (z_off * TERRAIN_NUM_VERTS) + x_off;
-            int topRight = topLeft + 1;
-            int bottomLeft = ((z_off+1) * TERRAIN_NUM_VERTS) + x_off;
-            int bottomRight = bottomLeft + 1;
-
-            indices.push_back(topLeft);
-            indices.push_back(bottomLeft);
-            indices.push_back(topRight);
-            indices.push_back(topRight);
-            indices.push_back(bottomLeft);
-            indices.push_back(bottomRight);
+// Fills the mesh for a grid of heightMap.width^2 vertices. Rows and then chunks are split across the thread pool,
+// every output array is allocated up front and each row or chunk writes only its own slice, so no locking is needed.
+// Normals come straight from central differences of the heights instead of accumulating face normals.
+void Terrain::buildTerrainMesh(const HeightMap& heightMap, float size, float maxHeight, TerrainMesh& mesh){
+    PROFILE_SCOPE("build terrain mesh");
+    const int TERRAIN_NUM_VERTS = heightMap.width;
+    const size_t numVerts = (size_t)TERRAIN_NUM_VERTS * TERRAIN_NUM_VERTS;
+    const size_t numQuads = (size_t)(TERRAIN_NUM_VERTS - 1) * (TERRAIN_NUM_VERTS - 1);
+    const float spacing = size / ((float)TERRAIN_NUM_VERTS - 1);
+    const float step = 1.0f / ((float)TERRAIN_NUM_VERTS - 1);
+
+    mesh.vertices.resize(numVerts * 3);
+    mesh.normals.resize(numVerts * 3);
+    mesh.textureCoords.resize(numVerts * 2);
+    mesh.indices.resize(numQuads * 6);
+
+    std::vector<float> rowMinHeights(TERRAIN_NUM_VERTS);
+    std::vector<float> rowMaxHeights(TERRAIN_NUM_VERTS);
+
+    ThreadPool::getThreadPool()->parallelFor(0, TERRAIN_NUM_VERTS, [&](int rowBegin, int rowEnd){
+        for(int z_off = rowBegin; z_off < rowEnd; z_off++){
+            const float* row = &heightMap.heights[(size_t)z_off * TERRAIN_NUM_VERTS];
+            const float* rowDown = &heightMap.heights[(size_t)std::max(z_off - 1, 0) * TERRAIN_NUM_VERTS];
+            const float* rowUp = &heightMap.heights[(size_t)std::min(z_off + 1, TERRAIN_NUM_VERTS - 1) * TERRAIN_NUM_VERTS];
+            float* vertices = &mesh.vertices[(size_t)z_off * TERRAIN_NUM_VERTS * 3];
+            float* normals = &mesh.normals[(size_t)z_off * TERRAIN_NUM_VERTS * 3];
+            float* textureCoords = &mesh.textureCoords[(size_t)z_off * TERRAIN_NUM_VERTS * 2];
+
+            const float z = (float)z_off * step * size;
+            const float t = (float)z_off * step;
+            // One sided differences along the edges of the map.
+            const int zSpan = std::min(z_off + 1, TERRAIN_NUM_VERTS - 1) - std::max(z_off - 1, 0);
+            const float dzScale = maxHeight / (zSpan * spacing);
+            const float dxScale = maxHeight / (2.0f * spacing);
+
+            // Straight loops without branches, so the compiler can vectorise them.
+            float rowMin = row[0];
+            float rowMax = row[0];
+            for(int x_off = 0; x_off < TERRAIN_NUM_VERTS; x_off++){
+                float height = row[x_off];
+                rowMin = std::min(rowMin, height);
+                rowMax = std::max(rowMax, height);
+                vertices[3 * x_off] = (float)x_off * step * size;
+                vertices[3 * x_off + 1] = height * maxHeight;
+                vertices[3 * x_off + 2] = z;
+                textureCoords[2 * x_off] = (float)x_off * step;
+                textureCoords[2 * x_off + 1] = t;
+            }
+            rowMinHeights[z_off] = rowMin * maxHeight;
+            rowMaxHeights[z_off] = rowMax * maxHeight;
+
+            for(int x_off = 1; x_off < TERRAIN_NUM_VERTS - 1; x_off++){
+                float dx = (row[x_off + 1] - row[x_off - 1]) * dxScale;
+                float dz = (rowUp[x_off] - rowDown[x_off]) * dzScale;
+                float invLength = 1.0f / std::sqrt(dx * dx + 1.0f + dz * dz);
+                normals[3 * x_off] = -dx * invLength;
+                normals[3 * x_off + 1] = invLength;
+                normals[3 * x_off + 2] = -dz * invLength;
+            }
+            const int edges[2] = {0, TERRAIN_NUM_VERTS - 1};
+            for(int i = 0; i < 2; i++){
+                int x_off = edges[i];
+                int left = std::max(x_off - 1, 0);
+                int right = std::min(x_off + 1, TERRAIN_NUM_VERTS - 1);
+                float dx = (row[right] - row[left]) * maxHeight / ((right - left) * spacing);
+                float dz = (rowUp[x_off] - rowDown[x_off]) * dzScale;
+                glm::vec3 normal = glm::normalize(glm::vec3(-dx, 1.0f, -dz));
+                normals[3 * x_off] = normal.x;
+                normals[3 * x_off + 1] = normal.y;
+                normals[3 * x_off + 2] = normal.z;
+            }
         }
-    }
+    });
+
+    std::vector<TerrainChunk> chunks;
+    int chunksPerSide;
+    getChunkLayout(TERRAIN_NUM_VERTS, chunks, chunksPerSide);
+
+    ThreadPool::getThreadPool()->parallelFor(0, chunks.size(), [&](int chunkBegin, int chunkEnd){
+        for(int c = chunkBegin; c < chunkEnd; c++){
+            const TerrainChunk& chunk = chunks[c];
+            unsigned int* indices = &mesh.indices[chunk.indexOffset];
+            for(int z_off = chunk.z0; z_off < chunk.z1; z_off++){
+                for(int x_off = chunk.x0; x_off < chunk.x1; x_off++){
+                    unsigned int topLeft = (z_off * TERRAIN_NUM_VERTS) + x_off;
+                    unsigned int topRight = topLeft + 1;
+                    unsigned int bottomLeft = ((z_off+1) * TERRAIN_NUM_VERTS) + x_off;
+                    unsigned int bottomRight = bottomLeft + 1;
+
+                    indices[0] = topLeft;
+                    indices[1] = bottomLeft;
+                    indices[2] = topRight;
+                    indices[3] = topRight;
+                    indices[4] = bottomLeft;
+                    indices[5] = bottomRight;
+                    indices += 6;
+                }
+            }
+        }
+    });
+
+    mesh.minHeight = *std::min_element(rowMinHeights.begin(), rowMinHeights.end());
+    mesh.maxHeight = *std::max_element(rowMaxHeights.begin(), rowMaxHeights.end());
+}
 
-    std::vector<float> normals =  Loader::getLoader()->generateNormals(vertices, indices);
+Model* Terrain::generateTerrainModel(const HeightMap& heightMap, float size, float maxHeight){
+    PROFILE_SCOPE("generate terrain model");
+    TerrainMesh mesh;
+    buildTerrainMesh(heightMap, size, maxHeight, mesh);
 
-    GLuint vao = Loader::getLoader()->loadVAO(vertices, indices, textureCoords, normals);
+    GLuint vao = Loader::getLoader()->loadVAO(&mesh.vertices[0], mesh.vertices.size() / 3,
+            &mesh.indices[0], mesh.indices.size(), &mesh.textureCoords[0], &mesh.normals[0]);
     GLuint tex = Loader::getLoader()->loadDefaultTexture();
 
-    ModelComponent component(vao, indices.size(), tex);
+    ModelComponent component(vao, mesh.indices.size(), tex);
     Model* model = new Model();
-    model->addRange(vertices);
+    // Two opposite corners are enough for the bounding box.
+    model->addRange({0.0f, mesh.minHeight, 0.0f, size, mesh.maxHeight, size});
     model->addModelComponent(component);
 
     return model;
@@ -102,28 +215,129 @@ int Terrain::getIndexCount(){
 GLuint Terrain::getTextureID(int i){
     return textures[i];
 }
+
+float Terrain::getSize() const {
+    return size;
+}
+
+const HeightMap& Terrain::getHeightMap() const {
+    return heightMap;
+}
+
+const std::vector<TerrainChunk>& Terrain::getChunks() const {
+    return chunks;
+}
+
+// World space bounding box of a chunk
+void Terrain::getChunkBounds(int index, glm::vec3& min, glm::vec3& max){
+    const TerrainChunk& chunk = chunks[index];
+    float spacing = size / (heightMap.width - 1);
+    min = position + glm::vec3(chunk.x0 * spacing, chunk.minHeight, chunk.z0 * spacing);
+    max = position + glm::vec3(chunk.x1 * spacing, chunk.maxHeight, chunk.z1 * spacing);
+}
+
+// Recomputes the height bounds of all chunks overlapping the given samples.
+void Terrain::updateChunkBounds(int x0, int z0, int x1, int z1){
+    for(size_t i = 0; i < chunks.size(); i++){
+        TerrainChunk& chunk = chunks[i];
+        if(chunk.x1 < x0 || chunk.x0 > x1 || chunk.z1 < z0 || chunk.z0 > z1) continue;
+
+        float minHeight = heightMap.getSample(chunk.x0, chunk.z0);
+        float maxHeight = minHeight;
+        for(int z_off = chunk.z0; z_off <= chunk.z1; z_off++){
+            for(int x_off = chunk.x0; x_off <= chunk.x1; x_off++){
+                float height = heightMap.heights[z_off * heightMap.width + x_off];
+                minHeight = std::min(minHeight, height);
+                maxHeight = std::max(maxHeight, height);
+            }
+        }
+        chunk.minHeight = minHeight * this->maxHeight;
+        chunk.maxHeight = maxHeight * this->maxHeight;
+    }
+}
+
+// Walks the chunk grid from one point to the other in terrain local coordinates. The terrain surface inside a chunk
+// never dips below the chunk's lowest sample, so a ray passing under that height somewhere in the chunk hits the ground.
+bool Terrain::isRayBlocked(glm::vec3 from, glm::vec3 to, int targetChunk){
+    glm::vec2 start(from.x, from.z);
+    glm::vec2 direction = glm::vec2(to.x, to.z) - start;
+    float length = glm::length(direction);
+    if(length <= 0.0f) return false;
+    direction /= length;
+
+    float chunkSize = CHUNK_QUADS * size / (heightMap.width - 1);
+    float step = chunkSize * 0.5f;
+    float slope = (to.y - from.y) / length;
+    // The ray may rise across the rest of the chunk after the sample point, allow for the chunk diagonal.
+    float slack = std::abs(slope) * chunkSize * 1.42f;
+
+    for(float t = step; t < length; t += step){
+        glm::vec2 point = start + direction * t;
+        int cx = (int)std::floor(point.x / chunkSize);
+        int cz = (int)std::floor(point.y / chunkSize);
+        if(cx < 0 || cx >= chunksPerSide || cz < 0 || cz >= chunksPerSide) continue;
+
+        int chunk = cz * chunksPerSide + cx;
+        if(chunk == targetChunk) break;
+        if(chunks[chunk].minHeight > from.y + slope * t + slack){
+            return true;
+        }
+    }
+    return false;
+}
+
+// Tests rays from the eye to the top of the chunk at its closest point and at its corners. Only when all of them
+// are blocked is the chunk treated as hidden, which misses some hidden chunks but hides visible ones very rarely.
+bool Terrain::isChunkBehindHorizon(int index, glm::vec3 eye){
+    const TerrainChunk& chunk = chunks[index];
+    float spacing = size / (heightMap.width - 1);
+    glm::vec3 local = eye - position;
+    glm::vec2 min(chunk.x0 * spacing, chunk.z0 * spacing);
+    glm::vec2 max(chunk.x1 * spacing, chunk.z1 * spacing);
+    glm::vec2 eye2(local.x, local.z);
+
+    if(eye2.x >= min.x && eye2.x <= max.x && eye2.y >= min.y && eye2.y <= max.y){
+        return false;
+    }
+
+    glm::vec2 targets[5] = {
+            glm::clamp(eye2, min, max),
+            min,
+            glm::vec2(max.x, min.y),
+            glm::vec2(min.x, max.y),
+            max
+    };
+    for(int i = 0; i < 5; i++){
+        if(!isRayBlocked(local, glm::vec3(targets[i].x, chunk.maxHeight, targets[i].y), index)){
+            return false;
+        }
+    }
+    return true;
+}
+
+void Terrain::collectTiles(std::vector<Terrain*>& tiles){
+    tiles.push_back(this);
+}
+
 float Terrain::getHeight(float x, float z){
     int x_int = convertCoordinate(x);
     int z_int = convertCoordinate(z);
-    glm::vec3 pixel = heightMap.getPixel(x_int,z_int);
 
-    return (pixel.r + pixel.g + pixel.b)/3*TERRAIN_MAX_HEIGHT;
+    return heightMap.getSample(x_int,z_int)*maxHeight;
 }
 
 // Assumes already translated coordinates
 float Terrain::getHeight(int x_int, int z_int){
-    glm::vec3 pixel = heightMap.getPixel(x_int,z_int);
-
-    return (pixel.r + pixel.g + pixel.b)/3*TERRAIN_MAX_HEIGHT;
+    return heightMap.getSample(x_int,z_int)*maxHeight;
 }
 
 int Terrain::convertCoordinate(float coord){
-    return int((heightMap.width/2) + coord*heightMap.width/TERRAIN_SIZE);
+    return int((heightMap.width/2) + coord*heightMap.width/size);
 }
 
 glm::vec3 Terrain::getPositionFromPixel(int x, int y){
-    float x_flt = ((float)(x - heightMap.width/2))/heightMap.width * TERRAIN_SIZE;
-    float z_flt = ((float)(y - heightMap.height/2))/heightMap.height * TERRAIN_SIZE;
+    float x_flt = ((float)(x - heightMap.width/2))/heightMap.width * size;
+    float z_flt = ((float)(y - heightMap.height/2))/heightMap.height * size;
 
     return glm::vec3(x_flt, 0.0f, z_flt);
 }
@@ -179,5 +393,147 @@ float Terrain::getAngle(float x, float z, float rotation, float offset){
         h_nxt = getHeight(x_cur + x_nxt*i, z_cur+ z_nxt*i);
     }
 
-    return glm::atan((h_nxt - h_cur)/((float)LOOK_AHEAD * TERRAIN_SIZE / heightMap.width));
+    return glm::atan((h_nxt - h_cur)/((float)LOOK_AHEAD * size / heightMap.width));
+}
+
+// Normal from central differences of the neighbouring samples, clamped at the edges of the map.
+glm::vec3 Terrain::calculateNormal(int x, int z){
+    int left = std::max(x - 1, 0);
+    int right = std::min(x + 1, heightMap.width - 1);
+    int down = std::max(z - 1, 0);
+    int up = std::min(z + 1, heightMap.height - 1);
+    float spacing = size / (heightMap.width - 1);
+
+    float dx = (heightMap.getSample(right, z) - heightMap.getSample(left, z)) * maxHeight / ((right - left) * spacing);
+    float dz = (heightMap.getSample(x, up) - heightMap.getSample(x, down)) * maxHeight / ((up - down) * spacing);
+
+    return glm::normalize(glm::vec3(-dx, 1.0f, -dz));
+}
+
+void Terrain::markDirty(int x0, int z0, int x1, int z1){
+    if(dirtyMinX > dirtyMaxX){
+        dirtyMinX = x0;
+        dirtyMinZ = z0;
+        dirtyMaxX = x1;
+        dirtyMaxZ = z1;
+        return;
+    }
+    dirtyMinX = std::min(dirtyMinX, x0);
+    dirtyMinZ = std::min(dirtyMinZ, z0);
+    dirtyMaxX = std::max(dirtyMaxX, x1);
+    dirtyMaxZ = std::max(dirtyMaxZ, z1);
+}
+
+// Height in world units of the sample at (x, z)
+void Terrain::setHeight(int x, int z, float height){
+    if(x < 0 || x >= heightMap.width || z < 0 || z >= heightMap.height){
+        return;
+    }
+    heightMap.heights[z * heightMap.width + x] = height / maxHeight;
+    markDirty(x, z, x, z);
+}
+
+// Lowers the terrain in a smooth bowl around (x, z), deepening it on every call.
+void Terrain::addCrater(float x, float z, float radius, float depth){
+    int x_mid = convertCoordinate(x);
+    int z_mid = convertCoordinate(z);
+    int reach = (int)std::ceil(radius * heightMap.width / size);
+
+    int x0 = std::max(x_mid - reach, 0);
+    int x1 = std::min(x_mid + reach, heightMap.width - 1);
+    int z0 = std::max(z_mid - reach, 0);
+    int z1 = std::min(z_mid + reach, heightMap.height - 1);
+    if(x0 > x1 || z0 > z1) return;
+
+    for(int z_off = z0; z_off <= z1; z_off++){
+        for(int x_off = x0; x_off <= x1; x_off++){
+            float distance = glm::length(glm::vec2(x_off - x_mid, z_off - z_mid)) / reach;
+            if(distance >= 1.0f) continue;
+            float falloff = (1.0f - distance * distance) * (1.0f - distance * distance);
+            heightMap.heights[z_off * heightMap.width + x_off] -= depth * falloff / maxHeight;
+        }
+    }
+    markDirty(x0, z0, x1, z1);
+}
+
+// Presses the terrain down to at most depth below its original height, so driving the same track
+// again does not dig any deeper.
+void Terrain::addRut(float x, float z, float radius, float depth){
+    if(originalHeights.empty()){
+        originalHeights = heightMap.heights;
+    }
+
+    int x_mid = convertCoordinate(x);
+    int z_mid = convertCoordinate(z);
+    int reach = std::max((int)std::ceil(radius * heightMap.width / size), 1);
+
+    int x0 = std::max(x_mid - reach, 0);
+    int x1 = std::min(x_mid + reach, heightMap.width - 1);
+    int z0 = std::max(z_mid - reach, 0);
+    int z1 = std::min(z_mid + reach, heightMap.height - 1);
+    if(x0 > x1 || z0 > z1) return;
+
+    bool changed = false;
+    for(int z_off = z0; z_off <= z1; z_off++){
+        for(int x_off = x0; x_off <= x1; x_off++){
+            float distance = glm::length(glm::vec2(x_off - x_mid, z_off - z_mid)) / reach;
+            if(distance >= 1.0f) continue;
+            int i = z_off * heightMap.width + x_off;
+            float target = originalHeights[i] - depth * (1.0f - distance) / maxHeight;
+            if(heightMap.heights[i] > target){
+                heightMap.heights[i] = target;
+                changed = true;
+            }
+        }
+    }
+    if(changed){
+        markDirty(x0, z0, x1, z1);
+    }
+}
+
+void Terrain::flushDeformations(){
+    PROFILE_SCOPE("terrain deformations");
+    if(dirtyMinX > dirtyMaxX) return;
+
+    // Normals depend on the neighbours, so the border around the edit changes as well.
+    int x0 = std::max(dirtyMinX - 1, 0);
+    int x1 = std::min(dirtyMaxX + 1, heightMap.width - 1);
+    int z0 = std::max(dirtyMinZ - 1, 0);
+    int z1 = std::min(dirtyMaxZ + 1, heightMap.height - 1);
+    dirtyMinX = 1;
+    dirtyMaxX = 0;
+
+    updateChunkBounds(x0, z0, x1, z1);
+
+    if(model == NULL) return;   // Height data only, nothing to upload
+
+    GLuint vao = getVaoID();
+    GLuint positionBuffer = Loader::getLoader()->getVertexBuffer(vao, 0);
+    GLuint normalBuffer = Loader::getLoader()->getVertexBuffer(vao, 1);
+
+    const int rowLength = x1 - x0 + 1;
+    uploadPositions.resize(rowLength * 3);
+    uploadNormals.resize(rowLength * 3);
+    std::vector<float>& positions = uploadPositions;
+    std::vector<float>& normals = uploadNormals;
+    for(int z_off = z0; z_off <= z1; z_off++){
+        for(int x_off = x0; x_off <= x1; x_off++){
+            int i = (x_off - x0) * 3;
+            glm::vec3 normal = calculateNormal(x_off, z_off);
+            positions[i] = (float)x_off / ((float)heightMap.width - 1) * size;
+            positions[i + 1] = heightMap.getSample(x_off, z_off) * maxHeight;
+            positions[i + 2] = (float)z_off / ((float)heightMap.width - 1) * size;
+            normals[i] = normal.x;
+            normals[i + 1] = normal.y;
+            normals[i + 2] = normal.z;
+        }
+
+        // Vertices are stored row by row, so each row of the rectangle is one contiguous range.
+        GLintptr offset = sizeof(float) * 3 * ((GLintptr)z_off * heightMap.width + x0);
+        glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(float) * positions.size(), &positions[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(float) * normals.size(), &normals[0]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
@@ -11,38 +11,118 @@
 #include "../utils/Model.h"
 #include "Entity.h"
 #include "../utils/Loader.h"
+#include "../utils/ThreadPool.h"
 
 #include <assert.h>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <memory>
+#include <utility>
 #include <glm/ext.hpp>
 
+// Allocator whose resize() leaves new elements uninitialised. Large meshes are then first touched by the threads
+// filling them instead of being zeroed on one thread beforehand, which would cost more than building them.
+template <typename T>
+struct UninitialisedAllocator : std::allocator<T> {
+    template <typename U> struct rebind { typedef UninitialisedAllocator<U> other; };
+
+    UninitialisedAllocator() {}
+    template <typename U> UninitialisedAllocator(const UninitialisedAllocator<U>&) {}
+
+    template <typename U> void construct(U* p) { ::new((void*)p) U; }
+    template <typename U, typename... Args> void construct(U* p, Args&&... args) {
+        ::new((void*)p) U(std::forward<Args>(args)...);
+    }
+};
+
+// CPU side terrain geometry, laid out the way Loader::loadVAO expects it.
+struct TerrainMesh {
+    std::vector<float, UninitialisedAllocator<float> > vertices;
+    std::vector<float, UninitialisedAllocator<float> > normals;
+    std::vector<float, UninitialisedAllocator<float> > textureCoords;
+    std::vector<unsigned int, UninitialisedAllocator<unsigned int> > indices;
+    float minHeight;
+    float maxHeight;
+};
+
+// Square block of the terrain grid whose triangles are stored next to each other in the index buffer,
+// so that any set of visible chunks can be drawn with one multi-draw call.
+struct TerrainChunk {
+    int indexOffset;            // First index of the chunk in the index buffer
+    int indexCount;
+    int x0, z0, x1, z1;         // Samples covered, inclusive
+    float minHeight, maxHeight; // Bounds in world units
+};
+
 class Terrain : public Entity{
 protected:
     std::vector<GLuint> textures;
-    Image heightMap;
+    HeightMap heightMap;
+
+    float size;         // Side length in world units
+    float maxHeight;    // World height of a sample equal to 1.0
+
+    // Samples changed since the last flushDeformations(), inclusive. Empty when dirtyMinX > dirtyMaxX.
+    int dirtyMinX, dirtyMinZ, dirtyMaxX, dirtyMaxZ;
+    std::vector<float> originalHeights; // Copied on the first rut, so ruts do not dig deeper on every pass
+    std::vector<float> uploadPositions; // Row scratch for flushDeformations(), kept to avoid allocating per edit
+    std::vector<float> uploadNormals;
+
+    std::vector<TerrainChunk> chunks;
+    int chunksPerSide;
+
+    void markDirty(int x0, int z0, int x1, int z1);
+    glm::vec3 calculateNormal(int x, int z);
+    void updateChunkBounds(int x0, int z0, int x1, int z1);
+    bool isRayBlocked(glm::vec3 from, glm::vec3 to, int targetChunk);
 
 public:
     static const float TERRAIN_SIZE;
     static const float TERRAIN_MAX_HEIGHT;
+    static const int CHUNK_QUADS;   // Quads along the side of a chunk
 
-    Terrain(Model* model, std::vector<GLuint> textures, Image heightMap);
+    Terrain(Model* model, std::vector<GLuint> textures, HeightMap heightMap,
+            float size = TERRAIN_SIZE, float maxHeight = TERRAIN_MAX_HEIGHT);
+    virtual ~Terrain();
     static Terrain* loadTerrain(std::vector<std::string> images, std::string heightMapFile);
-    static Model* generateTerrainModel(Image heightMap);
+    static void getChunkLayout(int numVerts, std::vector<TerrainChunk>& chunks, int& chunksPerSide);
+    static void buildTerrainMesh(const HeightMap& heightMap, float size, float maxHeight, TerrainMesh& mesh);
+    static Model* generateTerrainModel(const HeightMap& heightMap, float size = TERRAIN_SIZE,
+            float maxHeight = TERRAIN_MAX_HEIGHT);
 
     GLuint getVaoID();
     int getIndexCount();
     GLuint getTextureID(int);
-    bool isOnTerrain(float x, float z);
-    float getHeight(float x, float z);
+    float getSize() const;
+    const HeightMap& getHeightMap() const;
+    const std::vector<TerrainChunk>& getChunks() const;
+    void getChunkBounds(int index, glm::vec3& min, glm::vec3& max);
+    // True when the terrain between the eye and the chunk certainly hides all of it.
+    bool isChunkBehindHorizon(int index, glm::vec3 eye);
+
+    // Terrains that should be drawn this frame. A plain terrain is a single piece,
+    // streamed worlds return their resident tiles.
+    virtual void collectTiles(std::vector<Terrain*>& tiles);
+
+    virtual bool isOnTerrain(float x, float z);
+    virtual float getHeight(float x, float z);
     float getHeight(int x, int z);
     int convertCoordinate(float coord);
 
-    glm::vec3 getPositionFromPixel(int x, int y);
+    virtual glm::vec3 getPositionFromPixel(int x, int y);
 
     float getAngleX(float x, float y, float rotation);
     float getAngleZ(float x, float y, float rotation);
-    float getAngle(float x, float y, float rotation, float offset);
+    virtual float getAngle(float x, float y, float rotation, float offset);
+
+    // Runtime deformation. Edits only touch the CPU height grid and grow a dirty rectangle,
+    // flushDeformations() then recomputes the normals of that rectangle plus a one sample border
+    // and uploads just those rows of the vertex buffers. Call it once per frame after all edits.
+    void setHeight(int x, int z, float height);
+    virtual void addCrater(float x, float z, float radius, float depth);
+    virtual void addRut(float x, float z, float radius, float depth);
+    virtual void flushDeformations();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,433 @@
+#include "TerrainStreamer.h"
+
+#include "../utils/Profiler.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+
+const int TerrainStreamer::NUM_WORKERS = 2;
+
+// Tiles are only unloaded once they are this much further than the load radius, so that driving along
+// a tile border does not load and unload the same tiles every frame.
+const float UNLOAD_HYSTERESIS = 1.25f;
+// Meshes built per frame, to spread the upload cost when many tiles arrive at once.
+const int MAX_MESHES_PER_FRAME = 2;
+
+TerrainStreamer::Tile::Tile()
+        : state(UNLOADED), terrain(NULL), bytes(0), lastUsedFrame(0) {
+}
+
+TerrainStreamer::TerrainStreamer(std::string manifestFile, std::vector<GLuint> textures) :
+        Terrain(NULL, textures, HeightMap()),
+        tilesX(0),
+        tilesZ(0),
+        tileSize(TERRAIN_SIZE),
+        loadRadius(TERRAIN_SIZE),
+        budgetBytes(256 * 1024 * 1024),
+        residentBytes(0),
+        tileSamples(-1),
+        frame(0),
+        waitForTiles(true),
+        stopping(false) {
+    std::ifstream manifest(manifestFile);
+    if(!manifest.is_open()){
+        std::cerr << "[TerrainStreamer] Cannot open world manifest " << manifestFile << ", exiting" << std::endl;
+        exit(1);
+    }
+    directory = manifestFile.substr(0, manifestFile.find_last_of("\\/") + 1);
+
+    std::string line;
+    while(std::getline(manifest, line)){
+        line = line.substr(0, line.find('#'));
+        std::istringstream values(line);
+        std::string key;
+        if(!(values >> key)) continue;
+
+        if(key == "tiles"){
+            values >> tilesX >> tilesZ;
+        } else if(key == "tile_size"){
+            values >> tileSize;
+        } else if(key == "max_height"){
+            values >> maxHeight;
+        } else if(key == "pattern"){
+            values >> pattern;
+        } else if(key == "load_radius"){
+            values >> loadRadius;
+        } else if(key == "budget_mb"){
+            size_t megabytes;
+            values >> megabytes;
+            budgetBytes = megabytes * 1024 * 1024;
+        } else {
+            std::cerr << "[TerrainStreamer] Unknown manifest entry '" << key << "', ignoring" << std::endl;
+        }
+    }
+
+    if(tilesX <= 0 || tilesZ <= 0 || pattern.empty()){
+        std::cerr << "[TerrainStreamer][Error] Manifest " << manifestFile << " needs 'tiles' and 'pattern'." << std::endl;
+        exit(1);
+    }
+
+    size = tilesX * tileSize;
+    tiles.resize(tilesX * tilesZ);
+
+    // The workers read tiles through the Loader, which exits on a missing file. That should happen here rather
+    // than on a worker thread in the middle of a drive.
+    for(size_t i = 0; i < tiles.size(); i++){
+        std::ifstream tileFile(getTilePath(i));
+        if(!tileFile.is_open()){
+            std::cerr << "[TerrainStreamer][Error] Tile " << i % tilesX << ", " << i / tilesX << " of " << manifestFile
+                      << " is missing: " << getTilePath(i) << std::endl;
+            exit(1);
+        }
+    }
+    for(int i = 0; i < NUM_WORKERS; i++){
+        workers.push_back(std::thread(&TerrainStreamer::workerLoop, this));
+    }
+}
+
+TerrainStreamer::~TerrainStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    requestsChanged.notify_all();
+    for(size_t i = 0; i < workers.size(); i++){
+        workers[i].join();
+    }
+    for(size_t i = 0; i < tiles.size(); i++){
+        unload(i);
+    }
+}
+
+void TerrainStreamer::workerLoop() {
+    PROFILE_THREAD_NAME("terrain streamer");
+    while(true){
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            requestsChanged.wait(lock, [this]{ return stopping || !requests.empty(); });
+            if(stopping) return;
+            index = requests.front();
+            requests.pop_front();
+        }
+
+        // The expensive part runs without holding the lock.
+        PROFILE_SCOPE("load tile");
+        LoadedTile loaded;
+        loaded.index = index;
+        loaded.heights = Loader::getLoader()->loadHeightMap(getTilePath(index));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed.push_back(loaded);
+        }
+        tileCompleted.notify_all();
+    }
+}
+
+std::string TerrainStreamer::getTilePath(int index) {
+    char name[256];
+    snprintf(name, sizeof(name), pattern.c_str(), index % tilesX, index / tilesX);
+    return directory + name;
+}
+
+int TerrainStreamer::getTileIndex(float x, float z) {
+    int tileX = (int)std::floor((x + tilesX * tileSize / 2) / tileSize);
+    int tileZ = (int)std::floor((z + tilesZ * tileSize / 2) / tileSize);
+    if(tileX < 0 || tileX >= tilesX || tileZ < 0 || tileZ >= tilesZ){
+        return -1;
+    }
+    return tileZ * tilesX + tileX;
+}
+
+// Corner of the tile with the smallest coordinates, which is where its terrain model starts.
+glm::vec3 TerrainStreamer::getTileOrigin(int index) {
+    return glm::vec3(-tilesX * tileSize / 2 + (index % tilesX) * tileSize,
+                     0.0f,
+                     -tilesZ * tileSize / 2 + (index / tilesX) * tileSize);
+}
+
+float TerrainStreamer::getDistanceToTile(int index, glm::vec3 point) {
+    glm::vec3 origin = getTileOrigin(index);
+    float dx = std::max(std::max(origin.x - point.x, 0.0f), point.x - (origin.x + tileSize));
+    float dz = std::max(std::max(origin.z - point.z, 0.0f), point.z - (origin.z + tileSize));
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+// Queues the tile for the workers. When waiting for tiles it goes first, as the caller is blocked on it.
+void TerrainStreamer::requestTile(int index) {
+    Tile& tile = tiles[index];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(tile.state == UNLOADED){
+            tile.state = QUEUED;
+            if(waitForTiles) requests.push_front(index);
+            else requests.push_back(index);
+        } else if(waitForTiles){
+            // Still queued rather than being read by a worker
+            std::deque<int>::iterator queued = std::find(requests.begin(), requests.end(), index);
+            if(queued != requests.end()){
+                requests.erase(queued);
+                requests.push_front(index);
+            }
+        }
+    }
+    requestsChanged.notify_all();
+}
+
+// Takes the height data the workers have read since the last call.
+void TerrainStreamer::addCompletedTiles() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.swap(completed);
+    }
+    for(size_t i = 0; i < finished.size(); i++){
+        Tile& tile = tiles[finished[i].index];
+        // Cancelled in the meantime
+        if(tile.state != QUEUED) continue;
+
+        tile.terrain = new Terrain(NULL, textures, finished[i].heights, tileSize, maxHeight);
+        tile.terrain->setPosition(getTileOrigin(finished[i].index));
+        tile.bytes = finished[i].heights.getByteSize();
+        tile.state = HEIGHTS;
+        residentBytes += tile.bytes;
+        if(tileSamples < 0) tileSamples = finished[i].heights.width;
+    }
+    finished.clear();
+}
+
+// Returns the tile if its height data is resident, otherwise requests it and returns NULL. Waiting for tiles, it
+// blocks until a worker has read it instead.
+TerrainStreamer::Tile* TerrainStreamer::getTileWithHeights(int index) {
+    if(index < 0) return NULL;
+
+    Tile& tile = tiles[index];
+    tile.lastUsedFrame = frame;
+    if(tile.terrain == NULL){
+        requestTile(index);
+        if(!waitForTiles) return NULL;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            tileCompleted.wait(lock, [this, index]{
+                for(size_t i = 0; i < completed.size(); i++){
+                    if(completed[i].index == index) return true;
+                }
+                return false;
+            });
+        }
+        addCompletedTiles();
+        if(tile.terrain == NULL) return NULL;
+    }
+    return &tile;
+}
+
+void TerrainStreamer::buildMesh(int index) {
+    Tile& tile = tiles[index];
+    const HeightMap& heights = tile.terrain->getHeightMap();
+    Model* model = generateTerrainModel(heights, tileSize, maxHeight);
+
+    Terrain* meshed = new Terrain(model, textures, heights, tileSize, maxHeight);
+    meshed->setPosition(getTileOrigin(index));
+    delete tile.terrain;
+    tile.terrain = meshed;
+
+    // Positions, normals and texture coordinates plus the index buffer.
+    size_t samples = (size_t)heights.width * heights.height;
+    size_t meshBytes = samples * 8 * sizeof(float)
+            + (size_t)(heights.width - 1) * (heights.height - 1) * 6 * sizeof(unsigned int);
+    tile.bytes += meshBytes;
+    residentBytes += meshBytes;
+    tile.state = RESIDENT;
+}
+
+void TerrainStreamer::unload(int index) {
+    Tile& tile = tiles[index];
+    if(tile.terrain != NULL){
+        Model* model = tile.terrain->getModel();
+        if(model != NULL){
+            Loader::getLoader()->deleteVAO(model->getModelComponents()->at(0).getVaoID());
+            delete model;
+        }
+        delete tile.terrain;
+    }
+    residentBytes -= tile.bytes;
+    tile = Tile();
+}
+
+// Evicts the tiles furthest from the focus until the resident data fits into the budget again.
+// The tile under the focus is never evicted.
+void TerrainStreamer::enforceBudget(glm::vec3 focus) {
+    int focusTile = getTileIndex(focus.x, focus.z);
+    while(residentBytes > budgetBytes){
+        int furthest = -1;
+        float furthestDistance = -1.0f;
+        for(size_t i = 0; i < tiles.size(); i++){
+            if(tiles[i].terrain == NULL || (int)i == focusTile) continue;
+            float distance = getDistanceToTile(i, focus);
+            if(distance > furthestDistance){
+                furthest = i;
+                furthestDistance = distance;
+            }
+        }
+        if(furthest < 0) break;
+        unload(furthest);
+    }
+}
+
+void TerrainStreamer::update(glm::vec3 focus) {
+    PROFILE_SCOPE("terrain streaming");
+    frame++;
+    addCompletedTiles();
+
+    wanted.clear();
+    cancelled.clear();
+    for(size_t i = 0; i < tiles.size(); i++){
+        float distance = getDistanceToTile(i, focus);
+        if(distance <= loadRadius){
+            tiles[i].lastUsedFrame = frame;
+            wanted.push_back(std::make_pair(distance, (int)i));
+        } else if(distance > loadRadius * UNLOAD_HYSTERESIS && frame - tiles[i].lastUsedFrame > 1){
+            // Not queried since the last update
+            if(tiles[i].state == QUEUED){
+                cancelled.push_back(i);
+                tiles[i].state = UNLOADED;
+            } else if(tiles[i].state != UNLOADED){
+                unload(i);
+            }
+        }
+    }
+    std::sort(wanted.begin(), wanted.end());
+
+    int meshesBuilt = 0;
+    bool requestsAdded = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(size_t i = 0; i < cancelled.size(); i++){
+            requests.erase(std::remove(requests.begin(), requests.end(), cancelled[i]), requests.end());
+        }
+        for(size_t i = 0; i < wanted.size(); i++){
+            Tile& tile = tiles[wanted[i].second];
+            if(tile.state == UNLOADED){
+                tile.state = QUEUED;
+                requests.push_back(wanted[i].second);
+                requestsAdded = true;
+            }
+        }
+        // Nearest tiles first, including ones queued in earlier frames.
+        std::sort(requests.begin(), requests.end(), [this, focus](int a, int b){
+            return getDistanceToTile(a, focus) < getDistanceToTile(b, focus);
+        });
+    }
+    if(requestsAdded){
+        requestsChanged.notify_all();
+    }
+
+    for(size_t i = 0; i < wanted.size() && meshesBuilt < MAX_MESHES_PER_FRAME; i++){
+        if(tiles[wanted[i].second].state == HEIGHTS){
+            buildMesh(wanted[i].second);
+            meshesBuilt++;
+        }
+    }
+
+    enforceBudget(focus);
+}
+
+void TerrainStreamer::setWaitForTiles(bool wait) {
+    waitForTiles = wait;
+}
+
+size_t TerrainStreamer::getResidentBytes() const {
+    return residentBytes;
+}
+
+int TerrainStreamer::getResidentTileCount() const {
+    int count = 0;
+    for(size_t i = 0; i < tiles.size(); i++){
+        if(tiles[i].state == RESIDENT) count++;
+    }
+    return count;
+}
+
+void TerrainStreamer::collectTiles(std::vector<Terrain*>& tiles) {
+    for(size_t i = 0; i < this->tiles.size(); i++){
+        if(this->tiles[i].state == RESIDENT){
+            tiles.push_back(this->tiles[i].terrain);
+        }
+    }
+}
+
+bool TerrainStreamer::isOnTerrain(float x, float z) {
+    // Same margin of 4 samples as a single terrain, but only at the edges of the whole world.
+    float margin = tileSamples > 0 ? 4.0f * tileSize / tileSamples : 0.0f;
+    if(x < -tilesX * tileSize / 2 + margin
+       || x >= tilesX * tileSize / 2 - margin
+       || z < -tilesZ * tileSize / 2 + margin
+       || z >= tilesZ * tileSize / 2 - margin){
+        return false;
+    }
+
+    return getHeight(x, z) >= 0.0f;
+}
+
+float TerrainStreamer::getHeight(float x, float z) {
+    int index = getTileIndex(x, z);
+    Tile* tile = getTileWithHeights(index);
+    if(tile == NULL){
+        return -maxHeight;
+    }
+
+    glm::vec3 centre = getTileOrigin(index) + glm::vec3(tileSize / 2, 0.0f, tileSize / 2);
+    return tile->terrain->getHeight(x - centre.x, z - centre.z);
+}
+
+// Pixel coordinates address the world as if it was a single height map made of all the tiles.
+glm::vec3 TerrainStreamer::getPositionFromPixel(int x, int y) {
+    if(tileSamples < 0){
+        getTileWithHeights(0);
+    }
+    float worldSamplesX = (float)tilesX * tileSamples;
+    float worldSamplesZ = (float)tilesZ * tileSamples;
+    float x_flt = ((float)x - worldSamplesX/2)/worldSamplesX * tilesX * tileSize;
+    float z_flt = ((float)y - worldSamplesZ/2)/worldSamplesZ * tilesZ * tileSize;
+
+    return glm::vec3(x_flt, 0.0f, z_flt);
+}
+
+float TerrainStreamer::getAngle(float x, float z, float rotation, float offset) {
+    int index = getTileIndex(x, z);
+    Tile* tile = getTileWithHeights(index);
+    if(tile == NULL){
+        return 0.0f;
+    }
+
+    glm::vec3 centre = getTileOrigin(index) + glm::vec3(tileSize / 2, 0.0f, tileSize / 2);
+    return tile->terrain->getAngle(x - centre.x, z - centre.z, rotation, offset);
+}
+
+void TerrainStreamer::addCrater(float x, float z, float radius, float depth) {
+    int index = getTileIndex(x, z);
+    Tile* tile = getTileWithHeights(index);
+    if(tile == NULL) return;
+
+    glm::vec3 centre = getTileOrigin(index) + glm::vec3(tileSize / 2, 0.0f, tileSize / 2);
+    tile->terrain->addCrater(x - centre.x, z - centre.z, radius, depth);
+}
+
+void TerrainStreamer::addRut(float x, float z, float radius, float depth) {
+    int index = getTileIndex(x, z);
+    Tile* tile = getTileWithHeights(index);
+    if(tile == NULL) return;
+
+    glm::vec3 centre = getTileOrigin(index) + glm::vec3(tileSize / 2, 0.0f, tileSize / 2);
+    tile->terrain->addRut(x - centre.x, z - centre.z, radius, depth);
+}
+
+void TerrainStreamer::flushDeformations() {
+    for(size_t i = 0; i < tiles.size(); i++){
+        if(tiles[i].terrain != NULL){
+            tiles[i].terrain->flushDeformations();
+        }
+    }
+}
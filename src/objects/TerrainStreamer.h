@@ -0,0 +1,131 @@
+#ifndef TERRAIN_STREAMER_H
+#define TERRAIN_STREAMER_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Terrain.h"
+#include "../utils/Loader.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+
+/*
+    A large world made of square height map tiles which are streamed in and out around a focus point.
+
+    The world is described by a small text manifest, for example:
+        tiles 16 16             # number of tiles along x and z
+        tile_size 150.0         # world units covered by one tile
+        max_height 40.0         # world height of a sample equal to 1.0
+        pattern tile_%d_%d.r16  # file of tile (x, z), relative to the manifest
+        load_radius 400.0       # tiles closer than this are kept resident
+        budget_mb 256           # memory budget for resident height data and meshes
+
+    Neighbouring tiles should share their border row and column of samples so the meshes join without cracks.
+    Every tile file must exist, the constructor checks them all. Height data is read on background threads, meshes are built and uploaded on the thread owning the GL context
+    in update(). The world is centred about the origin, like a single Terrain.
+
+    Queries on a tile without height data, such as cars far from the player, request the tile and answer as if the
+    point was off the terrain until it arrives. Tiles queried since the last update() are kept. While setting up the
+    world, queries wait for the workers to read the tile instead, until setWaitForTiles(false).
+*/
+class TerrainStreamer : public Terrain {
+private:
+    enum TileState {
+        UNLOADED,
+        QUEUED,     // Waiting for or being read by a worker
+        HEIGHTS,    // Height data resident, no mesh
+        RESIDENT    // Height data and mesh resident
+    };
+
+    struct Tile {
+        TileState state;
+        Terrain* terrain;
+        size_t bytes;
+        unsigned int lastUsedFrame;
+
+        Tile();
+    };
+
+    struct LoadedTile {
+        int index;
+        HeightMap heights;
+    };
+
+    std::string directory;
+    std::string pattern;
+    int tilesX;
+    int tilesZ;
+    float tileSize;
+    float loadRadius;
+    size_t budgetBytes;
+    size_t residentBytes;
+    int tileSamples;    // Samples along a tile side, known once the first tile is read
+    unsigned int frame;
+    bool waitForTiles;
+
+    std::vector<Tile> tiles;
+
+    // Shared with the worker threads, guarded by mutex.
+    std::mutex mutex;
+    std::condition_variable requestsChanged;
+    std::condition_variable tileCompleted;
+    std::deque<int> requests;
+    std::vector<LoadedTile> completed;
+    bool stopping;
+    std::vector<std::thread> workers;
+
+    // Used by update(), kept to not allocate every frame.
+    std::vector<LoadedTile> finished;
+    std::vector<std::pair<float, int> > wanted;
+    std::vector<int> cancelled;
+
+    void workerLoop();
+    std::string getTilePath(int index);
+    int getTileIndex(float x, float z);
+    glm::vec3 getTileOrigin(int index);
+    float getDistanceToTile(int index, glm::vec3 point);
+
+    void requestTile(int index);
+    void addCompletedTiles();
+    Tile* getTileWithHeights(int index);
+    void buildMesh(int index);
+    void unload(int index);
+    void enforceBudget(glm::vec3 focus);
+
+public:
+    static const int NUM_WORKERS;
+
+    TerrainStreamer(std::string manifestFile, std::vector<GLuint> textures);
+    virtual ~TerrainStreamer();
+
+    // Requests tiles around the focus point, uploads finished ones and evicts far away tiles.
+    // Has to be called on the thread owning the GL context, once per frame.
+    void update(glm::vec3 focus);
+    // Whether queries on a tile without height data wait for it to be read, true until set otherwise.
+    void setWaitForTiles(bool wait);
+    size_t getResidentBytes() const;
+    int getResidentTileCount() const;
+
+    virtual void collectTiles(std::vector<Terrain*>& tiles);
+
+    virtual bool isOnTerrain(float x, float z);
+    virtual float getHeight(float x, float z);
+    virtual glm::vec3 getPositionFromPixel(int x, int y);
+    virtual float getAngle(float x, float z, float rotation, float offset);
+
+    // Deformations go to the tile under the point only, edits across a tile border leave a seam.
+    virtual void addCrater(float x, float z, float radius, float depth);
+    virtual void addRut(float x, float z, float radius, float depth);
+    virtual void flushDeformations();
+};
+
+#endif //TERRAIN_STREAMER_H
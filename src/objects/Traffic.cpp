@@ -0,0 +1,185 @@
+#include "Traffic.h"
+
+#include "../utils/Profiler.h"
+#include "../utils/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+const int Traffic::PARALLEL_THRESHOLD = 256;
+
+// Controller tuning
+static const float LOOK_AHEAD_BASE = 4.0f;          // Pure pursuit look ahead when stopped
+static const float LOOK_AHEAD_PER_SPEED = 0.6f;     // Extra look ahead per m/s
+static const float STEER_GAIN = 1.5f;               // Steering angle per radian of heading error
+static const float BEND_SLOWDOWN = 0.65f;           // Fraction of speed given up for a right angle bend ahead
+static const float BRAKE_MARGIN = 3.0f;             // Brakes only this far over the target speed, lifts off below
+static const float LANE_OFFSET = 1.5f;
+static const float CRUISE_SPEED = 18.0f;
+static const float CRUISE_SPREAD = 4.0f;            // Drivers' cruise speeds vary by up to this much
+static const float CLOSEST_WINDOW = 10.0f;          // How far along the track cars are searched for each step
+
+static float wrapAngle(float angle){
+    angle = std::fmod(angle + (float)M_PI, 2.0f * (float)M_PI);
+    return (angle < 0.0f ? angle + 2.0f * (float)M_PI : angle) - (float)M_PI;
+}
+
+std::vector<glm::vec2> Traffic::findTrackCorners(const std::vector<glm::vec3>& barrels, float mergeDistance){
+    std::vector<glm::vec2> firsts;
+    std::vector<glm::vec2> sums;
+    std::vector<int> counts;
+    for(size_t i = 0; i < barrels.size(); i++){
+        glm::vec2 barrel(barrels[i].x, barrels[i].z);
+        size_t group = 0;
+        while(group < firsts.size() && glm::length(barrel - firsts[group]) > mergeDistance) group++;
+        if(group == firsts.size()){
+            firsts.push_back(barrel);
+            sums.push_back(glm::vec2(0.0f));
+            counts.push_back(0);
+        }
+        sums[group] += barrel;
+        counts[group]++;
+    }
+
+    std::vector<glm::vec2> corners;
+    glm::vec2 middle(0.0f);
+    for(size_t i = 0; i < sums.size(); i++){
+        corners.push_back(sums[i] / (float)counts[i]);
+        middle += corners.back();
+    }
+    if(corners.empty()) return corners;
+    middle /= (float)corners.size();
+
+    std::sort(corners.begin(), corners.end(), [middle](const glm::vec2& a, const glm::vec2& b){
+        return std::atan2(a.y - middle.y, a.x - middle.x) < std::atan2(b.y - middle.y, b.x - middle.x);
+    });
+    return corners;
+}
+
+Traffic::Traffic(Model* model, Terrain* terrain, const std::vector<glm::vec2>& corners, size_t count, glm::vec3 scale):
+        model(model), terrain(terrain), scale(scale), track(corners) {
+    sim.reserve(count);
+    progress.resize(count);
+    lane.resize(count);
+    cruiseSpeed.resize(count);
+    previousPositions.resize(count);
+    previousHeadings.resize(count);
+    transforms.resize(count);
+    matrices.resize(count);
+
+    VehicleParams params;
+    float spacing = count > 0 ? track.getLength() / count : 0.0f;
+    for(size_t i = 0; i < count; i++){
+        progress[i] = i * spacing;
+        lane[i] = (i % 2 == 0) ? LANE_OFFSET : -LANE_OFFSET;
+        cruiseSpeed[i] = CRUISE_SPEED + CRUISE_SPREAD * (float)rand() / RAND_MAX;
+
+        glm::vec2 direction = track.getDirection(progress[i]);
+        glm::vec2 right(direction.y, -direction.x);
+        glm::vec2 position = track.getPoint(progress[i]) + right * lane[i];
+        float heading = std::atan2(direction.x, direction.y);
+        sim.add(params, position, heading);
+        previousPositions[i] = position;
+        previousHeadings[i] = heading;
+    }
+}
+
+// Works out the controls of cars [begin, end) from where they are now.
+void Traffic::drive(int begin, int end){
+    for(int i = begin; i < end; i++){
+        glm::vec2 position = sim.getPosition(i);
+        float speed = sim.getSpeed(i);
+        progress[i] = track.findClosest(position, progress[i], CLOSEST_WINDOW);
+
+        // Steer for a point on the car's lane a little way ahead
+        float lookAhead = LOOK_AHEAD_BASE + LOOK_AHEAD_PER_SPEED * speed;
+        glm::vec2 direction = track.getDirection(progress[i] + lookAhead);
+        glm::vec2 right(direction.y, -direction.x);
+        glm::vec2 toTarget = track.getPoint(progress[i] + lookAhead) + right * lane[i] - position;
+        float error = wrapAngle(std::atan2(toTarget.x, toTarget.y) - sim.getHeading(i));
+
+        // Slow down for how far the track turns over the next few look aheads
+        glm::vec2 now = track.getDirection(progress[i]);
+        glm::vec2 later = track.getDirection(progress[i] + 3.0f * lookAhead);
+        float bend = std::acos(glm::clamp(glm::dot(now, later), -1.0f, 1.0f));
+        float targetSpeed = cruiseSpeed[i] * (1.0f - BEND_SLOWDOWN * std::min(bend / ((float)M_PI / 2.0f), 1.0f));
+
+        VehicleInput input;
+        input.steer = STEER_GAIN * error;
+        input.throttle = speed < targetSpeed ? 1.0f : 0.0f;
+        input.brake = speed > targetSpeed + BRAKE_MARGIN ? 1.0f : 0.0f;
+        sim.setInput(i, input);
+    }
+}
+
+void Traffic::step(float dt){
+    PROFILE_SCOPE("traffic step");
+    int count = (int)sim.size();
+    for(int i = 0; i < count; i++){
+        previousPositions[i] = sim.getPosition(i);
+        previousHeadings[i] = sim.getHeading(i);
+    }
+
+    // Each car only writes its own controls, so cars can be driven in any order.
+    if(count >= PARALLEL_THRESHOLD){
+        ThreadPool::getThreadPool()->parallelFor(0, count, [this](int begin, int end){
+            drive(begin, end);
+        });
+    }
+    else {
+        drive(0, count);
+    }
+    sim.step(dt);
+}
+
+void Traffic::updateMatrices(float alpha){
+    PROFILE_SCOPE("traffic matrices");
+    float bottom = model->getRangeInDim(1).first * scale.y;
+    for(size_t i = 0; i < sim.size(); i++){
+        glm::vec2 position = glm::mix(previousPositions[i], sim.getPosition(i), alpha);
+        float heading = previousHeadings[i] + wrapAngle(sim.getHeading(i) - previousHeadings[i]) * alpha;
+        float height = terrain->getHeight(position.x, position.y) - bottom;
+        glm::vec3 rotation(terrain->getAngleX(position.x, position.y, heading), heading,
+                           terrain->getAngleZ(position.x, position.y, heading));
+        transforms.set(i, glm::vec3(position.x, height, position.y), rotation, scale);
+    }
+    if(!matrices.empty()){
+        TransformBatch::calculateModelMatrices(transforms, &matrices[0]);
+    }
+}
+
+int Traffic::addColliders(CollisionWorld& world) const {
+    glm::vec3 min, max;
+    for(int dim = 0; dim < 3; dim++){
+        min[dim] = model->getRangeInDim(dim).first;
+        max[dim] = model->getRangeInDim(dim).second;
+    }
+    int first = (int)world.getDynamicCount();
+    for(size_t i = 0; i < sim.size(); i++){
+        glm::vec2 position = sim.getPosition(i);
+        world.addDynamic(OrientedBox::fromLocalBounds(min, max, glm::vec3(position.x, 0.0f, position.y), scale,
+                                                      sim.getHeading(i)), false);
+    }
+    return first;
+}
+
+void Traffic::resolveCollision(size_t car, glm::vec2 normal, float depth){
+    sim.setPose(car, sim.getPosition(car) + normal * depth, sim.getHeading(car));
+    sim.setVelocity(car, Collision::respond(sim.getVelocity(car), normal, Collision::CAR_RESTITUTION));
+}
+
+size_t Traffic::size() const {
+    return sim.size();
+}
+
+Model* Traffic::getModel() const {
+    return model;
+}
+
+const std::vector<glm::mat4>& Traffic::getMatrices() const {
+    return matrices;
+}
+
+const CatmullRomSpline& Traffic::getTrack() const {
+    return track;
+}
@@ -0,0 +1,78 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Terrain.h"
+#include "../physics/VehicleSim.h"
+#include "../physics/CollisionWorld.h"
+#include "../utils/CatmullRomSpline.h"
+#include "../utils/Model.h"
+#include "../utils/TransformBatch.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/*
+    AI cars lapping a track, all driven by one VehicleSim.
+
+    Each car steers for a point a little ahead of it on the track spline (pure pursuit) and lifts off or brakes
+    when the track ahead bends, down to a speed depending on how sharp the bend is. Cars keep to their own lane,
+    a fixed offset from the centre line. They do not see each other or the player, but bump off them when
+    collisions are resolved.
+
+    The cars are drawn with one model, as instances, from getMatrices().
+*/
+class Traffic {
+private:
+    Model* model;
+    Terrain* terrain;
+    glm::vec3 scale;
+    CatmullRomSpline track;
+    VehicleSim sim;
+
+    std::vector<float> progress;        // Distance along the track of each car, from its last step
+    std::vector<float> lane;            // Offset to the right of the centre line
+    std::vector<float> cruiseSpeed;     // Speed on the straights, varies a little between drivers
+    std::vector<glm::vec2> previousPositions;
+    std::vector<float> previousHeadings;
+
+    TransformSoA transforms;
+    std::vector<glm::mat4> matrices;
+
+    void drive(int begin, int end);
+
+public:
+    // Fewer cars than this are driven on the calling thread, spreading them out costs more than it saves.
+    static const int PARALLEL_THRESHOLD;
+
+    // Orders groups of barrels standing around the corners of a track into the track's corner points. Barrels
+    // closer than mergeDistance to a group's first barrel belong to that group, the corners are the group centres
+    // in order around their middle.
+    static std::vector<glm::vec2> findTrackCorners(const std::vector<glm::vec3>& barrels, float mergeDistance);
+
+    // Cars are spread evenly along a spline through the corners, alternating between two lanes.
+    Traffic(Model* model, Terrain* terrain, const std::vector<glm::vec2>& corners, size_t count, glm::vec3 scale);
+
+    // One fixed simulation step for every car.
+    void step(float dt);
+    // Builds the drawn transforms, alpha of the way through the last step and resting on the terrain.
+    void updateMatrices(float alpha);
+
+    // Adds every car to the world's dynamic bodies, in car order, and returns the id of the first. The cars
+    // cannot steer around anything and would get stuck against props, so they only hit other cars.
+    int addColliders(CollisionWorld& world) const;
+    // Moves a car out of something it hit, by depth along normal, and takes away its speed into it.
+    void resolveCollision(size_t car, glm::vec2 normal, float depth);
+
+    size_t size() const;
+    Model* getModel() const;
+    const std::vector<glm::mat4>& getMatrices() const;
+    const CatmullRomSpline& getTrack() const;
+};
+
+#endif //TRAFFIC_H
@@ -0,0 +1,66 @@
+#include "Collision.h"
+
+#include <cmath>
+
+const float Collision::CAR_RESTITUTION = 0.3f;
+
+OrientedBox::OrientedBox(): centre(0.0f), halfExtents(0.0f), heading(0.0f) {
+}
+
+OrientedBox::OrientedBox(glm::vec2 centre, glm::vec2 halfExtents, float heading):
+        centre(centre), halfExtents(halfExtents), heading(heading) {
+}
+
+OrientedBox OrientedBox::fromLocalBounds(glm::vec3 min, glm::vec3 max, glm::vec3 position, glm::vec3 scale,
+        float heading){
+    OrientedBox box(glm::vec2(0.0f), glm::vec2(max.x - min.x, max.z - min.z) * 0.5f * glm::vec2(scale.x, scale.z),
+                    heading);
+    // The model's origin need not be in the middle of its bounds
+    glm::vec2 offset = glm::vec2(max.x + min.x, max.z + min.z) * 0.5f * glm::vec2(scale.x, scale.z);
+    box.centre = glm::vec2(position.x, position.z) + box.getAxisX() * offset.x + box.getAxisZ() * offset.y;
+    return box;
+}
+
+glm::vec2 OrientedBox::getAxisX() const {
+    return glm::vec2(std::cos(heading), -std::sin(heading));
+}
+
+glm::vec2 OrientedBox::getAxisZ() const {
+    return glm::vec2(std::sin(heading), std::cos(heading));
+}
+
+void OrientedBox::getBounds(glm::vec2& min, glm::vec2& max) const {
+    glm::vec2 axisX = getAxisX();
+    glm::vec2 axisZ = getAxisZ();
+    glm::vec2 extent = glm::abs(axisX) * halfExtents.x + glm::abs(axisZ) * halfExtents.y;
+    min = centre - extent;
+    max = centre + extent;
+}
+
+// Half the length of the box's shadow on a unit axis.
+static float projectedRadius(const OrientedBox& box, glm::vec2 axisX, glm::vec2 axisZ, glm::vec2 axis){
+    return std::abs(glm::dot(axisX, axis)) * box.halfExtents.x + std::abs(glm::dot(axisZ, axis)) * box.halfExtents.y;
+}
+
+bool Collision::intersect(const OrientedBox& a, const OrientedBox& b, glm::vec2& normal, float& depth){
+    glm::vec2 axes[4] = {a.getAxisX(), a.getAxisZ(), b.getAxisX(), b.getAxisZ()};
+    glm::vec2 between = a.centre - b.centre;
+    depth = INFINITY;
+    for(int i = 0; i < 4; i++){
+        float distance = glm::dot(between, axes[i]);
+        float overlap = projectedRadius(a, axes[0], axes[1], axes[i]) + projectedRadius(b, axes[2], axes[3], axes[i])
+                        - std::abs(distance);
+        if(overlap <= 0.0f) return false;
+        if(overlap < depth){
+            depth = overlap;
+            normal = distance < 0.0f ? -axes[i] : axes[i];
+        }
+    }
+    return true;
+}
+
+glm::vec2 Collision::respond(glm::vec2 velocity, glm::vec2 normal, float restitution){
+    float into = glm::dot(velocity, normal);
+    if(into >= 0.0f) return velocity;
+    return velocity - (1.0f + restitution) * into * normal;
+}
@@ -0,0 +1,39 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <glm/glm.hpp>
+
+/*
+    Box on the ground plane, turned about y like an Entity. Collisions are worked out top down, in (x, z), as the
+    cars only drive over the terrain.
+*/
+struct OrientedBox {
+    glm::vec2 centre;
+    glm::vec2 halfExtents;  // Along the box's own x and z axes
+    float heading;          // Rotation about y, heading 0 has the box's z axis along world +z
+
+    OrientedBox();
+    OrientedBox(glm::vec2 centre, glm::vec2 halfExtents, float heading);
+    // Box around local bounds [min, max] of a model placed with the given position, scale and rotation about y.
+    static OrientedBox fromLocalBounds(glm::vec3 min, glm::vec3 max, glm::vec3 position, glm::vec3 scale,
+            float heading);
+
+    glm::vec2 getAxisX() const;
+    glm::vec2 getAxisZ() const;
+    // World aligned box around this one.
+    void getBounds(glm::vec2& min, glm::vec2& max) const;
+};
+
+class Collision {
+public:
+    // Bounce of cars off props and each other.
+    static const float CAR_RESTITUTION;
+
+    // Separating axis test. On overlap, normal is the unit direction to move a by depth to separate it from b.
+    static bool intersect(const OrientedBox& a, const OrientedBox& b, glm::vec2& normal, float& depth);
+    // Velocity after hitting a surface with the given normal. The part into the surface is reflected and scaled by
+    // restitution, 0 stops dead against it and 1 bounces off at full speed. Velocities moving away are kept.
+    static glm::vec2 respond(glm::vec2 velocity, glm::vec2 normal, float restitution);
+};
+
+#endif //COLLISION_H
@@ -0,0 +1,81 @@
+#include "CollisionWorld.h"
+
+CollisionWorld::CollisionWorld(float cellSize): staticHash(cellSize), dynamicHash(cellSize) {
+}
+
+int CollisionWorld::addStatic(const OrientedBox& box){
+    staticBoxes.push_back(box);
+    return (int)staticBoxes.size() - 1;
+}
+
+void CollisionWorld::buildStatic(){
+    staticHash.clear();
+    staticHash.reserve(staticBoxes.size());
+    for(size_t i = 0; i < staticBoxes.size(); i++){
+        glm::vec2 min, max;
+        staticBoxes[i].getBounds(min, max);
+        staticHash.insert(i, min, max);
+    }
+    staticHash.build();
+}
+
+size_t CollisionWorld::getStaticCount() const {
+    return staticBoxes.size();
+}
+
+void CollisionWorld::clearDynamic(){
+    dynamicBoxes.clear();
+    dynamicHitsStatic.clear();
+}
+
+int CollisionWorld::addDynamic(const OrientedBox& box, bool hitsStatic){
+    dynamicBoxes.push_back(box);
+    dynamicHitsStatic.push_back(hitsStatic);
+    return (int)dynamicBoxes.size() - 1;
+}
+
+size_t CollisionWorld::getDynamicCount() const {
+    return dynamicBoxes.size();
+}
+
+const std::vector<CollisionWorld::Contact>& CollisionWorld::findContacts(){
+    dynamicHash.clear();
+    dynamicHash.reserve(dynamicBoxes.size());
+    for(size_t i = 0; i < dynamicBoxes.size(); i++){
+        glm::vec2 min, max;
+        dynamicBoxes[i].getBounds(min, max);
+        dynamicHash.insert(i, min, max);
+    }
+    dynamicHash.build();
+
+    contacts.clear();
+    Contact contact;
+    for(size_t i = 0; i < dynamicBoxes.size(); i++){
+        const OrientedBox& box = dynamicBoxes[i];
+        glm::vec2 min, max;
+        box.getBounds(min, max);
+        contact.body = i;
+
+        candidates.clear();
+        if(dynamicHitsStatic[i]) staticHash.query(min, max, candidates);
+        contact.isStatic = true;
+        for(size_t c = 0; c < candidates.size(); c++){
+            contact.other = candidates[c];
+            if(Collision::intersect(box, staticBoxes[contact.other], contact.normal, contact.depth)){
+                contacts.push_back(contact);
+            }
+        }
+
+        candidates.clear();
+        dynamicHash.query(min, max, candidates);
+        contact.isStatic = false;
+        for(size_t c = 0; c < candidates.size(); c++){
+            contact.other = candidates[c];
+            if(contact.other <= (int)i) continue;
+            if(Collision::intersect(box, dynamicBoxes[contact.other], contact.normal, contact.depth)){
+                contacts.push_back(contact);
+            }
+        }
+    }
+    return contacts;
+}
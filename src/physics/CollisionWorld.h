@@ -0,0 +1,60 @@
+#ifndef COLLISION_WORLD_H
+#define COLLISION_WORLD_H
+
+#include "Collision.h"
+#include "SpatialHash.h"
+
+#include <vector>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+/*
+    Finds which boxes overlap, for bodies that never move (props) and bodies that move every step (cars).
+
+    Static bodies go in their own SpatialHash, built once. Dynamic bodies are added again each step into a second
+    one, which is rebuilt. Every dynamic body then looks up its neighbours in both, and the candidates are tested
+    with Collision::intersect. Work per step grows with the number of dynamic bodies, not with the props.
+*/
+class CollisionWorld {
+public:
+    struct Contact {
+        int body;           // Dynamic body
+        int other;          // Static or dynamic body, by isStatic
+        bool isStatic;
+        glm::vec2 normal;   // Moving body by depth along normal separates it from other
+        float depth;
+    };
+
+private:
+    std::vector<OrientedBox> staticBoxes;
+    std::vector<OrientedBox> dynamicBoxes;
+    std::vector<unsigned char> dynamicHitsStatic;
+    SpatialHash staticHash;
+    SpatialHash dynamicHash;
+
+    std::vector<int> candidates;
+    std::vector<Contact> contacts;
+
+public:
+    // Cells should be about the size of the larger bodies.
+    explicit CollisionWorld(float cellSize = 8.0f);
+
+    // Returns the id of the body, in insertion order from 0.
+    int addStatic(const OrientedBox& box);
+    // Must be called after the static bodies have been added.
+    void buildStatic();
+    size_t getStaticCount() const;
+
+    // Dynamic bodies are replaced every step: clear, add them all, then findContacts().
+    void clearDynamic();
+    // Bodies that do not hit static ones still hit other dynamic bodies.
+    int addDynamic(const OrientedBox& box, bool hitsStatic = true);
+    size_t getDynamicCount() const;
+
+    // Every overlap of a dynamic body with a static body, and each overlapping pair of dynamic bodies once with
+    // body < other. Valid until the next call.
+    const std::vector<Contact>& findContacts();
+};
+
+#endif //COLLISION_WORLD_H
@@ -0,0 +1,105 @@
+#include "SpatialHash.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cellSize): inverseCellSize(1.0f / cellSize), tableMask(0), stamp(0) {
+}
+
+void SpatialHash::clear(){
+    boxes.clear();
+    ids.clear();
+    entries.clear();
+    entryBuckets.clear();
+    bucketStart.assign(1, 0);
+    tableMask = 0;
+}
+
+void SpatialHash::reserve(size_t count){
+    boxes.reserve(count);
+    ids.reserve(count);
+    stamps.reserve(count);
+}
+
+size_t SpatialHash::size() const {
+    return boxes.size();
+}
+
+void SpatialHash::insert(int id, glm::vec2 min, glm::vec2 max){
+    boxes.push_back(glm::vec4(min.x, min.y, max.x, max.y));
+    ids.push_back(id);
+}
+
+int SpatialHash::toCell(float coordinate) const {
+    return (int)std::floor(coordinate * inverseCellSize);
+}
+
+uint32_t SpatialHash::hashCell(int x, int z) const {
+    return ((uint32_t)x * 73856093u ^ (uint32_t)z * 19349663u) & tableMask;
+}
+
+void SpatialHash::build(){
+    // Table of at least twice as many buckets as cells covered, so few cells share a bucket
+    size_t covered = 0;
+    for(size_t i = 0; i < boxes.size(); i++){
+        const glm::vec4& box = boxes[i];
+        covered += (size_t)(toCell(box.z) - toCell(box.x) + 1) * (toCell(box.w) - toCell(box.y) + 1);
+    }
+    uint32_t tableSize = 16;
+    while(tableSize < covered * 2) tableSize *= 2;
+    tableMask = tableSize - 1;
+
+    // Counting sort of (bucket, body) entries by bucket
+    entryBuckets.clear();
+    bucketStart.assign(tableSize + 1, 0);
+    for(size_t i = 0; i < boxes.size(); i++){
+        const glm::vec4& box = boxes[i];
+        for(int z = toCell(box.y); z <= toCell(box.w); z++){
+            for(int x = toCell(box.x); x <= toCell(box.z); x++){
+                uint32_t bucket = hashCell(x, z);
+                entryBuckets.push_back(bucket);
+                bucketStart[bucket + 1]++;
+            }
+        }
+    }
+    for(uint32_t bucket = 0; bucket < tableSize; bucket++){
+        bucketStart[bucket + 1] += bucketStart[bucket];
+    }
+    entries.resize(entryBuckets.size());
+    size_t entry = 0;
+    for(size_t i = 0; i < boxes.size(); i++){
+        const glm::vec4& box = boxes[i];
+        size_t cells = (size_t)(toCell(box.z) - toCell(box.x) + 1) * (toCell(box.w) - toCell(box.y) + 1);
+        for(size_t c = 0; c < cells; c++, entry++){
+            // Each bucket is filled from its end down
+            entries[--bucketStart[entryBuckets[entry] + 1]] = i;
+        }
+    }
+    // bucketStart[b + 1] now holds the start of bucket b
+    for(uint32_t bucket = 0; bucket < tableSize; bucket++){
+        bucketStart[bucket] = bucketStart[bucket + 1];
+    }
+    bucketStart[tableSize] = entries.size();
+
+    stamps.assign(boxes.size(), 0);
+    stamp = 0;
+}
+
+void SpatialHash::query(glm::vec2 min, glm::vec2 max, std::vector<int>& out){
+    if(boxes.empty()) return;
+    stamp++;
+    for(int z = toCell(min.y); z <= toCell(max.y); z++){
+        for(int x = toCell(min.x); x <= toCell(max.x); x++){
+            uint32_t bucket = hashCell(x, z);
+            for(uint32_t e = bucketStart[bucket]; e < bucketStart[bucket + 1]; e++){
+                uint32_t body = entries[e];
+                if(stamps[body] == stamp) continue;
+                const glm::vec4& box = boxes[body];
+                // Other cells sharing the bucket, and bodies only touching the cell, are filtered here
+                if(box.x > max.x || box.z < min.x || box.y > max.y || box.w < min.y) continue;
+                stamps[body] = stamp;
+                out.push_back(ids[body]);
+            }
+        }
+    }
+}
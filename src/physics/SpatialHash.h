@@ -0,0 +1,50 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+/*
+    Broadphase for boxes on the ground plane: a uniform grid of square cells, hashed into a fixed table so the
+    world needs no bounds.
+
+    Boxes are inserted, then build() sorts them into the table in one counting sort pass. A query visits the
+    cells under its box and returns every body whose box overlaps it, once. Building and querying are both
+    linear in the number of bodies as long as boxes are not much larger than a cell. The arrays are kept between
+    builds, so rebuilding every step does not allocate once the body count has settled.
+*/
+class SpatialHash {
+private:
+    float inverseCellSize;
+    std::vector<glm::vec4> boxes;       // min x, min z, max x, max z of each body, in insertion order
+    std::vector<int> ids;               // Caller's id of each body
+
+    uint32_t tableMask;
+    std::vector<uint32_t> bucketStart;  // Start of each bucket in entries, one extra at the end
+    std::vector<uint32_t> entries;      // Body indices grouped by bucket, one per cell a body covers
+    std::vector<uint32_t> entryBuckets;
+
+    std::vector<uint32_t> stamps;       // Query a body was last returned by, to report it only once
+    uint32_t stamp;
+
+    int toCell(float coordinate) const;
+    uint32_t hashCell(int x, int z) const;
+
+public:
+    explicit SpatialHash(float cellSize);
+
+    void clear();
+    void reserve(size_t count);
+    size_t size() const;
+
+    void insert(int id, glm::vec2 min, glm::vec2 max);
+    // Must be called after inserting and before querying.
+    void build();
+    // Appends the ids of bodies whose box overlaps [min, max].
+    void query(glm::vec2 min, glm::vec2 max, std::vector<int>& out);
+};
+
+#endif //SPATIAL_HASH_H
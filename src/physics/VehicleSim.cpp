@@ -0,0 +1,391 @@
+#include "VehicleSim.h"
+#include "../utils/ThreadPool.h"
+#include "../utils/SimdMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+const size_t VehicleSim::PARALLEL_THRESHOLD = 4096;
+
+// Cars per AVX2 group, large batches are split over threads in whole groups.
+static const size_t GROUP_SIZE = 8;
+
+// Below this speed without throttle the car is stopped, the model gets unstable at very low speeds.
+static const float STOP_SPEED = 2.0f;
+
+VehicleParams::VehicleParams(){
+    gravity = 9.81f;
+    mass = 2000.0f;
+    inertiaScale = 1.0f;
+    cgToFrontAxle = 1.25f;
+    cgToRearAxle = 1.25f;
+    cgHeight = 0.55f;
+    tireGrip = 3.0f;
+    lockGrip = 0.8f;
+    engineForce = 8000.0f;
+    brakeForce = 12000.0f;
+    eBrakeForce = brakeForce / 2.5f;
+    weightTransfer = 0.2f;
+    maxSteer = 0.6f;
+    cornerStiffnessFront = 5.0f;
+    cornerStiffnessRear = 5.2f;
+    airResist = 3.0f;
+    rollResist = 5.0f;
+}
+
+VehicleSim::VehicleSim(){
+}
+
+VehicleSim::Path VehicleSim::getBestPath(){
+#ifdef SIMD_MATH_X86
+    static const Path best = __builtin_cpu_supports("avx2") ? AVX2 : SCALAR;
+    return best;
+#else
+    return SCALAR;
+#endif
+}
+
+const char* VehicleSim::getPathName(Path path){
+    return path == AVX2 ? "AVX2" : "scalar";
+}
+
+void VehicleSim::reserve(size_t count){
+    std::vector<float>* columns[] = {
+        &positionX, &positionZ, &heading, &velocityX, &velocityZ, &yawRate, &accelForward, &speed,
+        &throttle, &brake, &ebrake, &steer,
+        &gravity, &mass, &inertia, &cgHeight, &wheelBase,
+        &cgToFrontAxle, &cgToRearAxle, &axleWeightRatioFront, &axleWeightRatioRear,
+        &tireGrip, &lockGrip, &engineForce, &brakeForce, &eBrakeForce, &weightTransfer,
+        &cornerStiffnessFront, &cornerStiffnessRear, &airResist, &rollResist, &maxSteer
+    };
+    for(size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++){
+        columns[i]->reserve(count);
+    }
+}
+
+size_t VehicleSim::size() const {
+    return positionX.size();
+}
+
+size_t VehicleSim::add(const VehicleParams& params, glm::vec2 position, float startHeading){
+    positionX.push_back(position.x);
+    positionZ.push_back(position.y);
+    heading.push_back(startHeading);
+    velocityX.push_back(0.0f);
+    velocityZ.push_back(0.0f);
+    yawRate.push_back(0.0f);
+    accelForward.push_back(0.0f);
+    speed.push_back(0.0f);
+
+    throttle.push_back(0.0f);
+    brake.push_back(0.0f);
+    ebrake.push_back(0.0f);
+    steer.push_back(0.0f);
+
+    float carWheelBase = params.cgToFrontAxle + params.cgToRearAxle;
+    gravity.push_back(params.gravity);
+    mass.push_back(params.mass);
+    inertia.push_back(params.mass * params.inertiaScale);
+    cgHeight.push_back(params.cgHeight);
+    wheelBase.push_back(carWheelBase);
+    cgToFrontAxle.push_back(params.cgToFrontAxle);
+    cgToRearAxle.push_back(params.cgToRearAxle);
+    axleWeightRatioFront.push_back(params.cgToRearAxle / carWheelBase);
+    axleWeightRatioRear.push_back(params.cgToFrontAxle / carWheelBase);
+    tireGrip.push_back(params.tireGrip);
+    lockGrip.push_back(params.lockGrip);
+    engineForce.push_back(params.engineForce);
+    brakeForce.push_back(params.brakeForce);
+    eBrakeForce.push_back(params.eBrakeForce);
+    weightTransfer.push_back(params.weightTransfer);
+    cornerStiffnessFront.push_back(params.cornerStiffnessFront);
+    cornerStiffnessRear.push_back(params.cornerStiffnessRear);
+    airResist.push_back(params.airResist);
+    rollResist.push_back(params.rollResist);
+    maxSteer.push_back(params.maxSteer);
+    return size() - 1;
+}
+
+void VehicleSim::setInput(size_t car, const VehicleInput& input){
+    throttle[car] = input.throttle;
+    brake[car] = input.brake;
+    ebrake[car] = input.ebrake;
+    steer[car] = std::max(-maxSteer[car], std::min(input.steer, maxSteer[car]));
+}
+
+void VehicleSim::setPose(size_t car, glm::vec2 position, float newHeading){
+    positionX[car] = position.x;
+    positionZ[car] = position.y;
+    heading[car] = newHeading;
+}
+
+void VehicleSim::setVelocity(size_t car, glm::vec2 velocity){
+    velocityX[car] = velocity.x;
+    velocityZ[car] = velocity.y;
+    speed[car] = glm::length(velocity);
+}
+
+void VehicleSim::step(float dt){
+    step(dt, getBestPath());
+}
+
+void VehicleSim::step(float dt, Path path){
+    size_t count = size();
+    if(count < PARALLEL_THRESHOLD){
+        stepRange(dt, 0, count, path);
+        return;
+    }
+    int groups = (int)((count + GROUP_SIZE - 1) / GROUP_SIZE);
+    ThreadPool::getThreadPool()->parallelFor(0, groups, [this, dt, path, count](int begin, int end){
+        stepRange(dt, begin * GROUP_SIZE, std::min(end * GROUP_SIZE, count), path);
+    });
+}
+
+void VehicleSim::stepRange(float dt, size_t begin, size_t end, Path path){
+#ifdef SIMD_MATH_X86
+    if(path == AVX2){
+        stepAVX2(dt, begin, end);
+        return;
+    }
+#endif
+    stepScalar(dt, begin, end);
+}
+
+static inline float sign(float value){
+    return (float)((0.0f < value) - (value < 0.0f));
+}
+
+static inline float clampAbs(float value, float limit){
+    return std::max(-limit, std::min(value, limit));
+}
+
+void VehicleSim::stepScalar(float dt, size_t begin, size_t end){
+    for(size_t i = begin; i < end; i++){
+        float sn = std::sin(heading[i]);
+        float cs = std::cos(heading[i]);
+
+        // Velocity in car coordinates, y forward and x sideways
+        float forward = cs * velocityZ[i] + sn * velocityX[i];
+        float sideways = cs * velocityX[i] - sn * velocityZ[i];
+
+        // Weight on the axles, shifted by the last step's acceleration
+        float transfer = weightTransfer[i] * accelForward[i] * cgHeight[i] / wheelBase[i];
+        float axleWeightFront = mass[i] * (axleWeightRatioFront[i] * gravity[i] - transfer);
+        float axleWeightRear = mass[i] * (axleWeightRatioRear[i] * gravity[i] + transfer);
+
+        // Sideways speed of the axles from the body's rotation, and the slip angles it gives
+        float yawSpeedFront = cgToFrontAxle[i] * yawRate[i];
+        float yawSpeedRear = -cgToRearAxle[i] * yawRate[i];
+        float slipAngleFront = std::atan2(sideways + yawSpeedFront, std::abs(forward)) - sign(forward) * steer[i];
+        float slipAngleRear = std::atan2(sideways + yawSpeedRear, std::abs(forward));
+
+        float tireGripFront = tireGrip[i];
+        float tireGripRear = tireGrip[i] * (1.0f - ebrake[i] * (1.0f - lockGrip[i]));
+        float frictionFront = clampAbs(-cornerStiffnessFront[i] * slipAngleFront, tireGripFront) * axleWeightFront;
+        float frictionRear = clampAbs(-cornerStiffnessRear[i] * slipAngleRear, tireGripRear) * axleWeightRear;
+
+        // Rear wheel drive, forces in car coordinates
+        float brakeTotal = std::min(brake[i] * brakeForce[i] + ebrake[i] * eBrakeForce[i], brakeForce[i]);
+        float throttleTotal = throttle[i] * engineForce[i];
+        float tractionForward = throttleTotal - brakeTotal * sign(forward);
+        float dragForward = -rollResist[i] * forward - airResist[i] * forward * std::abs(forward);
+        float dragSideways = -rollResist[i] * sideways - airResist[i] * sideways * std::abs(sideways);
+        float totalForward = dragForward + tractionForward;
+        float totalSideways = dragSideways + std::cos(steer[i]) * frictionFront + frictionRear;
+
+        float accelSideways = totalSideways / mass[i];
+        accelForward[i] = totalForward / mass[i];
+        velocityZ[i] += (cs * accelForward[i] - sn * accelSideways) * dt;
+        velocityX[i] += (sn * accelForward[i] + cs * accelSideways) * dt;
+        speed[i] = std::sqrt(velocityX[i] * velocityX[i] + velocityZ[i] * velocityZ[i]);
+
+        // The drag alone does not slow the car down well when coasting
+        if(throttleTotal < 0.5f){
+            velocityX[i] -= velocityX[i] * 0.5f * dt;
+            velocityZ[i] -= velocityZ[i] * 0.5f * dt;
+        }
+
+        float angularTorque = frictionFront * cgToFrontAxle[i] - frictionRear * cgToRearAxle[i];
+        if(speed[i] < STOP_SPEED && throttleTotal < 0.5f){
+            velocityX[i] = 0.0f;
+            velocityZ[i] = 0.0f;
+            speed[i] = 0.0f;
+            yawRate[i] = 0.0f;
+        } else {
+            yawRate[i] += angularTorque / inertia[i] * dt;
+            heading[i] += yawRate[i] * dt;
+            positionX[i] += velocityX[i] * dt;
+            positionZ[i] += velocityZ[i] * dt;
+        }
+
+        // Wrap around like Entity rotations, so sine and cosine stay accurate
+        if(heading[i] > (float)M_PI * 2){
+            heading[i] -= (float)M_PI * 2;
+        } else if(heading[i] < (float)-M_PI * 2){
+            heading[i] += (float)M_PI * 2;
+        }
+    }
+}
+
+#ifdef SIMD_MATH_X86
+
+// sign() and clampAbs() above, on eight floats
+__attribute__((target("avx2")))
+static inline __m256 sign_avx2(__m256 value){
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    return _mm256_sub_ps(_mm256_and_ps(_mm256_cmp_ps(value, zero, _CMP_GT_OQ), one),
+                         _mm256_and_ps(_mm256_cmp_ps(value, zero, _CMP_LT_OQ), one));
+}
+
+__attribute__((target("avx2")))
+static inline __m256 clampAbs_avx2(__m256 value, __m256 limit){
+    __m256 negLimit = _mm256_sub_ps(_mm256_setzero_ps(), limit);
+    return _mm256_max_ps(negLimit, _mm256_min_ps(value, limit));
+}
+
+__attribute__((target("avx2")))
+static inline __m256 abs_avx2(__m256 value){
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), value);
+}
+
+// Same steps as stepScalar, see there for what each one is.
+__attribute__((target("avx2")))
+void VehicleSim::stepAVX2(float dt, size_t begin, size_t end){
+    __m256 vdt = _mm256_set1_ps(dt);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 twoPi = _mm256_set1_ps((float)M_PI * 2);
+    __m256 negTwoPi = _mm256_set1_ps((float)-M_PI * 2);
+    size_t i = begin;
+    for(; i + GROUP_SIZE <= end; i += GROUP_SIZE){
+        __m256 carHeading = _mm256_loadu_ps(&heading[i]);
+        __m256 vx = _mm256_loadu_ps(&velocityX[i]);
+        __m256 vz = _mm256_loadu_ps(&velocityZ[i]);
+        __m256 carYawRate = _mm256_loadu_ps(&yawRate[i]);
+        __m256 carSteer = _mm256_loadu_ps(&steer[i]);
+        __m256 carEbrake = _mm256_loadu_ps(&ebrake[i]);
+        __m256 carMass = _mm256_loadu_ps(&mass[i]);
+        __m256 frontAxle = _mm256_loadu_ps(&cgToFrontAxle[i]);
+        __m256 rearAxle = _mm256_loadu_ps(&cgToRearAxle[i]);
+
+        __m256 sn, cs;
+        sincos_avx2(carHeading, &sn, &cs);
+
+        __m256 forward = _mm256_add_ps(_mm256_mul_ps(cs, vz), _mm256_mul_ps(sn, vx));
+        __m256 sideways = _mm256_sub_ps(_mm256_mul_ps(cs, vx), _mm256_mul_ps(sn, vz));
+
+        __m256 carGravity = _mm256_loadu_ps(&gravity[i]);
+        __m256 transfer = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(&weightTransfer[i]),
+                                                                    _mm256_loadu_ps(&accelForward[i])),
+                                                      _mm256_loadu_ps(&cgHeight[i])),
+                                        _mm256_loadu_ps(&wheelBase[i]));
+        __m256 axleWeightFront = _mm256_mul_ps(carMass, _mm256_sub_ps(
+                _mm256_mul_ps(_mm256_loadu_ps(&axleWeightRatioFront[i]), carGravity), transfer));
+        __m256 axleWeightRear = _mm256_mul_ps(carMass, _mm256_add_ps(
+                _mm256_mul_ps(_mm256_loadu_ps(&axleWeightRatioRear[i]), carGravity), transfer));
+
+        __m256 yawSpeedFront = _mm256_mul_ps(frontAxle, carYawRate);
+        __m256 yawSpeedRear = _mm256_sub_ps(zero, _mm256_mul_ps(rearAxle, carYawRate));
+        __m256 absForward = abs_avx2(forward);
+        __m256 forwardSign = sign_avx2(forward);
+        __m256 slipAngleFront = _mm256_sub_ps(atan2_nonnegative_x_avx2(_mm256_add_ps(sideways, yawSpeedFront), absForward),
+                                              _mm256_mul_ps(forwardSign, carSteer));
+        __m256 slipAngleRear = atan2_nonnegative_x_avx2(_mm256_add_ps(sideways, yawSpeedRear), absForward);
+
+        __m256 tireGripFront = _mm256_loadu_ps(&tireGrip[i]);
+        __m256 tireGripRear = _mm256_mul_ps(tireGripFront, _mm256_sub_ps(one,
+                _mm256_mul_ps(carEbrake, _mm256_sub_ps(one, _mm256_loadu_ps(&lockGrip[i])))));
+        __m256 frictionFront = _mm256_mul_ps(clampAbs_avx2(_mm256_mul_ps(
+                _mm256_sub_ps(zero, _mm256_loadu_ps(&cornerStiffnessFront[i])), slipAngleFront), tireGripFront),
+                axleWeightFront);
+        __m256 frictionRear = _mm256_mul_ps(clampAbs_avx2(_mm256_mul_ps(
+                _mm256_sub_ps(zero, _mm256_loadu_ps(&cornerStiffnessRear[i])), slipAngleRear), tireGripRear),
+                axleWeightRear);
+
+        __m256 carBrakeForce = _mm256_loadu_ps(&brakeForce[i]);
+        __m256 brakeTotal = _mm256_min_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&brake[i]), carBrakeForce),
+                                                        _mm256_mul_ps(carEbrake, _mm256_loadu_ps(&eBrakeForce[i]))),
+                                          carBrakeForce);
+        __m256 throttleTotal = _mm256_mul_ps(_mm256_loadu_ps(&throttle[i]), _mm256_loadu_ps(&engineForce[i]));
+        __m256 tractionForward = _mm256_sub_ps(throttleTotal, _mm256_mul_ps(brakeTotal, forwardSign));
+        __m256 carRollResist = _mm256_loadu_ps(&rollResist[i]);
+        __m256 carAirResist = _mm256_loadu_ps(&airResist[i]);
+        __m256 dragForward = _mm256_sub_ps(_mm256_sub_ps(zero, _mm256_mul_ps(carRollResist, forward)),
+                                           _mm256_mul_ps(_mm256_mul_ps(carAirResist, forward), absForward));
+        __m256 dragSideways = _mm256_sub_ps(_mm256_sub_ps(zero, _mm256_mul_ps(carRollResist, sideways)),
+                                            _mm256_mul_ps(_mm256_mul_ps(carAirResist, sideways), abs_avx2(sideways)));
+        __m256 totalForward = _mm256_add_ps(dragForward, tractionForward);
+        __m256 steerSin, steerCos;
+        sincos_avx2(carSteer, &steerSin, &steerCos);
+        __m256 totalSideways = _mm256_add_ps(_mm256_add_ps(dragSideways, _mm256_mul_ps(steerCos, frictionFront)),
+                                             frictionRear);
+
+        __m256 accelSideways = _mm256_div_ps(totalSideways, carMass);
+        __m256 carAccelForward = _mm256_div_ps(totalForward, carMass);
+        _mm256_storeu_ps(&accelForward[i], carAccelForward);
+        vz = _mm256_add_ps(vz, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(cs, carAccelForward),
+                                                           _mm256_mul_ps(sn, accelSideways)), vdt));
+        vx = _mm256_add_ps(vx, _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sn, carAccelForward),
+                                                           _mm256_mul_ps(cs, accelSideways)), vdt));
+        __m256 carSpeed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vz, vz)));
+
+        __m256 coasting = _mm256_cmp_ps(throttleTotal, half, _CMP_LT_OQ);
+        __m256 damping = _mm256_blendv_ps(one, _mm256_sub_ps(one, _mm256_mul_ps(half, vdt)), coasting);
+        vx = _mm256_mul_ps(vx, damping);
+        vz = _mm256_mul_ps(vz, damping);
+
+        __m256 angularTorque = _mm256_sub_ps(_mm256_mul_ps(frictionFront, frontAxle),
+                                             _mm256_mul_ps(frictionRear, rearAxle));
+        __m256 stopped = _mm256_and_ps(coasting, _mm256_cmp_ps(carSpeed, _mm256_set1_ps(STOP_SPEED), _CMP_LT_OQ));
+        vx = _mm256_andnot_ps(stopped, vx);
+        vz = _mm256_andnot_ps(stopped, vz);
+        carSpeed = _mm256_andnot_ps(stopped, carSpeed);
+        carYawRate = _mm256_andnot_ps(stopped, _mm256_add_ps(carYawRate, _mm256_mul_ps(
+                _mm256_div_ps(angularTorque, _mm256_loadu_ps(&inertia[i])), vdt)));
+        // Stopped cars have zero velocity and yaw rate by now, so these leave them where they are.
+        carHeading = _mm256_add_ps(carHeading, _mm256_mul_ps(carYawRate, vdt));
+        carHeading = _mm256_blendv_ps(carHeading, _mm256_sub_ps(carHeading, twoPi),
+                                      _mm256_cmp_ps(carHeading, twoPi, _CMP_GT_OQ));
+        carHeading = _mm256_blendv_ps(carHeading, _mm256_add_ps(carHeading, twoPi),
+                                      _mm256_cmp_ps(carHeading, negTwoPi, _CMP_LT_OQ));
+
+        _mm256_storeu_ps(&positionX[i], _mm256_add_ps(_mm256_loadu_ps(&positionX[i]), _mm256_mul_ps(vx, vdt)));
+        _mm256_storeu_ps(&positionZ[i], _mm256_add_ps(_mm256_loadu_ps(&positionZ[i]), _mm256_mul_ps(vz, vdt)));
+        _mm256_storeu_ps(&heading[i], carHeading);
+        _mm256_storeu_ps(&velocityX[i], vx);
+        _mm256_storeu_ps(&velocityZ[i], vz);
+        _mm256_storeu_ps(&yawRate[i], carYawRate);
+        _mm256_storeu_ps(&speed[i], carSpeed);
+    }
+    stepScalar(dt, i, end);
+}
+
+#else
+
+void VehicleSim::stepAVX2(float dt, size_t begin, size_t end){
+    stepScalar(dt, begin, end);
+}
+
+#endif //SIMD_MATH_X86
+
+glm::vec2 VehicleSim::getPosition(size_t car) const {
+    return glm::vec2(positionX[car], positionZ[car]);
+}
+
+float VehicleSim::getHeading(size_t car) const {
+    return heading[car];
+}
+
+glm::vec2 VehicleSim::getVelocity(size_t car) const {
+    return glm::vec2(velocityX[car], velocityZ[car]);
+}
+
+float VehicleSim::getSpeed(size_t car) const {
+    return speed[car];
+}
+
+float VehicleSim::getYawRate(size_t car) const {
+    return yawRate[car];
+}
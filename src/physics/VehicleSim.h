@@ -0,0 +1,117 @@
+#ifndef VEHICLE_SIM_H
+#define VEHICLE_SIM_H
+
+#include <vector>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+/*
+    Tuning of one car for VehicleSim. The defaults are the player's Mustang.
+    Distances are in metres, masses in kg and forces in N.
+*/
+struct VehicleParams {
+    float gravity;
+    float mass;
+    float inertiaScale;         // Multiply by mass for inertia
+    float cgToFrontAxle;        // Centre of gravity to front axle
+    float cgToRearAxle;         // Centre of gravity to rear axle
+    float cgHeight;
+    float tireGrip;             // How much grip tires have
+    float lockGrip;             // Fraction of grip available when the wheel is locked
+    float engineForce;
+    float brakeForce;
+    float eBrakeForce;
+    float weightTransfer;       // How much weight is transferred during acceleration / braking
+    float maxSteer;             // Maximum steering angle in radians
+    float cornerStiffnessFront;
+    float cornerStiffnessRear;
+    float airResist;            // Air resistance (* velocity^2)
+    float rollResist;           // Rolling resistance (* velocity)
+
+    VehicleParams();
+};
+
+// Driver controls of one car for the next steps. Pedals are in [0, 1], steer is the wheel angle in radians.
+struct VehicleInput {
+    float throttle;
+    float brake;
+    float ebrake;
+    float steer;
+
+    VehicleInput(): throttle(0.0f), brake(0.0f), ebrake(0.0f), steer(0.0f) {}
+};
+
+/*
+    Top down car physics for many cars at once, adapted from
+        https://github.com/spacejack/carphysics2d
+    with one addition: a car with no throttle slows down and stops below 2 m/s.
+
+    Every car has its own parameters. State, inputs and parameters are all kept one array per field, so step()
+    works through eight cars at a time with AVX2 and splits large batches over the ThreadPool.
+    Positions are on the ground plane, (x, z) in world coordinates. The heading is the rotation about y, as in
+    Entity, so a car with heading 0 faces +z.
+*/
+class VehicleSim {
+public:
+    enum Path {
+        SCALAR,
+        AVX2
+    };
+
+    // Batches smaller than this are stepped on the calling thread only.
+    static const size_t PARALLEL_THRESHOLD;
+
+private:
+    // State
+    std::vector<float> positionX, positionZ;
+    std::vector<float> heading;
+    std::vector<float> velocityX, velocityZ;    // World space
+    std::vector<float> yawRate;
+    std::vector<float> accelForward;            // Last step's acceleration along the car, moves weight between axles
+    std::vector<float> speed;
+
+    // Inputs
+    std::vector<float> throttle, brake, ebrake, steer;
+
+    // Parameters, with the derived ones worked out once when the car is added
+    std::vector<float> gravity, mass, inertia, cgHeight, wheelBase;
+    std::vector<float> cgToFrontAxle, cgToRearAxle, axleWeightRatioFront, axleWeightRatioRear;
+    std::vector<float> tireGrip, lockGrip, engineForce, brakeForce, eBrakeForce, weightTransfer;
+    std::vector<float> cornerStiffnessFront, cornerStiffnessRear, airResist, rollResist, maxSteer;
+
+    void stepScalar(float dt, size_t begin, size_t end);
+    void stepAVX2(float dt, size_t begin, size_t end);
+    void stepRange(float dt, size_t begin, size_t end, Path path);
+
+public:
+    VehicleSim();
+
+    // Fastest path supported by the CPU, detected once.
+    static Path getBestPath();
+    static const char* getPathName(Path path);
+
+    void reserve(size_t count);
+    size_t size() const;
+
+    // Returns the index of the new car, at rest.
+    size_t add(const VehicleParams& params, glm::vec2 position, float heading);
+    // The steering angle is limited to the car's maxSteer.
+    void setInput(size_t car, const VehicleInput& input);
+    // Moves the car without changing its velocity, e.g. when something else decides where it is.
+    void setPose(size_t car, glm::vec2 position, float heading);
+    // World space velocity, e.g. after a collision.
+    void setVelocity(size_t car, glm::vec2 velocity);
+
+    // Advances every car by dt seconds.
+    void step(float dt);
+    void step(float dt, Path path);
+
+    glm::vec2 getPosition(size_t car) const;
+    float getHeading(size_t car) const;
+    glm::vec2 getVelocity(size_t car) const;
+    float getSpeed(size_t car) const;
+    float getYawRate(size_t car) const;
+};
+
+#endif //VEHICLE_SIM_H
@@ -1,13 +1,24 @@
 #include "EntityRenderer.h"
 
+#include "../utils/Profiler.h"
+
 EntityRenderer::EntityRenderer():
     PhongShader(ENTITY_PHONG_VERTEX_SHADER, ENTITY_PHONG_FRAGMENT_SHADER),
     GouraudShader(ENTITY_GOURAUD_VERTEX_SHADER, ENTITY_GOURAUD_FRAGMENT_SHADER) {
+    glGenBuffers(1, &instanceBuffer);
+    instanceBufferBytes = 0;
 }
 
-void EntityRenderer::render(std::vector<Entity*> entities, std::vector<Light*> lights, glm::mat4 view,
-        glm::mat4 proj, bool use_fog, bool use_phong){
-    EntityShader shader = use_phong ? PhongShader : GouraudShader;
+void EntityRenderer::render(const EntityStore& entities, const std::vector<Light*>& lights, glm::mat4 view,
+        glm::mat4 proj, bool use_fog, bool use_phong, const StaticBatcher* staticBatches){
+    PROFILE_SCOPE("entities");
+    Frustum frustum(proj, view);
+    visible.clear();
+    RenderStats* stats = RenderStats::getRenderStats();
+    stats->entitiesCulled += entities.collectVisible(frustum, visible);
+    stats->entitiesDrawn += visible.size();
+
+    EntityShader& shader = use_phong ? PhongShader : GouraudShader;
 
     shader.enable();
     shader.loadProjection(proj);
@@ -15,45 +26,128 @@ void EntityRenderer::render(std::vector<Entity*> entities, std::vector<Light*> l
     shader.loadView(view);
 
     shader.loadUseFog(use_fog);
+    shader.loadUseInstancing(false);
 
-    for(size_t i = 0; i < entities.size(); ++i){
-        shader.loadEntity(entities[i]);
-        if(entities[i]->getModel() != NULL){
-            renderModel(entities[i]->getModel(), use_phong);
+    for(size_t i = 0; i < visible.size(); ++i){
+        shader.loadModelMatrix(entities.getMatrix(visible[i]), entities.getNormalMatrix(visible[i]));
+        renderModel(entities.getModel(visible[i]), use_phong);
+    }
+
+    // Batches are already in world space.
+    if(staticBatches != NULL){
+        const std::vector<StaticBatcher::Batch>& batches = staticBatches->getBatches();
+        shader.loadModelMatrix(glm::mat4(1.0f), glm::mat3(1.0f));
+        for(size_t i = 0; i < batches.size(); ++i){
+            if(!frustum.intersectsBox(batches[i].min, batches[i].max)) continue;
+            renderComponent(batches[i].component, use_phong);
         }
     }
 
     shader.disable();
 }
 
+void EntityRenderer::renderInstances(Model* model, const std::vector<glm::mat4>& matrices,
+        const std::vector<Light*>& lights, glm::mat4 view, glm::mat4 proj, bool use_fog, bool use_phong){
+    PROFILE_SCOPE("instanced entities");
+    if(model->getRangeInDim(0).first > model->getRangeInDim(0).second) return;
+    glm::vec3 min, max;
+    for(int dim = 0; dim < 3; ++dim){
+        std::pair<float, float> range = model->getRangeInDim(dim);
+        min[dim] = range.first;
+        max[dim] = range.second;
+    }
+    glm::vec4 centre((min + max) * 0.5f, 1.0f);
+    float radius = glm::length(max - min) * 0.5f;
+
+    Frustum frustum(proj, view);
+    visibleInstances.clear();
+    for(size_t i = 0; i < matrices.size(); ++i){
+        float scale = glm::length(matrices[i][0]);
+        if(frustum.intersectsSphere(glm::vec3(matrices[i] * centre), radius * scale)){
+            visibleInstances.push_back(matrices[i]);
+        }
+    }
+    RenderStats* stats = RenderStats::getRenderStats();
+    stats->entitiesDrawn += visibleInstances.size();
+    stats->entitiesCulled += matrices.size() - visibleInstances.size();
+    if(visibleInstances.empty()) return;
+
+    // Orphan the old contents rather than wait for draws still reading them.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    long long instanceBytes = visibleInstances.size() * sizeof(glm::mat4);
+    glBufferData(GL_ARRAY_BUFFER, instanceBytes, NULL, GL_STREAM_DRAW);
+    stats->addBufferMemory(instanceBytes - instanceBufferBytes);
+    instanceBufferBytes = instanceBytes;
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceBytes, &visibleInstances[0]);
+
+    EntityShader& shader = use_phong ? PhongShader : GouraudShader;
+
+    shader.enable();
+    shader.loadProjection(proj);
+    shader.loadLights(lights);
+    shader.loadView(view);
+    shader.loadUseFog(use_fog);
+    shader.loadModelMatrix(glm::mat4(1.0f), glm::mat3(1.0f));
+    shader.loadUseInstancing(true);
+
+    std::vector<ModelComponent>* components = model->getModelComponents();
+    for(size_t i = 0; i < components->size(); ++i){
+        renderComponent(components->at(i), use_phong, visibleInstances.size());
+    }
+
+    shader.loadUseInstancing(false);
+    shader.disable();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void EntityRenderer::renderModel(Model* model, bool use_phong){
     std::vector<ModelComponent>* components = model->getModelComponents();
     for(size_t i = 0; i < components->size(); ++i){
-        ModelComponent current = components->at(i);
+        renderComponent(components->at(i), use_phong);
+    }
+}
 
-        if(use_phong) {
-            PhongShader.loadModelComponent(current);
-        }
-        else {
-            GouraudShader.loadModelComponent(current);
-        }
+void EntityRenderer::renderComponent(const ModelComponent& current, bool use_phong, int instances){
+    if(use_phong) {
+        PhongShader.loadModelComponent(current);
+    }
+    else {
+        GouraudShader.loadModelComponent(current);
+    }
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, current.getTextureID());
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, current.getTextureID());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-        glBindVertexArray(current.getVaoID());
+    glBindVertexArray(current.getVaoID());
 
-        glEnableVertexAttribArray(0);
-        glEnableVertexAttribArray(1);
-        glEnableVertexAttribArray(2);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
 
+    if(instances > 0){
+        // A mat4 attribute takes four locations, one column each, all read from the instance buffer.
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        for(int column = 0; column < 4; column++){
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  (void*)(column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(3 + column, 1);
+        }
+        glDrawElementsInstanced(GL_TRIANGLES, current.getIndexCount(), GL_UNSIGNED_INT, (void*)0, instances);
+        RenderStats::getRenderStats()->addDraw((long long)current.getIndexCount() * instances);
+        for(int column = 0; column < 4; column++){
+            glDisableVertexAttribArray(3 + column);
+        }
+    }
+    else {
         glDrawElements(GL_TRIANGLES, current.getIndexCount(), GL_UNSIGNED_INT, (void*)0);
-
-        glDisableVertexAttribArray(0);
-        glDisableVertexAttribArray(1);
-        glDisableVertexAttribArray(2);
-        glBindVertexArray(0);
+        RenderStats::getRenderStats()->addDraw(current.getIndexCount());
     }
+
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glDisableVertexAttribArray(2);
+    glBindVertexArray(0);
 }
\ No newline at end of file
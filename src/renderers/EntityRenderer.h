@@ -9,7 +9,11 @@
 #include "../src/shaders/EntityShader.h"
 #include "../objects/Light.h"
 #include "../objects/Camera.h"
+#include "../objects/EntityStore.h"
+#include "StaticBatcher.h"
 #include "../utils/Model.h"
+#include "../utils/Frustum.h"
+#include "../utils/RenderStats.h"
 
 #include <cstdio>
 #include <string>
@@ -24,12 +28,23 @@ class EntityRenderer {
 private:
     EntityShader PhongShader;
     EntityShader GouraudShader;
+
+    std::vector<EntityHandle> visible;  // Reused between frames
+    std::vector<glm::mat4> visibleInstances;
+    GLuint instanceBuffer;              // Model matrices of the instances being drawn, refilled every call
+    long long instanceBufferBytes;
 public:
     EntityRenderer();
 
-    void render(std::vector<Entity*> entities, std::vector<Light*> lights, glm::mat4 view, glm::mat4 proj,
-            bool use_fog, bool use_phong);
+    // Entities whose bounding sphere is outside the view frustum are skipped, as are static batches whose bounds are.
+    void render(const EntityStore& entities, const std::vector<Light*>& lights, glm::mat4 view, glm::mat4 proj,
+            bool use_fog, bool use_phong, const StaticBatcher* staticBatches = NULL);
+    // Draws the model once per matrix with one instanced draw call per component, skipping instances outside
+    // the view frustum. The matrices may only rotate and scale uniformly.
+    void renderInstances(Model* model, const std::vector<glm::mat4>& matrices, const std::vector<Light*>& lights,
+            glm::mat4 view, glm::mat4 proj, bool use_fog, bool use_phong);
     void renderModel(Model* model, bool use_phong);
+    void renderComponent(const ModelComponent& component, bool use_phong, int instances = 0);
 };
 
 #endif //ENTITY_RENDERER_H
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "HudRenderer.h"
+
+#include <algorithm>
+
+// Glyph cells are CELL_SIZE pixels square, ATLAS_COLUMNS to a row, with one solid cell after the last glyph.
+static const int FIRST_CHARACTER = ' ';
+static const int CHARACTER_COUNT = '_' - ' ' + 1;
+static const int SOLID_CELL = CHARACTER_COUNT;
+static const int CELL_SIZE = 8;
+static const int ATLAS_COLUMNS = 16;
+static const int ATLAS_WIDTH = ATLAS_COLUMNS * CELL_SIZE;
+static const int ATLAS_HEIGHT = (CHARACTER_COUNT / ATLAS_COLUMNS + 1) * CELL_SIZE;
+
+// One row of five bits per line, the highest bit on the left, from ' ' to '_'.
+static const unsigned char FONT[CHARACTER_COUNT][HudRenderer::GLYPH_HEIGHT] = {
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},     // ' '
+        {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04},     // !
+        {0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00},     // "
+        {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A},     // #
+        {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04},     // $
+        {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03},     // %
+        {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D},     // &
+        {0x0C, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00},     // '
+        {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02},     // (
+        {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08},     // )
+        {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00},     // *
+        {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00},     // +
+        {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08},     // ,
+        {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},     // -
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C},     // .
+        {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00},     // /
+        {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},     // 0
+        {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},     // 1
+        {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},     // 2
+        {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},     // 3
+        {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},     // 4
+        {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},     // 5
+        {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},     // 6
+        {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},     // 7
+        {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},     // 8
+        {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},     // 9
+        {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00},     // :
+        {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08},     // ;
+        {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02},     // <
+        {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00},     // =
+        {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08},     // >
+        {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04},     // ?
+        {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E},     // @
+        {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11},     // A
+        {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},     // B
+        {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},     // C
+        {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C},     // D
+        {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},     // E
+        {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},     // F
+        {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F},     // G
+        {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},     // H
+        {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},     // I
+        {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C},     // J
+        {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},     // K
+        {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},     // L
+        {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},     // M
+        {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},     // N
+        {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},     // O
+        {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},     // P
+        {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},     // Q
+        {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},     // R
+        {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},     // S
+        {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},     // T
+        {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},     // U
+        {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},     // V
+        {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},     // W
+        {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},     // X
+        {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04},     // Y
+        {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F},     // Z
+        {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E},     // [
+        {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00},     // backslash
+        {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E},     // ]
+        {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00},     // ^
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}      // _
+};
+
+static glm::vec2 cellCorner(int cell){
+    return glm::vec2((float)(cell % ATLAS_COLUMNS * CELL_SIZE) / ATLAS_WIDTH,
+                     (float)(cell / ATLAS_COLUMNS * CELL_SIZE) / ATLAS_HEIGHT);
+}
+
+// Centre of the solid cell, where panels and lines sample full coverage.
+static glm::vec2 solidTexCoord(){
+    return cellCorner(SOLID_CELL) + glm::vec2(0.5f * CELL_SIZE / ATLAS_WIDTH, 0.5f * CELL_SIZE / ATLAS_HEIGHT);
+}
+
+static int glyphCell(char c){
+    if(c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+    if(c < FIRST_CHARACTER || c >= FIRST_CHARACTER + CHARACTER_COUNT) c = '?';
+    return c - FIRST_CHARACTER;
+}
+
+HudRenderer::HudRenderer(): vertexBufferBytes(0), screenSize(1.0f) {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vertexBuffer);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(2 * sizeof(float)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    createAtlas();
+}
+
+HudRenderer::~HudRenderer(){
+    RenderStats::getRenderStats()->addBufferMemory(-vertexBufferBytes);
+    RenderStats::getRenderStats()->addTextureMemory(-(long long)ATLAS_WIDTH * ATLAS_HEIGHT);
+    glDeleteTextures(1, &atlas);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteVertexArrays(1, &vao);
+}
+
+// Single channel coverage, unfiltered so the glyphs stay sharp at whole number scales.
+void HudRenderer::createAtlas(){
+    std::vector<GLubyte> pixels(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+    for(int cell = 0; cell < CHARACTER_COUNT; cell++){
+        int left = cell % ATLAS_COLUMNS * CELL_SIZE;
+        int top = cell / ATLAS_COLUMNS * CELL_SIZE;
+        for(int row = 0; row < GLYPH_HEIGHT; row++){
+            for(int column = 0; column < GLYPH_WIDTH; column++){
+                if(FONT[cell][row] & (1 << (GLYPH_WIDTH - 1 - column))){
+                    pixels[(top + row) * ATLAS_WIDTH + left + column] = 255;
+                }
+            }
+        }
+    }
+    int solidLeft = SOLID_CELL % ATLAS_COLUMNS * CELL_SIZE;
+    int solidTop = SOLID_CELL / ATLAS_COLUMNS * CELL_SIZE;
+    for(int row = 0; row < CELL_SIZE; row++){
+        for(int column = 0; column < CELL_SIZE; column++){
+            pixels[(solidTop + row) * ATLAS_WIDTH + solidLeft + column] = 255;
+        }
+    }
+
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, &pixels[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderStats::getRenderStats()->addTextureMemory((long long)ATLAS_WIDTH * ATLAS_HEIGHT);
+}
+
+void HudRenderer::beginFrame(int width, int height){
+    vertices.clear();
+    screenSize = glm::vec2((float)width, (float)height);
+}
+
+// Two triangles, a b c and c d a, with a at uvMin and c at uvMax.
+void HudRenderer::addQuad(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 d, glm::vec2 uvMin, glm::vec2 uvMax,
+        glm::vec4 colour){
+    const glm::vec2 corners[6] = {a, b, c, c, d, a};
+    const glm::vec2 uvs[6] = {uvMin, glm::vec2(uvMax.x, uvMin.y), uvMax,
+                              uvMax, glm::vec2(uvMin.x, uvMax.y), uvMin};
+    for(int i = 0; i < 6; i++){
+        vertices.push_back(corners[i].x);
+        vertices.push_back(corners[i].y);
+        vertices.push_back(uvs[i].x);
+        vertices.push_back(uvs[i].y);
+        vertices.push_back(colour.r);
+        vertices.push_back(colour.g);
+        vertices.push_back(colour.b);
+        vertices.push_back(colour.a);
+    }
+}
+
+void HudRenderer::rect(float x, float y, float width, float height, glm::vec4 colour){
+    glm::vec2 uv = solidTexCoord();
+    addQuad(glm::vec2(x, y), glm::vec2(x + width, y), glm::vec2(x + width, y + height), glm::vec2(x, y + height),
+            uv, uv, colour);
+}
+
+void HudRenderer::line(glm::vec2 from, glm::vec2 to, float thickness, glm::vec4 colour){
+    glm::vec2 direction = to - from;
+    float length = glm::length(direction);
+    if(length <= 0.0f) return;
+    glm::vec2 side = glm::vec2(-direction.y, direction.x) / length * (thickness * 0.5f);
+    glm::vec2 uv = solidTexCoord();
+    addQuad(from - side, to - side, to + side, from + side, uv, uv, colour);
+}
+
+void HudRenderer::text(float x, float y, const char* string, float scale, glm::vec4 colour){
+    glm::vec2 cellSize((float)CELL_SIZE / ATLAS_WIDTH, (float)CELL_SIZE / ATLAS_HEIGHT);
+    glm::vec2 glyphSize = cellSize * glm::vec2((float)GLYPH_WIDTH / CELL_SIZE, (float)GLYPH_HEIGHT / CELL_SIZE);
+    float width = GLYPH_WIDTH * scale;
+    float height = GLYPH_HEIGHT * scale;
+    float left = x;
+    for(const char* c = string; *c != '\0'; c++){
+        if(*c == '\n'){
+            x = left;
+            y += LINE_HEIGHT * scale;
+            continue;
+        }
+        if(*c != ' '){
+            glm::vec2 uvMin = cellCorner(glyphCell(*c));
+            addQuad(glm::vec2(x, y), glm::vec2(x + width, y), glm::vec2(x + width, y + height),
+                    glm::vec2(x, y + height), uvMin, uvMin + glyphSize, colour);
+        }
+        x += ADVANCE * scale;
+    }
+}
+
+void HudRenderer::graph(float x, float y, float width, float height, const float* values, int count, int first,
+        float maxValue, glm::vec4 colour){
+    if(count < 2 || maxValue <= 0.0f) return;
+    float step = width / (count - 1);
+    glm::vec2 previous;
+    for(int i = 0; i < count; i++){
+        float value = std::min(values[(first + i) % count], maxValue);
+        glm::vec2 point(x + i * step, y + height - value / maxValue * height);
+        if(i > 0) line(previous, point, 1.5f, colour);
+        previous = point;
+    }
+}
+
+// Of the longest line.
+float HudRenderer::textWidth(const char* string, float scale){
+    int longest = 0;
+    int length = 0;
+    for(const char* c = string; *c != '\0'; c++){
+        length = *c == '\n' ? 0 : length + 1;
+        longest = std::max(longest, length);
+    }
+    return longest > 0 ? ((longest - 1) * ADVANCE + GLYPH_WIDTH) * scale : 0.0f;
+}
+
+void HudRenderer::draw(){
+    if(vertices.empty()) return;
+
+    // Orphan the old contents rather than wait for the previous frame's draw.
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    long long bytes = vertices.size() * sizeof(float);
+    glBufferData(GL_ARRAY_BUFFER, bytes, &vertices[0], GL_STREAM_DRAW);
+    RenderStats::getRenderStats()->addBufferMemory(bytes - vertexBufferBytes);
+    vertexBufferBytes = bytes;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    GLint blendSource, blendDestination;
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSource);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDestination);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    shader.enable();
+    shader.loadScreenSize(screenSize);
+    shader.loadAtlasUnit(0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / FLOATS_PER_VERTEX);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    shader.disable();
+
+    glBlendFunc(blendSource, blendDestination);
+    if(!blend) glDisable(GL_BLEND);
+    if(depthTest) glEnable(GL_DEPTH_TEST);
+    if(cullFace) glEnable(GL_CULL_FACE);
+}
@@ -0,0 +1,74 @@
+#ifndef HUD_RENDERER_H
+#define HUD_RENDERER_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../src/shaders/HudShader.h"
+#include "../utils/RenderStats.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/*
+    Screen space overlay of panels, text and line graphs, in pixels from the top left corner.
+
+    Everything added between beginFrame() and draw() goes into one vertex buffer and is drawn with a single draw call.
+    Text uses a built in 5x7 pixel font of the printable ASCII characters up to '_', lower case letters are drawn as
+    upper case and anything else as '?'. Panels and lines sample a solid cell of the same atlas, so they need no
+    other texture or shader.
+*/
+class HudRenderer {
+public:
+    static const int GLYPH_WIDTH = 5;
+    static const int GLYPH_HEIGHT = 7;
+    static const int ADVANCE = GLYPH_WIDTH + 1;     // In font pixels, between the starts of two characters
+    static const int LINE_HEIGHT = GLYPH_HEIGHT + 3;
+
+private:
+    // Position, texture coordinate and colour
+    static const int FLOATS_PER_VERTEX = 8;
+
+    HudShader shader;
+    GLuint vao;
+    GLuint vertexBuffer;
+    long long vertexBufferBytes;
+    GLuint atlas;
+    std::vector<float> vertices;    // Reused between frames
+    glm::vec2 screenSize;
+
+    HudRenderer(const HudRenderer&);
+    HudRenderer& operator=(const HudRenderer&);
+
+    void createAtlas();
+    void addQuad(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 d, glm::vec2 uvMin, glm::vec2 uvMax,
+            glm::vec4 colour);
+
+public:
+    HudRenderer();
+    ~HudRenderer();
+
+    // Clears what was added for the previous frame.
+    void beginFrame(int width, int height);
+
+    void rect(float x, float y, float width, float height, glm::vec4 colour);
+    void line(glm::vec2 from, glm::vec2 to, float thickness, glm::vec4 colour);
+    // Newlines start a new line below x. Each font pixel is scale screen pixels.
+    void text(float x, float y, const char* string, float scale, glm::vec4 colour);
+    // Line through count values scaled so maxValue is at the top of the box, starting at values[first] and
+    // wrapping round, as kept in a ring buffer. Values above maxValue are clamped to it.
+    void graph(float x, float y, float width, float height, const float* values, int count, int first,
+            float maxValue, glm::vec4 colour);
+
+    static float textWidth(const char* string, float scale);
+
+    // Draws everything added since beginFrame() on top of the current frame buffer, in one draw call. Blending,
+    // depth testing and face culling are put back as they were. Not counted in RenderStats, so showing the overlay
+    // does not change the numbers on it.
+    void draw();
+};
+
+#endif //HUD_RENDERER_H
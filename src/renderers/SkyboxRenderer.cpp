@@ -1,5 +1,7 @@
 #include "SkyboxRenderer.h"
 
+#include "../utils/Profiler.h"
+
 SkyboxRenderer::SkyboxRenderer(std::vector<std::string> images, const float SIZE){
     this->shader = SkyboxShader();
 
@@ -30,6 +32,7 @@ SkyboxRenderer::SkyboxRenderer(std::vector<std::string> images, const float SIZE
 }
 
 void SkyboxRenderer::render(glm::mat4 view, glm::mat4 projection) {
+    PROFILE_SCOPE("skybox");
     if(!enabled) return;
 
     glDisable(GL_CULL_FACE);
@@ -42,6 +45,7 @@ void SkyboxRenderer::render(glm::mat4 view, glm::mat4 projection) {
     shader.loadMatrices(view, projection);
 
     glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void *) 0);
+    RenderStats::getRenderStats()->addDraw(indexCount);
 
     glDisableVertexAttribArray(0);
     glBindVertexArray(0);
@@ -11,6 +11,7 @@
 #include "../objects/Camera.h"
 #include "../utils/Model.h"
 #include "../utils/Loader.h"
+#include "../utils/RenderStats.h"
 
 #include <cstdio>
 #include <string>
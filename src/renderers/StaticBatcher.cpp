@@ -0,0 +1,154 @@
+#include "StaticBatcher.h"
+
+#include "../utils/Profiler.h"
+
+const float StaticBatcher::CELL_SIZE = 75.0f;
+const size_t StaticBatcher::MAX_BATCHED_VERTICES = 20000;
+
+// Geometry collected for one batch before it is uploaded.
+struct StaticBatcher::Builder {
+    ModelComponent source;  // First component added, gives the texture and material
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texCoords;
+    std::vector<unsigned int> indices;
+    glm::vec3 min;
+    glm::vec3 max;
+
+    Builder(): min(glm::vec3(FLT_MAX)), max(glm::vec3(-FLT_MAX)) {}
+};
+
+// Batches are split by cell, texture and every material value the entity shader reads.
+struct BatchKey {
+    int cellX;
+    int cellZ;
+    GLuint textureID;
+    tinyobj::material_t material;
+
+    bool operator<(const BatchKey& other) const {
+        if(cellX != other.cellX) return cellX < other.cellX;
+        if(cellZ != other.cellZ) return cellZ < other.cellZ;
+        if(textureID != other.textureID) return textureID < other.textureID;
+        const tinyobj::material_t& a = material;
+        const tinyobj::material_t& b = other.material;
+        for(int i = 0; i < 3; i++){
+            if(a.ambient[i] != b.ambient[i]) return a.ambient[i] < b.ambient[i];
+            if(a.diffuse[i] != b.diffuse[i]) return a.diffuse[i] < b.diffuse[i];
+            if(a.specular[i] != b.specular[i]) return a.specular[i] < b.specular[i];
+            if(a.emission[i] != b.emission[i]) return a.emission[i] < b.emission[i];
+        }
+        return a.shininess < b.shininess;
+    }
+};
+
+StaticBatcher::StaticBatcher(){
+}
+
+StaticBatcher::~StaticBatcher(){
+    clear();
+}
+
+bool StaticBatcher::isBatchable(Model* model){
+    if(model == NULL) return false;
+    std::vector<ModelComponent>* components = model->getModelComponents();
+    for(size_t i = 0; i < components->size(); i++){
+        const tinyobj::mesh_t* mesh = components->at(i).getMesh();
+        if(mesh == NULL || mesh->positions.size() / 3 > MAX_BATCHED_VERTICES) return false;
+    }
+    return !components->empty();
+}
+
+void StaticBatcher::build(EntityStore& store){
+    PROFILE_SCOPE("static batching");
+    release(store);
+    store.flushTransforms();
+
+    std::map<BatchKey, Builder> builders;
+    for(EntityHandle handle = 0; handle < store.size(); handle++){
+        unsigned char flags = store.getFlags(handle);
+        if(!(flags & EntityStore::STATIC) || (flags & EntityStore::HIDDEN)) continue;
+        Model* model = store.getModel(handle);
+        if(!isBatchable(model)) continue;
+
+        const glm::mat4& matrix = store.getMatrix(handle);
+        const glm::mat3& normalMatrix = store.getNormalMatrix(handle);
+        glm::vec3 position = store.getPosition(handle);
+
+        std::vector<ModelComponent>* components = model->getModelComponents();
+        for(size_t c = 0; c < components->size(); c++){
+            const ModelComponent& component = components->at(c);
+            const tinyobj::mesh_t* mesh = component.getMesh();
+
+            BatchKey key;
+            key.cellX = (int)std::floor(position.x / CELL_SIZE);
+            key.cellZ = (int)std::floor(position.z / CELL_SIZE);
+            key.textureID = component.getTextureID();
+            key.material = component.getMaterial();
+            Builder& builder = builders[key];
+            if(builder.indices.empty()) builder.source = component;
+
+            unsigned int base = builder.positions.size() / 3;
+            size_t vertexCount = mesh->positions.size() / 3;
+            bool hasNormals = mesh->normals.size() == mesh->positions.size();
+            bool hasTexCoords = mesh->texcoords.size() / 2 == vertexCount;
+            for(size_t v = 0; v < vertexCount; v++){
+                glm::vec3 p = glm::vec3(matrix * glm::vec4(mesh->positions[3 * v], mesh->positions[3 * v + 1],
+                                                           mesh->positions[3 * v + 2], 1.0f));
+                glm::vec3 n = hasNormals ? glm::vec3(mesh->normals[3 * v], mesh->normals[3 * v + 1],
+                                                     mesh->normals[3 * v + 2]) : glm::vec3(0.0f, 1.0f, 0.0f);
+                n = glm::normalize(normalMatrix * n);
+                builder.positions.insert(builder.positions.end(), {p.x, p.y, p.z});
+                builder.normals.insert(builder.normals.end(), {n.x, n.y, n.z});
+                builder.texCoords.push_back(hasTexCoords ? mesh->texcoords[2 * v] : 0.0f);
+                builder.texCoords.push_back(hasTexCoords ? mesh->texcoords[2 * v + 1] : 0.0f);
+                builder.min = glm::min(builder.min, p);
+                builder.max = glm::max(builder.max, p);
+            }
+            for(size_t i = 0; i < mesh->indices.size(); i++){
+                builder.indices.push_back(base + mesh->indices[i]);
+            }
+        }
+
+        store.setFlags(handle, flags | EntityStore::HIDDEN);
+        batched.push_back(handle);
+    }
+
+    for(std::map<BatchKey, Builder>::iterator it = builders.begin(); it != builders.end(); ++it){
+        Builder& builder = it->second;
+        if(builder.indices.empty()) continue;
+        GLuint vao = Loader::getLoader()->loadVAO(&builder.positions[0], builder.positions.size() / 3,
+                &builder.indices[0], builder.indices.size(), &builder.texCoords[0], &builder.normals[0]);
+
+        Batch batch;
+        batch.component = ModelComponent(vao, builder.indices.size(), builder.source.getTextureID(),
+                                         builder.source.getMaterial());
+        batch.min = builder.min;
+        batch.max = builder.max;
+        batches.push_back(batch);
+    }
+    std::cout << "[StaticBatcher] Merged " << batched.size() << " props into " << batches.size() << " batches"
+              << std::endl;
+}
+
+void StaticBatcher::release(EntityStore& store){
+    for(size_t i = 0; i < batched.size(); i++){
+        store.setFlags(batched[i], store.getFlags(batched[i]) & ~EntityStore::HIDDEN);
+    }
+    batched.clear();
+    clear();
+}
+
+void StaticBatcher::clear(){
+    for(size_t i = 0; i < batches.size(); i++){
+        Loader::getLoader()->deleteVAO(batches[i].component.getVaoID());
+    }
+    batches.clear();
+}
+
+const std::vector<StaticBatcher::Batch>& StaticBatcher::getBatches() const {
+    return batches;
+}
+
+size_t StaticBatcher::getBatchedEntityCount() const {
+    return batched.size();
+}
@@ -0,0 +1,58 @@
+#ifndef STATIC_BATCHER_H
+#define STATIC_BATCHER_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../objects/EntityStore.h"
+#include "../utils/Model.h"
+#include "../utils/Loader.h"
+
+#include <vector>
+#include <map>
+
+#include <glm/glm.hpp>
+
+/*
+    Merges the meshes of props which never move into a few large world space buffers, one per material in each
+    cell of a square grid, so that hundreds of small draws become a few dozen while culling still works per cell.
+
+    Built once after the props are placed. Batched props are hidden in the EntityStore and drawn through
+    getBatches() instead. Models with large components are left alone, merging them saves nothing.
+*/
+class StaticBatcher {
+public:
+    struct Batch {
+        ModelComponent component;   // Merged buffers with the material and texture shared by everything in it
+        glm::vec3 min;              // World space bounds
+        glm::vec3 max;
+    };
+
+    static const float CELL_SIZE;
+    static const size_t MAX_BATCHED_VERTICES;   // Per model component
+
+private:
+    struct Builder;
+
+    std::vector<Batch> batches;
+    std::vector<EntityHandle> batched;
+
+    static bool isBatchable(Model* model);
+    void clear();
+
+public:
+    StaticBatcher();
+    virtual ~StaticBatcher();
+
+    // Batches every static, visible prop in the store and hides the originals. Rebuilding first restores them.
+    void build(EntityStore& store);
+    // Shows the batched props in the store again and frees the merged buffers.
+    void release(EntityStore& store);
+
+    const std::vector<Batch>& getBatches() const;
+    size_t getBatchedEntityCount() const;
+};
+
+#endif //STATIC_BATCHER_H
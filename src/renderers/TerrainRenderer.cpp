@@ -1,18 +1,22 @@
 #include "TerrainRenderer.h"
 
+#include "../utils/Profiler.h"
+
+const int TerrainRenderer::MACRO_TEXTURE_SIZE = 2048;
+
 TerrainRenderer::TerrainRenderer(){
     this->shader = TerrainShader();
+    glGenVertexArrays(1, &emptyVao);
 }
 
-void TerrainRenderer::render(Terrain* terrain, std::vector<Light*> lights, glm::mat4 view, glm::mat4 proj, bool use_fog){
-    shader.enable();
-    shader.loadProjection(proj);
-    shader.loadLights(lights);
-    shader.loadView(view);
-    shader.loadUseFog(use_fog);
-
-    shader.loadTerrain(terrain);
+TerrainRenderer::~TerrainRenderer(){
+    for(std::map<GLuint, FrameBuffer*>::iterator it = macroTextures.begin(); it != macroTextures.end(); ++it){
+        delete it->second;
+    }
+    glDeleteVertexArrays(1, &emptyVao);
+}
 
+void TerrainRenderer::bindTextures(Terrain* terrain){
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, terrain->getTextureID(0));
     glActiveTexture(GL_TEXTURE1);
@@ -23,6 +27,106 @@ void TerrainRenderer::render(Terrain* terrain, std::vector<Light*> lights, glm::
     glBindTexture(GL_TEXTURE_2D, terrain->getTextureID(3));
     glActiveTexture(GL_TEXTURE4);
     glBindTexture(GL_TEXTURE_2D, terrain->getTextureID(4));
+}
+
+GLuint TerrainRenderer::bakeMacroTexture(Terrain* terrain){
+    // Binding the frame buffer changes the viewport, the caller's state is put back afterwards. The caller may be
+    // drawing into a frame buffer of its own, e.g. when rendering headless. It is saved before anything else is
+    // bound.
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLint framebuffer;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+    FrameBuffer*& target = macroTextures[terrain->getTextureID(0)];
+    if(target == NULL){
+        target = new FrameBuffer(MACRO_TEXTURE_SIZE, MACRO_TEXTURE_SIZE);
+        target->addColourTexture();
+    }
+    glDisable(GL_DEPTH_TEST);
+
+    target->bind();
+    bakeShader.enable();
+    bakeShader.loadTextureUnits();
+    bindTextures(terrain);
+    glBindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    bakeShader.disable();
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    target->generateMipmaps();
+
+    if(depthTest) glEnable(GL_DEPTH_TEST);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    return target->getColourTexture();
+}
+
+GLuint TerrainRenderer::getMacroTexture(Terrain* terrain){
+    std::map<GLuint, FrameBuffer*>::iterator it = macroTextures.find(terrain->getTextureID(0));
+    if(it != macroTextures.end()) return it->second->getColourTexture();
+    return bakeMacroTexture(terrain);
+}
+
+void TerrainRenderer::render(Terrain* terrain, const std::vector<Light*>& lights, glm::mat4 view, glm::mat4 proj, bool use_fog,
+        bool use_horizon_culling){
+    PROFILE_SCOPE("terrain");
+    Frustum frustum(proj, view);
+    glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
+
+    tiles.clear();
+    terrain->collectTiles(tiles);
+    // Any missing macro textures are baked before the terrain shader is enabled, baking switches programs.
+    for(size_t i = 0; i < tiles.size(); ++i){
+        getMacroTexture(tiles[i]);
+    }
+
+    shader.enable();
+    shader.loadProjection(proj);
+    shader.loadLights(lights);
+    shader.loadView(view);
+    shader.loadUseFog(use_fog);
+
+    for(size_t i = 0; i < tiles.size(); ++i){
+        renderTile(tiles[i], frustum, eye, use_horizon_culling);
+    }
+
+    shader.disable();
+}
+
+void TerrainRenderer::renderTile(Terrain* terrain, const Frustum& frustum, glm::vec3 eye, bool use_horizon_culling){
+    const std::vector<TerrainChunk>& chunks = terrain->getChunks();
+    RenderStats* stats = RenderStats::getRenderStats();
+    stats->terrainTilesTotal += chunks.size();
+
+    // Chunks are laid out in the index buffer in grid order, so visible neighbours in a row merge into one range.
+    counts.clear();
+    offsets.clear();
+    int lastEnd = -1;
+    long long indexCount = 0;
+    for(size_t i = 0; i < chunks.size(); ++i){
+        glm::vec3 min, max;
+        terrain->getChunkBounds(i, min, max);
+        if(!frustum.intersectsBox(min, max)) continue;
+        if(use_horizon_culling && terrain->isChunkBehindHorizon(i, eye)) continue;
+
+        stats->terrainTilesDrawn++;
+        indexCount += chunks[i].indexCount;
+        if(chunks[i].indexOffset == lastEnd){
+            counts.back() += chunks[i].indexCount;
+        } else {
+            counts.push_back(chunks[i].indexCount);
+            offsets.push_back((const void*)(sizeof(unsigned int) * (size_t)chunks[i].indexOffset));
+        }
+        lastEnd = chunks[i].indexOffset + chunks[i].indexCount;
+    }
+    if(counts.empty()) return;
+
+    shader.loadTerrain(terrain);
+
+    bindTextures(terrain);
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, getMacroTexture(terrain));
 
     glBindVertexArray(terrain->getVaoID());
 
@@ -30,12 +134,11 @@ void TerrainRenderer::render(Terrain* terrain, std::vector<Light*> lights, glm::
     glEnableVertexAttribArray(1);
     glEnableVertexAttribArray(2);
 
-    glDrawElements(GL_TRIANGLES, terrain->getIndexCount(), GL_UNSIGNED_INT, (void*)0);
+    glMultiDrawElements(GL_TRIANGLES, &counts[0], GL_UNSIGNED_INT, &offsets[0], counts.size());
+    stats->addDraw(indexCount);
 
     glDisableVertexAttribArray(0);
     glDisableVertexAttribArray(1);
     glDisableVertexAttribArray(2);
     glBindVertexArray(0);
-
-    shader.disable();
 }
\ No newline at end of file
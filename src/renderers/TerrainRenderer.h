@@ -7,15 +7,20 @@
 #include <GLFW/glfw3.h>
 
 #include "../src/shaders/TerrainShader.h"
+#include "../src/shaders/TerrainBakeShader.h"
 #include "../objects/Light.h"
 #include "../objects/Camera.h"
 #include "../utils/Model.h"
+#include "../utils/Frustum.h"
+#include "../utils/FrameBuffer.h"
+#include "../utils/RenderStats.h"
 
 #include <cstdio>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <map>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
@@ -23,10 +28,33 @@
 class TerrainRenderer {
 private:
     TerrainShader shader;
+    TerrainBakeShader bakeShader;
+    GLuint emptyVao;    // Core profile needs a VAO bound even when the vertex shader makes its own positions
+
+    // Baked macro textures, keyed by the blend map they were made from so streamed tiles share one.
+    std::map<GLuint, FrameBuffer*> macroTextures;
+
+    // Reused between frames to avoid allocating the draw lists every time.
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<Terrain*> tiles;
+
+    void bindTextures(Terrain* terrain);
+    GLuint getMacroTexture(Terrain* terrain);
+    void renderTile(Terrain* terrain, const Frustum& frustum, glm::vec3 eye, bool use_horizon_culling);
 public:
+    static const int MACRO_TEXTURE_SIZE;
+
     TerrainRenderer();
+    virtual ~TerrainRenderer();
+
+    // Renders the blended terrain textures into a single mipmapped texture which distant terrain samples instead.
+    // Done on first use of a blend map, call again after changing the blend map's contents.
+    GLuint bakeMacroTexture(Terrain* terrain);
 
-    void render(Terrain* terrain, std::vector<Light*> lights, glm::mat4 view, glm::mat4 proj, bool use_fog);
+    // Chunks outside the view frustum are skipped, and optionally those hidden behind nearer terrain.
+    void render(Terrain* terrain, const std::vector<Light*>& lights, glm::mat4 view, glm::mat4 proj, bool use_fog,
+            bool use_horizon_culling = false);
 };
 
 #endif //TERRAIN_RENDERER_H
\ No newline at end of file
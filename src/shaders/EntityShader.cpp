@@ -1,5 +1,7 @@
 #include "EntityShader.h"
 
+#include <algorithm>
+
 EntityShader::EntityShader(std::string vertexShader, std::string fragmentShader)
     : ShaderProgram(vertexShader, fragmentShader) {
     bindUniformLocations();
@@ -10,53 +12,47 @@ void EntityShader::bindUniformLocations(){
     glBindAttribLocation(shaderID, 0, "aPos");
     glBindAttribLocation(shaderID, 1, "aNormal");
     glBindAttribLocation(shaderID, 2, "aTexCoords");
+    glBindAttribLocation(shaderID, 3, "aInstanceModel");
 
     location_texMap = glGetUniformLocation(shaderID, "texMap");
     location_cubeMap = glGetUniformLocation(shaderID, "cubeMap");
 
     location_projection = glGetUniformLocation(shaderID, "projection");
     location_model = glGetUniformLocation(shaderID, "model");
+    location_normal_matrix = glGetUniformLocation(shaderID, "normal_matrix");
     location_view = glGetUniformLocation(shaderID, "view");
     location_inv_view = glGetUniformLocation(shaderID, "inv_view");
 
     location_shininess = glGetUniformLocation(shaderID, "shininess");
     location_emission = glGetUniformLocation(shaderID, "emission");
     location_num_lights = glGetUniformLocation(shaderID, "num_lights");
+    bindLightLocations();
     location_mtl_ambient = glGetUniformLocation(shaderID, "mtl_ambient");
     location_mtl_diffuse = glGetUniformLocation(shaderID, "mtl_diffuse");
     location_mtl_specular = glGetUniformLocation(shaderID, "mtl_specular");
 
     location_use_fog = glGetUniformLocation(shaderID, "use_fog");
+    location_use_instancing = glGetUniformLocation(shaderID, "use_instancing");
 }
 
-void EntityShader::loadLights(std::vector<Light*> lights){
-    loadUniformValue(location_num_lights, int(lights.size()));
-    for(size_t i = 0; i < lights.size(); i++){
+void EntityShader::loadLights(const std::vector<Light*>& lights){
+    int count = std::min((int)lights.size(), MAX_LIGHTS);
+    loadUniformValue(location_num_lights, count);
+    for(int i = 0; i < count; i++){
         loadLight(lights[i], i);
     }
 }
 
-void EntityShader::loadLight(Light* light, int i){
-    loadLightUniform("position", i, light->position);
-    loadLightUniform("specular", i, light->specular);
-    loadLightUniform("diffuse", i, light->diffuse);
-    loadLightUniform("ambient", i, light->ambient);
-    loadLightUniform("radius", i, light->radius);
-    loadLightUniform("coneAngle", i, light->coneAngle);
-    loadLightUniform("coneDirection", i, light->coneDirection);
-}
-
 void EntityShader::loadView(glm::mat4 view){
     loadUniformValue(location_view, view);
     loadUniformValue(location_inv_view, glm::inverse(view));
 }
 
-void EntityShader::loadEntity(Entity* entity){
+void EntityShader::loadModelMatrix(const glm::mat4& model, const glm::mat3& normalMatrix){
     loadUniformValue(location_texMap, 0);
     loadUniformValue(location_cubeMap, 1);
-    glm::mat4 model = entity->getModelMatrix();
-
     loadUniformValue(location_model, model);
+    loadUniformValue(location_normal_matrix, normalMatrix);
 }
 
 void EntityShader::loadModelComponent(const ModelComponent& component){
@@ -73,4 +69,7 @@ void EntityShader::loadProjection(glm::mat4 proj){
 
 void EntityShader::loadUseFog(bool use_fog) {
     loadUniformValue(location_use_fog, use_fog);
-}
\ No newline at end of file
+}
+void EntityShader::loadUseInstancing(bool use_instancing) {
+    loadUniformValue(location_use_instancing, use_instancing);
+}
@@ -33,6 +33,7 @@ private:
 
     GLuint location_projection;
     GLuint location_model;
+    GLuint location_normal_matrix;
     GLuint location_view;
     GLuint location_inv_view;
 
@@ -45,18 +46,19 @@ private:
     GLuint location_mtl_specular;
 
     GLuint location_use_fog;
+    GLuint location_use_instancing;
 public:
     EntityShader(std::string vertexShader, std::string fragmentShader);
 
     virtual void bindUniformLocations();
 
-    void loadLights(std::vector<Light*> lights);
-    void loadLight(Light* light, int i);
+    void loadLights(const std::vector<Light*>& lights);
     void loadView(glm::mat4 view);
-    void loadEntity(Entity* entity);
+    void loadModelMatrix(const glm::mat4& model, const glm::mat3& normalMatrix);
     void loadModelComponent(const ModelComponent& component);
     void loadProjection(glm::mat4 proj);
     void loadUseFog(bool use_fog);
+    void loadUseInstancing(bool use_instancing);
 };
 
 #endif //ENTITYSHADER_H
\ No newline at end of file
@@ -0,0 +1,18 @@
+#include "HudShader.h"
+
+HudShader::HudShader(): ShaderProgram(HUD_VERTEX_SHADER, HUD_FRAGMENT_SHADER) {
+    bindUniformLocations();
+}
+
+void HudShader::bindUniformLocations(){
+    location_screenSize = glGetUniformLocation(shaderID, "screenSize");
+    location_atlas = glGetUniformLocation(shaderID, "atlas");
+}
+
+void HudShader::loadScreenSize(glm::vec2 size){
+    loadUniformValue(location_screenSize, size);
+}
+
+void HudShader::loadAtlasUnit(int unit){
+    loadUniformValue(location_atlas, unit);
+}
@@ -0,0 +1,32 @@
+#ifndef HUDSHADER_H
+#define HUDSHADER_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../utils/ShaderProgram.h"
+
+#include <string>
+
+#include <glm/glm.hpp>
+
+const std::string HUD_VERTEX_SHADER = "../src/shaders/hud.vs";
+const std::string HUD_FRAGMENT_SHADER = "../src/shaders/hud.fs";
+
+class HudShader : public ShaderProgram {
+private:
+    GLuint location_screenSize;
+    GLuint location_atlas;
+public:
+    HudShader();
+
+    virtual void bindUniformLocations();
+
+    // Vertex positions are in pixels from the top left corner of a screen this size.
+    void loadScreenSize(glm::vec2 size);
+    void loadAtlasUnit(int unit);
+};
+
+#endif //HUDSHADER_H
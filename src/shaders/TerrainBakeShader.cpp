@@ -0,0 +1,21 @@
+#include "TerrainBakeShader.h"
+
+TerrainBakeShader::TerrainBakeShader(): ShaderProgram(TERRAIN_BAKE_VERTEX_SHADER, TERRAIN_BAKE_FRAGMENT_SHADER) {
+    bindUniformLocations();
+}
+
+void TerrainBakeShader::bindUniformLocations(){
+    location_blendMap = glGetUniformLocation(shaderID, "blendMap");
+    location_backMap = glGetUniformLocation(shaderID, "backMap");
+    location_rMap = glGetUniformLocation(shaderID, "rMap");
+    location_gMap = glGetUniformLocation(shaderID, "gMap");
+    location_bMap = glGetUniformLocation(shaderID, "bMap");
+}
+
+void TerrainBakeShader::loadTextureUnits(){
+    loadUniformValue(location_blendMap, 0);
+    loadUniformValue(location_backMap, 1);
+    loadUniformValue(location_rMap, 2);
+    loadUniformValue(location_gMap, 3);
+    loadUniformValue(location_bMap, 4);
+}
@@ -0,0 +1,32 @@
+#ifndef TERRAINBAKESHADER_H
+#define TERRAINBAKESHADER_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../utils/ShaderProgram.h"
+
+#include <string>
+
+const std::string TERRAIN_BAKE_VERTEX_SHADER = "../src/shaders/terrain_bake.vs";
+const std::string TERRAIN_BAKE_FRAGMENT_SHADER = "../src/shaders/terrain_bake.fs";
+
+class TerrainBakeShader : public ShaderProgram {
+private:
+    GLuint location_blendMap;
+    GLuint location_backMap;
+    GLuint location_rMap;
+    GLuint location_gMap;
+    GLuint location_bMap;
+public:
+    TerrainBakeShader();
+
+    virtual void bindUniformLocations();
+
+    // Texture units match the ones used by TerrainShader.
+    void loadTextureUnits();
+};
+
+#endif //TERRAINBAKESHADER_H
@@ -1,5 +1,7 @@
 #include "TerrainShader.h"
 
+#include <algorithm>
+
 TerrainShader::TerrainShader(): ShaderProgram(TERRAIN_VERTEX_SHADER, TERRAIN_FRAGMENT_SHADER) {
     bindUniformLocations();
 }
@@ -10,33 +12,26 @@ void TerrainShader::bindUniformLocations(){
     location_rMap = glGetUniformLocation(shaderID, "rMap");
     location_gMap = glGetUniformLocation(shaderID, "gMap");
     location_bMap = glGetUniformLocation(shaderID, "bMap");
+    location_macroMap = glGetUniformLocation(shaderID, "macroMap");
 
     location_projection = glGetUniformLocation(shaderID, "projection");
     location_model = glGetUniformLocation(shaderID, "model");
     location_view = glGetUniformLocation(shaderID, "view");
 
     location_num_lights = glGetUniformLocation(shaderID, "num_lights");
+    bindLightLocations();
 
     location_use_fog = glGetUniformLocation(shaderID, "use_fog");
 }
 
-void TerrainShader::loadLights(std::vector<Light*> lights){
-    loadUniformValue(location_num_lights, int(lights.size()));
-    for(size_t i = 0; i < lights.size(); i++){
+void TerrainShader::loadLights(const std::vector<Light*>& lights){
+    int count = std::min((int)lights.size(), MAX_LIGHTS);
+    loadUniformValue(location_num_lights, count);
+    for(int i = 0; i < count; i++){
         loadLight(lights[i], i);
     }
 }
 
-void TerrainShader::loadLight(Light* light, int i){
-    loadLightUniform("position", i, light->position);
-    loadLightUniform("specular", i, light->specular);
-    loadLightUniform("diffuse", i, light->diffuse);
-    loadLightUniform("ambient", i, light->ambient);
-    loadLightUniform("radius", i, light->radius);
-    loadLightUniform("coneAngle", i, light->coneAngle);
-    loadLightUniform("coneDirection", i, light->coneDirection);
-}
-
 void TerrainShader::loadView(glm::mat4 view){
     loadUniformValue(location_view, view);
 }
@@ -47,6 +42,7 @@ void TerrainShader::loadTerrain(Terrain* terrain){
     loadUniformValue(location_rMap, 2);
     loadUniformValue(location_gMap, 3);
     loadUniformValue(location_bMap, 4);
+    loadUniformValue(location_macroMap, 5);
 
     glm::mat4 model = terrain->getModelMatrix();
     loadUniformValue(location_model, model);
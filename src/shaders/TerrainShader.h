@@ -31,6 +31,7 @@ private:
     GLuint location_rMap;
     GLuint location_gMap;
     GLuint location_bMap;
+    GLuint location_macroMap;
 
     GLuint location_projection;
     GLuint location_model;
@@ -46,8 +47,7 @@ public:
 
     void loadTerrain(Terrain* terrain);
 
-    void loadLights(std::vector<Light*> lights);
-    void loadLight(Light* light, int i);
+    void loadLights(const std::vector<Light*>& lights);
     void loadView(glm::mat4 view);
     void loadProjection(glm::mat4 proj);
     void loadUseFog(bool use_fog);
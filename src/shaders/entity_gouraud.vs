@@ -6,8 +6,11 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aInstanceModel;   // per instance model matrix, takes locations 3 to 6
 
 uniform mat4 model;
+uniform mat3 normal_matrix;   // inverse transpose of the model matrix, computed once per entity on the CPU
+uniform bool use_instancing;  // take the model matrix from aInstanceModel instead of the uniforms
 uniform mat4 view;
 uniform mat4 inv_view;
 uniform mat4 projection;
@@ -82,8 +85,11 @@ vec3 ApplyLight(Light light, vec3 normal, vec4 vertex_world, vec4 vertex_view) {
 }
 
 void main(void) {
-    vec4 pos = model * vec4(aPos, 1.0);
-    vec3 normal = normalize(mat3(model) * aNormal);     // not using inverse-transpose but still seems to work
+    // Instances are only rotated and uniformly scaled, so their own upper 3x3 does for the normals.
+    mat4 model_matrix = use_instancing ? aInstanceModel : model;
+    mat3 normal_mat = use_instancing ? mat3(aInstanceModel) : normal_matrix;
+    vec4 pos = model_matrix * vec4(aPos, 1.0);
+    vec3 normal = normalize(normal_mat * aNormal);
     texCoords = vec2(aTexCoords.x, 1.0 - aTexCoords.y);
     gl_Position = projection * view * pos;
 
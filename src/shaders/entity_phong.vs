@@ -6,18 +6,24 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aInstanceModel;   // per instance model matrix, takes locations 3 to 6
 
 out vec4 pos; // vertex position in world space
 out vec3 normal; // the world space normal
 out vec2 texCoords;
 
 uniform mat4 model;
+uniform mat3 normal_matrix;   // inverse transpose of the model matrix, computed once per entity on the CPU
+uniform bool use_instancing;  // take the model matrix from aInstanceModel instead of the uniforms
 uniform mat4 view;
 uniform mat4 projection;
 
 void main() {
-    pos = model * vec4(aPos, 1.0);
-    normal = normalize(mat3(model) * aNormal);     // not using inverse-transpose but still seems to work
+    // Instances are only rotated and uniformly scaled, so their own upper 3x3 does for the normals.
+    mat4 model_matrix = use_instancing ? aInstanceModel : model;
+    mat3 normal_mat = use_instancing ? mat3(aInstanceModel) : normal_matrix;
+    pos = model_matrix * vec4(aPos, 1.0);
+    normal = normalize(normal_mat * aNormal);
     texCoords = vec2(aTexCoords.x, 1.0 - aTexCoords.y);
     gl_Position = projection * view * pos;
 }
\ No newline at end of file
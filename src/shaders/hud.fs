@@ -0,0 +1,13 @@
+#version 450 core
+out vec4 fragColor;
+
+in vec2 texCoord;
+in vec4 colour;
+
+// Glyph coverage in the red channel
+uniform sampler2D atlas;
+
+void main()
+{
+    fragColor = vec4(colour.rgb, colour.a * texture(atlas, texCoord).r);
+}
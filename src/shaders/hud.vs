@@ -0,0 +1,18 @@
+#version 450 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec4 aColour;
+
+out vec2 texCoord;
+out vec4 colour;
+
+uniform vec2 screenSize;
+
+void main()
+{
+    texCoord = aTexCoord;
+    colour = aColour;
+    // Pixels from the top left corner to clip space
+    vec2 ndc = aPos / screenSize * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+}
@@ -17,6 +17,7 @@ uniform sampler2D backMap;
 uniform sampler2D rMap;
 uniform sampler2D gMap;
 uniform sampler2D bMap;
+uniform sampler2D macroMap;     // The blend below baked into one texture, see TerrainRenderer::bakeMacroTexture
 
 uniform mat4 projection;
 uniform mat4 view;
@@ -38,6 +39,10 @@ uniform float shininess = 32;
 uniform float fog_density = 0.02;
 uniform bool use_fog;
 
+// Between these camera distances the splatted textures fade into the single macro texture sample.
+uniform float macro_start = 60.0;
+uniform float macro_end = 90.0;
+
 // Returns a random number based on a vec3 and an int.
 float random(vec3 seed, int i){
     vec4 seed4 = vec4(seed,i);
@@ -88,16 +93,26 @@ vec3 applyFog(vec3 rgb, float cam_point_dist) {
 }
 
 void main(void) {
-    vec4 blendColour = texture(blendMap, st);
-    float backgroundAmount = 1.0 - (blendColour.r + blendColour.g + blendColour.b);
-    vec2 st_tiled = st * 64.0f;
-    vec4 backComponent = texture(backMap, st_tiled) * backgroundAmount;
-    vec4 rComponent = texture(rMap, st_tiled) * blendColour.r;
-    vec4 gComponent = texture(gMap, st_tiled) * blendColour.g;
-    vec4 bComponent = texture(bMap, st_tiled) * blendColour.b;
-
-    vec4 mixedColour = backComponent + rComponent + gComponent + bComponent;
     vec4 cameraSpaceVert = view * vertex;
+    float macroAmount = smoothstep(macro_start, macro_end, -cameraSpaceVert.z);
+
+    // Derivatives are taken before branching, texture lookups inside the branch would not have valid ones.
+    vec2 st_tiled = st * 64.0f;
+    vec2 st_dx = dFdx(st_tiled);
+    vec2 st_dy = dFdy(st_tiled);
+
+    vec4 mixedColour = texture(macroMap, st);
+    if(macroAmount < 1.0) {
+        vec4 blendColour = textureGrad(blendMap, st, dFdx(st), dFdy(st));
+        float backgroundAmount = 1.0 - (blendColour.r + blendColour.g + blendColour.b);
+        vec4 backComponent = textureGrad(backMap, st_tiled, st_dx, st_dy) * backgroundAmount;
+        vec4 rComponent = textureGrad(rMap, st_tiled, st_dx, st_dy) * blendColour.r;
+        vec4 gComponent = textureGrad(gMap, st_tiled, st_dx, st_dy) * blendColour.g;
+        vec4 bComponent = textureGrad(bMap, st_tiled, st_dx, st_dy) * blendColour.b;
+
+        vec4 splatColour = backComponent + rComponent + gComponent + bComponent;
+        mixedColour = mix(splatColour, mixedColour, macroAmount);
+    }
 
     vec3 lit_colour = vec3(0);
     for(int i = 0; i < num_lights; ++i){
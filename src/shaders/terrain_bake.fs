@@ -0,0 +1,26 @@
+// Blends the terrain textures exactly like terrain.fs, without lighting,
+// into the macro texture used for distant terrain.
+
+#version 450 core
+
+in vec2 st;
+
+layout(location = 0) out vec4 fragColour;
+
+uniform sampler2D blendMap;
+uniform sampler2D backMap;
+uniform sampler2D rMap;
+uniform sampler2D gMap;
+uniform sampler2D bMap;
+
+void main(void) {
+    vec4 blendColour = texture(blendMap, st);
+    float backgroundAmount = 1.0 - (blendColour.r + blendColour.g + blendColour.b);
+    vec2 st_tiled = st * 64.0f;
+    vec4 backComponent = texture(backMap, st_tiled) * backgroundAmount;
+    vec4 rComponent = texture(rMap, st_tiled) * blendColour.r;
+    vec4 gComponent = texture(gMap, st_tiled) * blendColour.g;
+    vec4 bComponent = texture(bMap, st_tiled) * blendColour.b;
+
+    fragColour = backComponent + rComponent + gComponent + bComponent;
+}
@@ -0,0 +1,12 @@
+// Full screen triangle for baking the terrain macro texture.
+// No vertex buffers needed, positions come from the vertex index.
+
+#version 450 core
+
+out vec2 st;
+
+void main(void) {
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    st = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,11 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+// Counts calls to the global operator new, which AllocationCounter.cpp replaces. Used to check that frames
+// in the steady state allocate nothing. Allocations made with malloc directly, e.g. by the GL driver, are not seen.
+class AllocationCounter {
+public:
+    static unsigned long long getAllocationCount();
+};
+
+#endif //ALLOCATION_COUNTER_H
@@ -0,0 +1,39 @@
+#include "Arena.h"
+
+#include <algorithm>
+
+const size_t Arena::DEFAULT_BLOCK_SIZE = 1 << 20;
+
+Arena::Arena(size_t blockSize)
+        : blockSize(blockSize),
+          lastBlockSize(0),
+          used(0),
+          bytesAllocated(0) {
+}
+
+Arena::~Arena(){
+    for(size_t i = 0; i < blocks.size(); i++){
+        delete[] blocks[i];
+    }
+}
+
+void* Arena::allocate(size_t size, size_t alignment){
+    size_t offset = (used + alignment - 1) & ~(alignment - 1);
+    if(blocks.empty() || offset + size > lastBlockSize){
+        // Oversized requests get a block of their own. new[] memory is aligned for any fundamental type.
+        lastBlockSize = std::max(blockSize, size);
+        blocks.push_back(new char[lastBlockSize]);
+        offset = 0;
+    }
+    used = offset + size;
+    bytesAllocated += size;
+    return blocks.back() + offset;
+}
+
+size_t Arena::getBytesAllocated() const {
+    return bytesAllocated;
+}
+
+size_t Arena::getBlockCount() const {
+    return blocks.size();
+}
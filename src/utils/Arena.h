@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+#include <new>
+#include <utility>
+
+/*
+    Bump allocator for things created together at scene load and released together at exit.
+
+    Memory comes from large blocks, so creating many objects costs a handful of heap allocations. Objects created
+    in the arena are never destroyed individually and their destructors are not run, only the blocks are freed.
+*/
+class Arena {
+private:
+    std::vector<char*> blocks;
+    size_t blockSize;
+    size_t lastBlockSize;
+    size_t used;        // Bytes used in the last block
+    size_t bytesAllocated;
+
+public:
+    static const size_t DEFAULT_BLOCK_SIZE;
+
+    Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~Arena();
+
+    void* allocate(size_t size, size_t alignment);
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args);
+
+    size_t getBytesAllocated() const;
+    size_t getBlockCount() const;
+
+private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+};
+
+template <typename T, typename... Args>
+T* Arena::create(Args&&... args){
+    void* memory = allocate(sizeof(T), alignof(T));
+    return new (memory) T(std::forward<Args>(args)...);
+}
+
+#endif //ARENA_H
@@ -0,0 +1,139 @@
+#include "BenchmarkReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static const char* SECTION_NAMES[BenchmarkReport::SECTION_COUNT] = {"simulation", "scene", "render", "present"};
+
+BenchmarkReport::BenchmarkReport(size_t warmUpFrames): warmUpFrames(warmUpFrames), framesSeen(0), drawCalls(0.0),
+        triangles(0.0), allocations(0.0), terrainTilesDrawn(0.0), glCallsCounted(false), glDraws(0.0),
+        glStateChanges(0.0), glTextureBinds(0.0), glUniformCalls(0.0), glBufferUploads(0.0), glBufferUploadBytes(0.0),
+        glRedundantBinds(0.0), gpuPassCount(0) {
+    for(int i = 0; i < SECTION_COUNT; i++){
+        sectionTimes[i] = 0.0;
+        pendingSections[i] = 0.0;
+    }
+}
+
+void BenchmarkReport::reserve(size_t frames){
+    frameTimes.reserve(frames);
+}
+
+void BenchmarkReport::addSectionTime(Section section, double seconds){
+    pendingSections[section] += seconds;
+}
+
+void BenchmarkReport::addGpuTime(const char* pass, double seconds){
+    if(framesSeen < warmUpFrames) return;
+    int index = 0;
+    while(index < gpuPassCount && strcmp(gpuPassNames[index], pass) != 0) index++;
+    if(index == gpuPassCount){
+        if(gpuPassCount == MAX_GPU_PASSES) return;
+        gpuPassNames[index] = pass;
+        gpuPassTimes[index] = 0.0;
+        gpuPassResults[index] = 0;
+        gpuPassCount++;
+    }
+    gpuPassTimes[index] += seconds;
+    gpuPassResults[index]++;
+}
+
+void BenchmarkReport::endFrame(double frameSeconds, const RenderStats& stats){
+    bool counted = framesSeen++ >= warmUpFrames;
+    for(int i = 0; i < SECTION_COUNT; i++){
+        if(counted) sectionTimes[i] += pendingSections[i];
+        pendingSections[i] = 0.0;
+    }
+    if(!counted) return;
+    frameTimes.push_back(frameSeconds);
+    drawCalls += stats.drawCalls;
+    triangles += stats.triangles;
+    allocations += stats.allocations;
+    terrainTilesDrawn += stats.terrainTilesDrawn;
+    glCallsCounted = stats.glCallsCounted;
+    glDraws += stats.glDraws;
+    glStateChanges += stats.glStateChanges;
+    glTextureBinds += stats.glTextureBinds;
+    glUniformCalls += stats.glUniformCalls;
+    glBufferUploads += stats.glBufferUploads;
+    glBufferUploadBytes += stats.glBufferUploadBytes;
+    glRedundantBinds += stats.glRedundantBinds;
+}
+
+size_t BenchmarkReport::getFrameCount() const {
+    return frameTimes.size();
+}
+
+// Nearest rank percentile of sorted values.
+static double percentile(const std::vector<double>& sorted, double fraction){
+    if(sorted.empty()) return 0.0;
+    size_t rank = (size_t)std::ceil(fraction * sorted.size());
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+void BenchmarkReport::write(std::string filename, unsigned int seed, int trafficCount, int width, int height) const {
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for(size_t i = 0; i < sorted.size(); i++){
+        total += sorted[i];
+    }
+    double frames = std::max((double)sorted.size(), 1.0);
+
+    FILE* file = fopen(filename.c_str(), "w");
+    if(file == NULL){
+        std::cerr << "[BenchmarkReport] Failed to open " << filename << " for writing" << std::endl;
+        exit(1);
+    }
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frames\": %zu,\n", sorted.size());
+    fprintf(file, "  \"warm_up_frames\": %zu,\n", warmUpFrames);
+    fprintf(file, "  \"seed\": %u,\n", seed);
+    fprintf(file, "  \"traffic\": %d,\n", trafficCount);
+    fprintf(file, "  \"resolution\": [%d, %d],\n", width, height);
+    fprintf(file, "  \"frame_time_ms\": {\n");
+    fprintf(file, "    \"average\": %.4f,\n", total * 1000.0 / frames);
+    fprintf(file, "    \"p50\": %.4f,\n", percentile(sorted, 0.50) * 1000.0);
+    fprintf(file, "    \"p95\": %.4f,\n", percentile(sorted, 0.95) * 1000.0);
+    fprintf(file, "    \"p99\": %.4f,\n", percentile(sorted, 0.99) * 1000.0);
+    fprintf(file, "    \"max\": %.4f\n", sorted.empty() ? 0.0 : sorted.back() * 1000.0);
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"cpu_time_ms\": {\n");
+    for(int i = 0; i < SECTION_COUNT; i++){
+        fprintf(file, "    \"%s\": %.4f%s\n", SECTION_NAMES[i], sectionTimes[i] * 1000.0 / frames,
+                i + 1 < SECTION_COUNT ? "," : "");
+    }
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"gpu_time_ms\": {\n");
+    for(int i = 0; i < gpuPassCount; i++){
+        fprintf(file, "    \"%s\": %.4f%s\n", gpuPassNames[i], gpuPassTimes[i] * 1000.0 / gpuPassResults[i],
+                i + 1 < gpuPassCount ? "," : "");
+    }
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"per_frame\": {\n");
+    fprintf(file, "    \"draw_calls\": %.1f,\n", drawCalls / frames);
+    fprintf(file, "    \"triangles\": %.0f,\n", triangles / frames);
+    fprintf(file, "    \"terrain_tiles_drawn\": %.1f,\n", terrainTilesDrawn / frames);
+    fprintf(file, "    \"allocations\": %.2f\n", allocations / frames);
+    fprintf(file, "  }%s\n", glCallsCounted ? "," : "");
+    if(glCallsCounted){
+        fprintf(file, "  \"gl_calls_per_frame\": {\n");
+        fprintf(file, "    \"draws\": %.1f,\n", glDraws / frames);
+        fprintf(file, "    \"state_changes\": %.1f,\n", glStateChanges / frames);
+        fprintf(file, "    \"texture_binds\": %.1f,\n", glTextureBinds / frames);
+        fprintf(file, "    \"uniforms\": %.1f,\n", glUniformCalls / frames);
+        fprintf(file, "    \"buffer_uploads\": %.1f,\n", glBufferUploads / frames);
+        fprintf(file, "    \"buffer_upload_bytes\": %.0f,\n", glBufferUploadBytes / frames);
+        fprintf(file, "    \"redundant_binds\": %.1f\n", glRedundantBinds / frames);
+        fprintf(file, "  }\n");
+    }
+    fprintf(file, "}\n");
+    if(fclose(file) != 0){
+        std::cerr << "[BenchmarkReport] Failed to write " << filename << std::endl;
+        exit(1);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef BENCHMARK_REPORT_H
+#define BENCHMARK_REPORT_H
+
+#include "RenderStats.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+    Frame times and per frame counters of a benchmark run, written out as JSON at the end.
+
+    Each frame the main loop adds the CPU time of its sections, then ends the frame with the whole frame time and
+    that frame's RenderStats. The first warmUpFrames frames are not counted. They cover shader compilation,
+    first texture uploads and caches filling.
+
+    GPU pass times arrive a few frames late and some may be missing, so they are averaged over the results given
+    rather than over the frames. GL call counts are only written when the frames had them, see GLCallCounter.
+*/
+class BenchmarkReport {
+public:
+    enum Section {
+        SIMULATION,     // Fixed steps, collisions and interpolation
+        SCENE,          // Cameras, terrain deformation and streaming, scene graph
+        RENDER,         // Culling and submitting draws
+        PRESENT,        // Flush, buffer swap and event polling, includes waiting for the GPU
+        SECTION_COUNT
+    };
+
+    static const int MAX_GPU_PASSES = 8;
+
+private:
+    size_t warmUpFrames;
+    size_t framesSeen;
+    std::vector<double> frameTimes;
+    double sectionTimes[SECTION_COUNT];
+    double pendingSections[SECTION_COUNT];
+    double drawCalls;
+    double triangles;
+    double allocations;
+    double terrainTilesDrawn;
+    bool glCallsCounted;
+    double glDraws;
+    double glStateChanges;
+    double glTextureBinds;
+    double glUniformCalls;
+    double glBufferUploads;
+    double glBufferUploadBytes;
+    double glRedundantBinds;
+    const char* gpuPassNames[MAX_GPU_PASSES];
+    double gpuPassTimes[MAX_GPU_PASSES];
+    int gpuPassResults[MAX_GPU_PASSES];
+    int gpuPassCount;
+
+public:
+    explicit BenchmarkReport(size_t warmUpFrames);
+
+    void reserve(size_t frames);
+    void addSectionTime(Section section, double seconds);
+    // pass should be a string literal, passes past MAX_GPU_PASSES are ignored
+    void addGpuTime(const char* pass, double seconds);
+    void endFrame(double frameSeconds, const RenderStats& stats);
+    size_t getFrameCount() const;
+
+    // Values written alongside the results, describing the run. Exits if the file cannot be written.
+    void write(std::string filename, unsigned int seed, int trafficCount, int width, int height) const;
+};
+
+#endif //BENCHMARK_REPORT_H
@@ -0,0 +1,90 @@
+#include "CatmullRomSpline.h"
+
+#include <algorithm>
+#include <cmath>
+
+CatmullRomSpline::CatmullRomSpline(): length(0.0f) {
+}
+
+CatmullRomSpline::CatmullRomSpline(const std::vector<glm::vec2>& controlPoints, int samplesPerSegment): length(0.0f) {
+    size_t count = controlPoints.size();
+    if(count < 2) return;
+
+    for(size_t i = 0; i < count; i++){
+        const glm::vec2& p0 = controlPoints[(i + count - 1) % count];
+        const glm::vec2& p1 = controlPoints[i];
+        const glm::vec2& p2 = controlPoints[(i + 1) % count];
+        const glm::vec2& p3 = controlPoints[(i + 2) % count];
+        for(int s = 0; s < samplesPerSegment; s++){
+            float t = (float)s / samplesPerSegment;
+            float t2 = t * t;
+            float t3 = t2 * t;
+            samples.push_back(0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+                                      + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3));
+        }
+    }
+    samples.push_back(samples[0]);
+
+    distances.push_back(0.0f);
+    for(size_t i = 1; i < samples.size(); i++){
+        distances.push_back(distances.back() + glm::length(samples[i] - samples[i - 1]));
+    }
+    length = distances.back();
+}
+
+float CatmullRomSpline::getLength() const {
+    return length;
+}
+
+float CatmullRomSpline::wrap(float distance) const {
+    if(length <= 0.0f) return 0.0f;
+    distance = std::fmod(distance, length);
+    return distance < 0.0f ? distance + length : distance;
+}
+
+// Index of the sample starting the polyline segment that holds the distance.
+size_t CatmullRomSpline::findSegment(float distance) const {
+    size_t upper = std::upper_bound(distances.begin(), distances.end(), distance) - distances.begin();
+    return std::min(std::max(upper, (size_t)1), distances.size() - 1) - 1;
+}
+
+glm::vec2 CatmullRomSpline::getPoint(float distance) const {
+    if(samples.empty()) return glm::vec2(0.0f);
+    distance = wrap(distance);
+    size_t i = findSegment(distance);
+    float segment = distances[i + 1] - distances[i];
+    float t = segment > 0.0f ? (distance - distances[i]) / segment : 0.0f;
+    return glm::mix(samples[i], samples[i + 1], t);
+}
+
+glm::vec2 CatmullRomSpline::getDirection(float distance) const {
+    if(samples.empty()) return glm::vec2(0.0f, 1.0f);
+    size_t i = findSegment(wrap(distance));
+    glm::vec2 direction = samples[i + 1] - samples[i];
+    float segment = glm::length(direction);
+    return segment > 0.0f ? direction / segment : glm::vec2(0.0f, 1.0f);
+}
+
+float CatmullRomSpline::findClosest(glm::vec2 point, float near, float window) const {
+    if(samples.empty()) return 0.0f;
+    // Walk the samples within the window, then refine on the best segment.
+    float spacing = length / (samples.size() - 1);
+    int steps = std::max(1, (int)std::ceil(window / spacing));
+    float best = wrap(near);
+    float bestDistance2 = INFINITY;
+    for(int s = -steps; s <= steps; s++){
+        float distance = wrap(near + s * spacing);
+        size_t i = findSegment(distance);
+        glm::vec2 a = samples[i];
+        glm::vec2 ab = samples[i + 1] - a;
+        float ab2 = glm::dot(ab, ab);
+        float t = ab2 > 0.0f ? glm::clamp(glm::dot(point - a, ab) / ab2, 0.0f, 1.0f) : 0.0f;
+        glm::vec2 offset = point - (a + ab * t);
+        float distance2 = glm::dot(offset, offset);
+        if(distance2 < bestDistance2){
+            bestDistance2 = distance2;
+            best = distances[i] + (distances[i + 1] - distances[i]) * t;
+        }
+    }
+    return wrap(best);
+}
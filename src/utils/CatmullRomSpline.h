@@ -0,0 +1,35 @@
+#ifndef CATMULL_ROM_SPLINE_H
+#define CATMULL_ROM_SPLINE_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/*
+    Closed Catmull-Rom curve on the ground plane through a loop of control points.
+
+    The curve is sampled into a dense polyline once, so points are looked up by distance along it, which is
+    what something driving along the curve needs.
+*/
+class CatmullRomSpline {
+private:
+    std::vector<glm::vec2> samples;
+    std::vector<float> distances;   // Distance along the curve at each sample, the last sample closes the loop
+    float length;
+
+    size_t findSegment(float distance) const;
+
+public:
+    CatmullRomSpline();
+    CatmullRomSpline(const std::vector<glm::vec2>& controlPoints, int samplesPerSegment = 32);
+
+    float getLength() const;
+    // Wraps distances outside [0, length).
+    float wrap(float distance) const;
+    glm::vec2 getPoint(float distance) const;
+    glm::vec2 getDirection(float distance) const;   // Unit tangent
+    // Distance of the curve point closest to point, searching no further than window either side of near.
+    float findClosest(glm::vec2 point, float near, float window) const;
+};
+
+#endif //CATMULL_ROM_SPLINE_H
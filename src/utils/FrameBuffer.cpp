@@ -1,20 +1,50 @@
 #include "FrameBuffer.h"
 
+#include "RenderStats.h"
+
 FrameBuffer::FrameBuffer(int width, int height)
         : depthTexture(-1),
           depthBuffer(-1),
           colourTexture(-1),
           width(width),
-          height(height) {
+          height(height),
+          hasMipmaps(false) {
     glGenFramebuffers(1, &framebufferID);
 }
 
+FrameBuffer::~FrameBuffer(){
+    RenderStats* stats = RenderStats::getRenderStats();
+    if(colourTexture != (GLuint)-1){
+        glDeleteTextures(1, &colourTexture);
+        stats->addTextureMemory(-4LL * width * height - (hasMipmaps ? 4LL * width * height / 3 : 0));
+    }
+    if(depthTexture != (GLuint)-1){
+        glDeleteTextures(1, &depthTexture);
+        stats->addTextureMemory(-4LL * width * height);
+    }
+    if(depthBuffer != (GLuint)-1){
+        glDeleteRenderbuffers(1, &depthBuffer);
+        stats->addTextureMemory(-4LL * width * height);
+    }
+    glDeleteFramebuffers(1, &framebufferID);
+}
+
+// Binds this frame buffer without clearing it or changing the viewport, returning what was bound before so that
+// setting it up leaves the caller's target bound.
+GLuint FrameBuffer::bindForSetup(){
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebufferID);
+    return previous;
+}
+
 void FrameBuffer::addColourTexture(){
-    bind();
+    GLuint previous = bindForSetup();
     glGenTextures(1, &colourTexture);
 
     glBindTexture(GL_TEXTURE_2D, colourTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    RenderStats::getRenderStats()->addTextureMemory(4LL * width * height);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -25,15 +55,16 @@ void FrameBuffer::addColourTexture(){
     // GLenum DrawBuffers[1] = {GL_COLOR_ATTACHMENT0};
     // glDrawBuffers(1, DrawBuffers); // "1" is the size of DrawBuffers
 
-    unbind();
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
 }
 
 void FrameBuffer::addDepthTexture(){
-    bind();
+    GLuint previous = bindForSetup();
     glGenTextures(1, &depthTexture);
 
     glBindTexture(GL_TEXTURE_2D, depthTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
+    RenderStats::getRenderStats()->addTextureMemory(4LL * width * height);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -42,25 +73,38 @@ void FrameBuffer::addDepthTexture(){
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
 
 
-    unbind();
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
 }
 
 void FrameBuffer::addDepthBuffer(){
-    bind();
+    GLuint previous = bindForSetup();
     glGenRenderbuffers(1, &depthBuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
+    RenderStats::getRenderStats()->addTextureMemory(4LL * width * height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
-    unbind();
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+}
+
+void FrameBuffer::generateMipmaps(){
+    glBindTexture(GL_TEXTURE_2D, colourTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    // Regenerating them takes no more memory
+    if(!hasMipmaps){
+        RenderStats::getRenderStats()->addTextureMemory(4LL * width * height / 3);
+        hasMipmaps = true;
+    }
 }
 
 bool FrameBuffer::isOkay(){
-    bind();
+    GLuint previous = bindForSetup();
     bool result = true;
     if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         result = false;
     }
-    unbind();
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
     return result;
 }
 
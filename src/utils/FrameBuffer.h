@@ -28,11 +28,22 @@ private:
 
     GLuint width;
     GLuint height;
+    bool hasMipmaps;
+
+    FrameBuffer(const FrameBuffer&);
+    FrameBuffer& operator=(const FrameBuffer&);
+
+    GLuint bindForSetup();
 public:
     FrameBuffer(int width, int height);
+    // Deletes the frame buffer with the textures and render buffer attached to it.
+    virtual ~FrameBuffer();
+    // Attachments and isOkay() leave the frame buffer that was bound before them bound.
     void addColourTexture();
     void addDepthTexture();
     void addDepthBuffer();
+    // Rebuilds the mip chain of the colour texture from its first level, call after rendering into it.
+    void generateMipmaps();
     bool isOkay();
 
     GLuint getColourTexture();
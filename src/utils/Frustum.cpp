@@ -0,0 +1,49 @@
+#include "Frustum.h"
+
+Frustum::Frustum() {
+    for(int i = 0; i < 6; i++){
+        planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);  // Accepts everything
+    }
+}
+
+// Gribb / Hartmann plane extraction from the combined matrix.
+Frustum::Frustum(const glm::mat4& projection, const glm::mat4& view) {
+    glm::mat4 m = projection * view;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+
+    for(int i = 0; i < 6; i++){
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+bool Frustum::intersectsBox(const glm::vec3& min, const glm::vec3& max) const {
+    for(int i = 0; i < 6; i++){
+        // Corner of the box furthest along the plane normal
+        glm::vec3 positive(planes[i].x > 0.0f ? max.x : min.x,
+                           planes[i].y > 0.0f ? max.y : min.y,
+                           planes[i].z > 0.0f ? max.z : min.z);
+        if(glm::dot(glm::vec3(planes[i]), positive) + planes[i].w < 0.0f){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& centre, float radius) const {
+    for(int i = 0; i < 6; i++){
+        if(glm::dot(glm::vec3(planes[i]), centre) + planes[i].w < -radius){
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,19 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// View frustum as six planes in world space, used to skip geometry the camera cannot see.
+class Frustum {
+private:
+    glm::vec4 planes[6];    // xyz - inward normal, w - distance. Order: left, right, bottom, top, near, far
+public:
+    Frustum();
+    Frustum(const glm::mat4& projection, const glm::mat4& view);
+
+    // Conservative tests, may report boxes or spheres just outside a corner as visible.
+    bool intersectsBox(const glm::vec3& min, const glm::vec3& max) const;
+    bool intersectsSphere(const glm::vec3& centre, float radius) const;
+};
+
+#endif //FRUSTUM_H
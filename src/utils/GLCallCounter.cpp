@@ -0,0 +1,388 @@
+#include "GLCallCounter.h"
+
+#include "RenderStats.h"
+
+// Bindings not known since install() or since an object of their kind was deleted
+static const GLuint UNKNOWN = 0xFFFFFFFF;
+static const int TRACKED_UNITS = 32;
+
+struct Bindings {
+    GLuint program;
+    GLuint vertexArray;
+    GLuint framebuffer;
+    GLuint arrayBuffer;
+    GLuint activeUnit;
+    GLuint textures[TRACKED_UNITS];     // GL_TEXTURE_2D
+    GLuint cubeMaps[TRACKED_UNITS];
+};
+
+static Bindings bound;
+static RenderStats* stats = NULL;
+
+// The counts when pause() was called, put back by resume()
+struct Counts {
+    int draws;
+    int stateChanges;
+    int textureBinds;
+    int uniformCalls;
+    int bufferUploads;
+    long long bufferUploadBytes;
+    int redundantBinds;
+};
+
+static Counts pausedCounts;
+static bool paused = false;
+
+static void forgetTextures(){
+    for(int i = 0; i < TRACKED_UNITS; i++){
+        bound.textures[i] = UNKNOWN;
+        bound.cubeMaps[i] = UNKNOWN;
+    }
+}
+
+static void forgetAll(){
+    bound.program = UNKNOWN;
+    bound.vertexArray = UNKNOWN;
+    bound.framebuffer = UNKNOWN;
+    bound.arrayBuffer = UNKNOWN;
+    bound.activeUnit = UNKNOWN;
+    forgetTextures();
+}
+
+// Records a bind of object to what was tracked, counting it as redundant if it was already bound.
+static void trackBind(GLuint& tracked, GLuint object){
+    if(tracked == object) stats->glRedundantBinds++;
+    tracked = object;
+}
+
+static PFNGLDRAWARRAYSPROC realDrawArrays;
+static PFNGLDRAWARRAYSINSTANCEDPROC realDrawArraysInstanced;
+static PFNGLDRAWELEMENTSPROC realDrawElements;
+static PFNGLDRAWELEMENTSINSTANCEDPROC realDrawElementsInstanced;
+static PFNGLMULTIDRAWELEMENTSPROC realMultiDrawElements;
+
+static PFNGLENABLEPROC realEnable;
+static PFNGLDISABLEPROC realDisable;
+static PFNGLBLENDFUNCPROC realBlendFunc;
+static PFNGLVIEWPORTPROC realViewport;
+static PFNGLUSEPROGRAMPROC realUseProgram;
+static PFNGLBINDVERTEXARRAYPROC realBindVertexArray;
+static PFNGLBINDBUFFERPROC realBindBuffer;
+static PFNGLBINDFRAMEBUFFERPROC realBindFramebuffer;
+static PFNGLACTIVETEXTUREPROC realActiveTexture;
+static PFNGLENABLEVERTEXATTRIBARRAYPROC realEnableVertexAttribArray;
+static PFNGLDISABLEVERTEXATTRIBARRAYPROC realDisableVertexAttribArray;
+static PFNGLVERTEXATTRIBPOINTERPROC realVertexAttribPointer;
+static PFNGLVERTEXATTRIBDIVISORPROC realVertexAttribDivisor;
+static PFNGLTEXPARAMETERIPROC realTexParameteri;
+static PFNGLTEXPARAMETERFPROC realTexParameterf;
+
+static PFNGLBINDTEXTUREPROC realBindTexture;
+
+static PFNGLUNIFORM1IPROC realUniform1i;
+static PFNGLUNIFORM1FPROC realUniform1f;
+static PFNGLUNIFORM2FVPROC realUniform2fv;
+static PFNGLUNIFORM3FVPROC realUniform3fv;
+static PFNGLUNIFORM4FVPROC realUniform4fv;
+static PFNGLUNIFORMMATRIX2FVPROC realUniformMatrix2fv;
+static PFNGLUNIFORMMATRIX3FVPROC realUniformMatrix3fv;
+static PFNGLUNIFORMMATRIX4FVPROC realUniformMatrix4fv;
+
+static PFNGLBUFFERDATAPROC realBufferData;
+static PFNGLBUFFERSUBDATAPROC realBufferSubData;
+
+static PFNGLDELETEPROGRAMPROC realDeleteProgram;
+static PFNGLDELETEVERTEXARRAYSPROC realDeleteVertexArrays;
+static PFNGLDELETEBUFFERSPROC realDeleteBuffers;
+static PFNGLDELETEFRAMEBUFFERSPROC realDeleteFramebuffers;
+static PFNGLDELETETEXTURESPROC realDeleteTextures;
+
+// Draws
+
+static void APIENTRY countDrawArrays(GLenum mode, GLint first, GLsizei count){
+    stats->glDraws++;
+    realDrawArrays(mode, first, count);
+}
+
+static void APIENTRY countDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances){
+    stats->glDraws++;
+    realDrawArraysInstanced(mode, first, count, instances);
+}
+
+static void APIENTRY countDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices){
+    stats->glDraws++;
+    realDrawElements(mode, count, type, indices);
+}
+
+static void APIENTRY countDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices,
+        GLsizei instances){
+    stats->glDraws++;
+    realDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+static void APIENTRY countMultiDrawElements(GLenum mode, const GLsizei* count, GLenum type,
+        const void* const* indices, GLsizei drawCount){
+    stats->glDraws++;
+    realMultiDrawElements(mode, count, type, indices, drawCount);
+}
+
+// State changes
+
+static void APIENTRY countEnable(GLenum capability){
+    stats->glStateChanges++;
+    realEnable(capability);
+}
+
+static void APIENTRY countDisable(GLenum capability){
+    stats->glStateChanges++;
+    realDisable(capability);
+}
+
+static void APIENTRY countBlendFunc(GLenum source, GLenum destination){
+    stats->glStateChanges++;
+    realBlendFunc(source, destination);
+}
+
+static void APIENTRY countViewport(GLint x, GLint y, GLsizei width, GLsizei height){
+    stats->glStateChanges++;
+    realViewport(x, y, width, height);
+}
+
+static void APIENTRY countUseProgram(GLuint program){
+    stats->glStateChanges++;
+    trackBind(bound.program, program);
+    realUseProgram(program);
+}
+
+static void APIENTRY countBindVertexArray(GLuint vertexArray){
+    stats->glStateChanges++;
+    trackBind(bound.vertexArray, vertexArray);
+    realBindVertexArray(vertexArray);
+}
+
+static void APIENTRY countBindBuffer(GLenum target, GLuint buffer){
+    stats->glStateChanges++;
+    // The element array buffer binding belongs to the bound vertex array, only the array buffer is tracked
+    if(target == GL_ARRAY_BUFFER) trackBind(bound.arrayBuffer, buffer);
+    realBindBuffer(target, buffer);
+}
+
+static void APIENTRY countBindFramebuffer(GLenum target, GLuint framebuffer){
+    stats->glStateChanges++;
+    // Binding only the draw or read side leaves the two different, GL_FRAMEBUFFER is not known until both are set
+    if(target == GL_FRAMEBUFFER) trackBind(bound.framebuffer, framebuffer);
+    else bound.framebuffer = UNKNOWN;
+    realBindFramebuffer(target, framebuffer);
+}
+
+static void APIENTRY countActiveTexture(GLenum unit){
+    stats->glStateChanges++;
+    trackBind(bound.activeUnit, unit - GL_TEXTURE0);
+    realActiveTexture(unit);
+}
+
+static void APIENTRY countEnableVertexAttribArray(GLuint index){
+    stats->glStateChanges++;
+    realEnableVertexAttribArray(index);
+}
+
+static void APIENTRY countDisableVertexAttribArray(GLuint index){
+    stats->glStateChanges++;
+    realDisableVertexAttribArray(index);
+}
+
+static void APIENTRY countVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+        GLsizei stride, const void* pointer){
+    stats->glStateChanges++;
+    realVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+static void APIENTRY countVertexAttribDivisor(GLuint index, GLuint divisor){
+    stats->glStateChanges++;
+    realVertexAttribDivisor(index, divisor);
+}
+
+static void APIENTRY countTexParameteri(GLenum target, GLenum name, GLint value){
+    stats->glStateChanges++;
+    realTexParameteri(target, name, value);
+}
+
+static void APIENTRY countTexParameterf(GLenum target, GLenum name, GLfloat value){
+    stats->glStateChanges++;
+    realTexParameterf(target, name, value);
+}
+
+// Texture binds
+
+static void APIENTRY countBindTexture(GLenum target, GLuint texture){
+    stats->glTextureBinds++;
+    GLuint unit = bound.activeUnit;
+    if(unit < (GLuint)TRACKED_UNITS && target == GL_TEXTURE_2D) trackBind(bound.textures[unit], texture);
+    else if(unit < (GLuint)TRACKED_UNITS && target == GL_TEXTURE_CUBE_MAP) trackBind(bound.cubeMaps[unit], texture);
+    realBindTexture(target, texture);
+}
+
+// Uniforms
+
+static void APIENTRY countUniform1i(GLint location, GLint value){
+    stats->glUniformCalls++;
+    realUniform1i(location, value);
+}
+
+static void APIENTRY countUniform1f(GLint location, GLfloat value){
+    stats->glUniformCalls++;
+    realUniform1f(location, value);
+}
+
+static void APIENTRY countUniform2fv(GLint location, GLsizei count, const GLfloat* value){
+    stats->glUniformCalls++;
+    realUniform2fv(location, count, value);
+}
+
+static void APIENTRY countUniform3fv(GLint location, GLsizei count, const GLfloat* value){
+    stats->glUniformCalls++;
+    realUniform3fv(location, count, value);
+}
+
+static void APIENTRY countUniform4fv(GLint location, GLsizei count, const GLfloat* value){
+    stats->glUniformCalls++;
+    realUniform4fv(location, count, value);
+}
+
+static void APIENTRY countUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value){
+    stats->glUniformCalls++;
+    realUniformMatrix2fv(location, count, transpose, value);
+}
+
+static void APIENTRY countUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value){
+    stats->glUniformCalls++;
+    realUniformMatrix3fv(location, count, transpose, value);
+}
+
+static void APIENTRY countUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value){
+    stats->glUniformCalls++;
+    realUniformMatrix4fv(location, count, transpose, value);
+}
+
+// Buffer uploads, allocating without data (e.g. orphaning) uploads nothing
+
+static void APIENTRY countBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage){
+    if(data != NULL){
+        stats->glBufferUploads++;
+        stats->glBufferUploadBytes += size;
+    }
+    realBufferData(target, size, data, usage);
+}
+
+static void APIENTRY countBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data){
+    stats->glBufferUploads++;
+    stats->glBufferUploadBytes += size;
+    realBufferSubData(target, offset, size, data);
+}
+
+// Deleting a bound object binds 0 in its place, names may then be reused
+
+static void APIENTRY countDeleteProgram(GLuint program){
+    bound.program = UNKNOWN;
+    realDeleteProgram(program);
+}
+
+static void APIENTRY countDeleteVertexArrays(GLsizei count, const GLuint* vertexArrays){
+    bound.vertexArray = UNKNOWN;
+    realDeleteVertexArrays(count, vertexArrays);
+}
+
+static void APIENTRY countDeleteBuffers(GLsizei count, const GLuint* buffers){
+    bound.arrayBuffer = UNKNOWN;
+    realDeleteBuffers(count, buffers);
+}
+
+static void APIENTRY countDeleteFramebuffers(GLsizei count, const GLuint* framebuffers){
+    bound.framebuffer = UNKNOWN;
+    realDeleteFramebuffers(count, framebuffers);
+}
+
+static void APIENTRY countDeleteTextures(GLsizei count, const GLuint* textures){
+    forgetTextures();
+    realDeleteTextures(count, textures);
+}
+
+void GLCallCounter::install(){
+    if(isInstalled()) return;
+    stats = RenderStats::getRenderStats();
+    stats->glCallsCounted = true;
+    forgetAll();
+
+// Keeps glad's pointer to the GL function and puts the counting one in its place
+#define GL_CALL_COUNTER_WRAP(name) real##name = glad_gl##name; glad_gl##name = count##name
+    GL_CALL_COUNTER_WRAP(DrawArrays);
+    GL_CALL_COUNTER_WRAP(DrawArraysInstanced);
+    GL_CALL_COUNTER_WRAP(DrawElements);
+    GL_CALL_COUNTER_WRAP(DrawElementsInstanced);
+    GL_CALL_COUNTER_WRAP(MultiDrawElements);
+
+    GL_CALL_COUNTER_WRAP(Enable);
+    GL_CALL_COUNTER_WRAP(Disable);
+    GL_CALL_COUNTER_WRAP(BlendFunc);
+    GL_CALL_COUNTER_WRAP(Viewport);
+    GL_CALL_COUNTER_WRAP(UseProgram);
+    GL_CALL_COUNTER_WRAP(BindVertexArray);
+    GL_CALL_COUNTER_WRAP(BindBuffer);
+    GL_CALL_COUNTER_WRAP(BindFramebuffer);
+    GL_CALL_COUNTER_WRAP(ActiveTexture);
+    GL_CALL_COUNTER_WRAP(EnableVertexAttribArray);
+    GL_CALL_COUNTER_WRAP(DisableVertexAttribArray);
+    GL_CALL_COUNTER_WRAP(VertexAttribPointer);
+    GL_CALL_COUNTER_WRAP(VertexAttribDivisor);
+    GL_CALL_COUNTER_WRAP(TexParameteri);
+    GL_CALL_COUNTER_WRAP(TexParameterf);
+
+    GL_CALL_COUNTER_WRAP(BindTexture);
+
+    GL_CALL_COUNTER_WRAP(Uniform1i);
+    GL_CALL_COUNTER_WRAP(Uniform1f);
+    GL_CALL_COUNTER_WRAP(Uniform2fv);
+    GL_CALL_COUNTER_WRAP(Uniform3fv);
+    GL_CALL_COUNTER_WRAP(Uniform4fv);
+    GL_CALL_COUNTER_WRAP(UniformMatrix2fv);
+    GL_CALL_COUNTER_WRAP(UniformMatrix3fv);
+    GL_CALL_COUNTER_WRAP(UniformMatrix4fv);
+
+    GL_CALL_COUNTER_WRAP(BufferData);
+    GL_CALL_COUNTER_WRAP(BufferSubData);
+
+    GL_CALL_COUNTER_WRAP(DeleteProgram);
+    GL_CALL_COUNTER_WRAP(DeleteVertexArrays);
+    GL_CALL_COUNTER_WRAP(DeleteBuffers);
+    GL_CALL_COUNTER_WRAP(DeleteFramebuffers);
+    GL_CALL_COUNTER_WRAP(DeleteTextures);
+#undef GL_CALL_COUNTER_WRAP
+}
+
+bool GLCallCounter::isInstalled(){
+    return stats != NULL;
+}
+
+void GLCallCounter::pause(){
+    if(!isInstalled() || paused) return;
+    pausedCounts.draws = stats->glDraws;
+    pausedCounts.stateChanges = stats->glStateChanges;
+    pausedCounts.textureBinds = stats->glTextureBinds;
+    pausedCounts.uniformCalls = stats->glUniformCalls;
+    pausedCounts.bufferUploads = stats->glBufferUploads;
+    pausedCounts.bufferUploadBytes = stats->glBufferUploadBytes;
+    pausedCounts.redundantBinds = stats->glRedundantBinds;
+    paused = true;
+}
+
+void GLCallCounter::resume(){
+    if(!paused) return;
+    stats->glDraws = pausedCounts.draws;
+    stats->glStateChanges = pausedCounts.stateChanges;
+    stats->glTextureBinds = pausedCounts.textureBinds;
+    stats->glUniformCalls = pausedCounts.uniformCalls;
+    stats->glBufferUploads = pausedCounts.bufferUploads;
+    stats->glBufferUploadBytes = pausedCounts.bufferUploadBytes;
+    stats->glRedundantBinds = pausedCounts.redundantBinds;
+    paused = false;
+}
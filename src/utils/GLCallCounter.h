@@ -0,0 +1,34 @@
+#ifndef GL_CALL_COUNTER_H
+#define GL_CALL_COUNTER_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+/*
+    Counts the GL calls made each frame into RenderStats: draws, state changes, texture binds, uniform loads and
+    buffer uploads with their size.
+
+    glad calls GL through function pointers, install() swaps the ones counted for wrappers which count the call and
+    pass it on. Binds of the program, vertex array, frame buffer, array buffer or texture that is already bound are
+    counted as redundant. Which objects are bound is tracked from the calls made since install(), so binds right
+    after it are never redundant, and deleting an object forgets what was bound of its kind.
+
+    Calls made between pause() and resume() are not counted, so the overlay showing the counts does not change them.
+    Bindings are still tracked through them.
+
+    Only built into the game with cmake -DGL_CALL_COUNTER=ON (USE_GL_CALL_COUNTER), the wrappers cost a call and a
+    few increments each. GL must only be called from the main thread.
+*/
+class GLCallCounter {
+public:
+    // Should be called once GL is loaded, before anything is drawn.
+    static void install();
+    static bool isInstalled();
+    // Nothing is counted until resume(), does nothing when not installed
+    static void pause();
+    static void resume();
+};
+
+#endif //GL_CALL_COUNTER_H
@@ -1,12 +1,24 @@
 #include "GameTime.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 // Initialise singleton
 GameTime* GameTime::gameTime = NULL;
 
+const double GameTime::FIXED_STEP = 1.0 / 120.0;
+const int GameTime::MAX_STEPS_PER_FRAME = 8;
+const double GameTime::MAX_FRAME_TIME = 0.25;
+
 GameTime::GameTime(){
-    initialTime = glfwGetTime();
-    lastTime = -1;
-    currentTime = -1;
+    initialTime = getClock();
+    // The first frame measures from here, not from time 0.
+    lastTime = initialTime;
+    currentTime = initialTime;
+    accumulator = 0.0;
+    frameDt = 0.0;
+    stepsThisFrame = 0;
 }
 
 GameTime* GameTime::getGameTime(){
@@ -17,15 +29,58 @@ GameTime* GameTime::getGameTime(){
     return gameTime;
 }
 
+double GameTime::getClock(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void GameTime::update(){
+    advance(getClock() - currentTime);
+}
+
+void GameTime::advance(double dt){
+    frameDt = dt;
     lastTime = currentTime;
-    currentTime = glfwGetTime();
+    currentTime += dt;
+    accumulator += std::min(dt, MAX_FRAME_TIME);
+    stepsThisFrame = 0;
+}
+
+bool GameTime::step(){
+    if(accumulator < FIXED_STEP) return false;
+    if(stepsThisFrame == MAX_STEPS_PER_FRAME){
+        // Too far behind to catch up, keep only the part of a step towards the next frame.
+        accumulator = std::fmod(accumulator, FIXED_STEP);
+        return false;
+    }
+    accumulator -= FIXED_STEP;
+    stepsThisFrame++;
+    return true;
 }
 
 float GameTime::getDt(){
-    return (float)(currentTime - lastTime);
+    return (float)FIXED_STEP;
+}
+
+float GameTime::getFrameDt(){
+    return (float)frameDt;
+}
+
+double GameTime::getExactFrameDt(){
+    return frameDt;
+}
+
+double GameTime::getTime(){
+    return currentTime - initialTime;
+}
+
+float GameTime::getAlpha(){
+    return (float)(accumulator / FIXED_STEP);
+}
+
+int GameTime::getStepsThisFrame(){
+    return stepsThisFrame;
 }
 
 float GameTime::getFPS(){
-    return (float)1.0 / getDt();
+    return (float)1.0 / getFrameDt();
 }
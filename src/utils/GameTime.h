@@ -6,6 +6,17 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+/*
+    Frame timing and the fixed simulation step.
+
+    The simulation always advances in steps of FIXED_STEP seconds, however long the frame took. Each frame the
+    elapsed time is added to an accumulator and step() is called in a loop, returning true once per whole step
+    owed. What is left over, as a fraction of a step, is getAlpha() - drawn transforms are interpolated by it
+    between the last two simulated states.
+
+    A frame runs at most MAX_STEPS_PER_FRAME steps. If the simulation falls further behind than that, the rest
+    of the time is dropped and the game slows down, rather than every frame taking longer than the one before.
+*/
 class GameTime {
 private:
     static GameTime* gameTime;
@@ -14,12 +25,29 @@ private:
     double initialTime;
     double lastTime;
     double currentTime;
+    double accumulator;     // Time not yet simulated
+    double frameDt;
+    int stepsThisFrame;
 public:
+    static const double FIXED_STEP;
+    static const int MAX_STEPS_PER_FRAME;
+    static const double MAX_FRAME_TIME;     // Longer frames, e.g. while the window is dragged, count as this long
+
     static GameTime* getGameTime();
+    // Seconds from a steady clock, also available without a window.
+    static double getClock();
 
     void update();  // Should be called once per frame
-    float getDt();
+    void advance(double frameDt);   // Instead of update(), for a frame of a given length, e.g. from a replay
+    bool step();    // Should be called in a loop after update(), runs one simulation step per true
+
+    float getDt();          // Length of a simulation step
+    float getFrameDt();     // Real time since the previous frame
+    double getExactFrameDt();   // The same, as passed to advance()
+    double getTime();       // Time since the game started, the sum of the frame lengths
+    float getAlpha();       // Progress from the previous to the latest simulated state, in [0, 1)
+    int getStepsThisFrame();
     float getFPS();
 };
 
-#endif
\ No newline at end of file
+#endif
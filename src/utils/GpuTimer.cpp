@@ -0,0 +1,95 @@
+#include "GpuTimer.h"
+
+#include "Profiler.h"
+
+static const char* PASS_NAMES[GpuTimer::PASS_COUNT] = {"skybox", "entities", "traffic", "terrain"};
+
+GpuTimer::GpuTimer(): frame(0), droppedFrames(0) {
+    glGenQueries(FRAMES_IN_FLIGHT * PASS_COUNT * 2, &queries[0][0][0]);
+    for(int pass = 0; pass < PASS_COUNT; pass++){
+        for(int slot = 0; slot < FRAMES_IN_FLIGHT; slot++){
+            issued[slot][pass] = false;
+        }
+        passStart[pass] = 0;
+        passTime[pass] = 0;
+        passReady[pass] = false;
+    }
+}
+
+GpuTimer::~GpuTimer(){
+    glDeleteQueries(FRAMES_IN_FLIGHT * PASS_COUNT * 2, &queries[0][0][0]);
+}
+
+const char* GpuTimer::getPassName(Pass pass){
+    return PASS_NAMES[pass];
+}
+
+void GpuTimer::begin(Pass pass){
+    if(issued[frame][pass]) return;
+    glQueryCounter(queries[frame][pass][0], GL_TIMESTAMP);
+}
+
+void GpuTimer::end(Pass pass){
+    if(issued[frame][pass]) return;
+    glQueryCounter(queries[frame][pass][1], GL_TIMESTAMP);
+    issued[frame][pass] = true;
+}
+
+// Reads the slot's results if the GPU has finished all of them, otherwise drops them.
+void GpuTimer::collect(int slot){
+    for(int pass = 0; pass < PASS_COUNT; pass++){
+        passReady[pass] = false;
+    }
+
+    bool available = true;
+    for(int pass = 0; pass < PASS_COUNT && available; pass++){
+        if(!issued[slot][pass]) continue;
+        // The second query finishes last
+        GLint done = 0;
+        glGetQueryObjectiv(queries[slot][pass][1], GL_QUERY_RESULT_AVAILABLE, &done);
+        available = done != 0;
+    }
+    if(!available){
+        droppedFrames++;
+    }
+
+    for(int pass = 0; pass < PASS_COUNT; pass++){
+        if(!issued[slot][pass]) continue;
+        issued[slot][pass] = false;
+        if(!available) continue;
+        GLuint64 start, end;
+        glGetQueryObjectui64v(queries[slot][pass][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(queries[slot][pass][1], GL_QUERY_RESULT, &end);
+        passStart[pass] = start;
+        passTime[pass] = end - start;
+        passReady[pass] = true;
+    }
+}
+
+void GpuTimer::endFrame(){
+    frame = (frame + 1) % FRAMES_IN_FLIGHT;
+    collect(frame);
+
+    // Passes are put on the trace's GPU track at the CPU time their GPU timestamps correspond to
+    if(!Profiler::isCapturing()) return;
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    int64_t offset = (int64_t)Profiler::getTimestamp() - (int64_t)gpuNow;
+    for(int pass = 0; pass < PASS_COUNT; pass++){
+        if(!passReady[pass]) continue;
+        uint64_t start = (uint64_t)((int64_t)passStart[pass] + offset);
+        Profiler::getProfiler()->recordGpu(PASS_NAMES[pass], start, start + passTime[pass]);
+    }
+}
+
+bool GpuTimer::hasResult(Pass pass) const {
+    return passReady[pass];
+}
+
+double GpuTimer::getPassSeconds(Pass pass) const {
+    return passTime[pass] * 1e-9;
+}
+
+int GpuTimer::getDroppedFrames() const {
+    return droppedFrames;
+}
@@ -0,0 +1,66 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <stdint.h>
+
+/*
+    GPU time of each render pass, from timestamp queries written before and after the pass.
+
+    The GPU runs frames behind the CPU, so a frame's queries are only read back FRAMES_IN_FLIGHT frames later, when
+    its slot in the ring comes round again, and only if the results are already there. Results that are still not
+    ready then are dropped instead of waiting for them, so the CPU never stalls on the GPU.
+
+    Each pass is timed once per frame, the first time it is drawn. Needs a GL context from construction on.
+*/
+class GpuTimer {
+public:
+    enum Pass {
+        SKYBOX,
+        ENTITIES,
+        TRAFFIC,
+        TERRAIN,
+        PASS_COUNT
+    };
+
+    static const int FRAMES_IN_FLIGHT = 4;
+
+private:
+    GLuint queries[FRAMES_IN_FLIGHT][PASS_COUNT][2];    // Before and after the pass
+    bool issued[FRAMES_IN_FLIGHT][PASS_COUNT];
+    int frame;      // Slot of the frame being drawn
+
+    // Latest results, in ns on the GPU clock
+    uint64_t passStart[PASS_COUNT];
+    uint64_t passTime[PASS_COUNT];
+    bool passReady[PASS_COUNT];
+    int droppedFrames;
+
+    GpuTimer(const GpuTimer&);
+    GpuTimer& operator=(const GpuTimer&);
+
+    void collect(int slot);
+
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    static const char* getPassName(Pass pass);
+
+    void begin(Pass pass);
+    void end(Pass pass);
+    // Should be called once per frame after the last pass. Reads back the oldest frame in the ring.
+    void endFrame();
+
+    // Whether the last endFrame() read a result for the pass, and what it was.
+    bool hasResult(Pass pass) const;
+    double getPassSeconds(Pass pass) const;
+    // Frames whose results were not ready in time, since the start
+    int getDroppedFrames() const;
+};
+
+#endif //GPU_TIMER_H
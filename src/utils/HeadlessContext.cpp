@@ -0,0 +1,110 @@
+#include "HeadlessContext.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext(): display(NULL), context(NULL), target(NULL) {
+}
+
+HeadlessContext::~HeadlessContext(){
+#ifdef USE_EGL
+    if(display != NULL){
+        // Deleted while the context is still current, which its GL objects need
+        delete target;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if(context != NULL) eglDestroyContext(display, context);
+        eglTerminate(display);
+    }
+#endif
+}
+
+#ifdef USE_EGL
+static EGLDisplay openDisplay(){
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if(extensions != NULL && strstr(extensions, "EGL_MESA_platform_surfaceless") != NULL){
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(getPlatformDisplay != NULL){
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if(display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) return display;
+        }
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if(display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) return display;
+    return EGL_NO_DISPLAY;
+}
+#endif
+
+void HeadlessContext::create(int width, int height){
+#ifdef USE_EGL
+    display = openDisplay();
+    if(display == EGL_NO_DISPLAY){
+        std::cerr << "[HeadlessContext] No EGL display available" << std::endl;
+        exit(1);
+    }
+    if(!eglBindAPI(EGL_OPENGL_API)){
+        std::cerr << "[HeadlessContext] EGL display does not support desktop OpenGL" << std::endl;
+        exit(1);
+    }
+
+    // Nothing is drawn to an EGL surface, any config able to render OpenGL will do. The surface type defaults
+    // to windows, which a surfaceless display has none of.
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, 0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if(!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0){
+        std::cerr << "[HeadlessContext] No EGL config for OpenGL" << std::endl;
+        exit(1);
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if(context == EGL_NO_CONTEXT){
+        std::cerr << "[HeadlessContext] Failed to create an OpenGL 4.5 core context" << std::endl;
+        exit(1);
+    }
+    if(!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+        std::cerr << "[HeadlessContext] Failed to make the context current without a surface" << std::endl;
+        exit(1);
+    }
+    if(!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)){
+        std::cerr << "[HeadlessContext] Failed to initialize GLAD" << std::endl;
+        exit(1);
+    }
+
+    target = new FrameBuffer(width, height);
+    target->addColourTexture();
+    target->addDepthBuffer();
+    if(!target->isOkay()){
+        std::cerr << "[HeadlessContext] Render target is incomplete" << std::endl;
+        exit(1);
+    }
+    std::cout << "[HeadlessContext] Rendering with " << glGetString(GL_RENDERER) << std::endl;
+#else
+    std::cerr << "[HeadlessContext] Built without EGL, headless rendering is not available" << std::endl;
+    exit(1);
+#endif
+}
+
+void HeadlessContext::bind(){
+    target->bind();
+}
+
+FrameBuffer* HeadlessContext::getTarget(){
+    return target;
+}
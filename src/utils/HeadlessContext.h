@@ -0,0 +1,40 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "FrameBuffer.h"
+
+#include <vector>
+
+/*
+    OpenGL 4.5 core context with no window or display, made through EGL, rendering into a FrameBuffer.
+
+    Surfaceless Mesa is tried first, then the default EGL display. On machines without a GPU Mesa's llvmpipe
+    provides the context, LIBGL_ALWAYS_SOFTWARE=1 forces it where there is one. Only available when the game
+    was built with EGL found, create() exits otherwise.
+*/
+class HeadlessContext {
+private:
+    void* display;      // EGLDisplay
+    void* context;      // EGLContext
+    FrameBuffer* target;
+
+    HeadlessContext(const HeadlessContext&);
+    HeadlessContext& operator=(const HeadlessContext&);
+
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    // Makes the context current, loads GL and creates the target. Exits if any of it fails.
+    void create(int width, int height);
+    // Renders go to the target until something else is bound.
+    void bind();
+    FrameBuffer* getTarget();
+};
+
+#endif //HEADLESS_CONTEXT_H
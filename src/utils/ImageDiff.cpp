@@ -0,0 +1,76 @@
+#include "ImageDiff.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Largest possible weighted YIQ distance, between black and white
+static const float MAX_YIQ_DISTANCE = 35215.0f;
+
+float ImageDiff::colourDifference(const unsigned char* a, const unsigned char* b){
+    float dr = (float)a[0] - (float)b[0];
+    float dg = (float)a[1] - (float)b[1];
+    float db = (float)a[2] - (float)b[2];
+    float y = dr * 0.29889531f + dg * 0.58662247f + db * 0.11448223f;
+    float i = dr * 0.59597799f - dg * 0.27417610f - db * 0.32180189f;
+    float q = dr * 0.21147017f - dg * 0.52261711f + db * 0.31114694f;
+    return std::sqrt((0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q) / MAX_YIQ_DISTANCE);
+}
+
+// True if a pixel within one of (x, y) in other is within the threshold of the colour.
+static bool hasCloseNeighbour(int width, int height, int x, int y, const unsigned char* colour,
+                              const std::vector<unsigned char>& other, float threshold){
+    for(int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ny++){
+        for(int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++){
+            if(ImageDiff::colourDifference(colour, &other[((size_t)ny * width + nx) * 3]) <= threshold){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+ImageDiff::Result ImageDiff::compare(int width, int height, const std::vector<unsigned char>& reference,
+                                     const std::vector<unsigned char>& actual, float threshold,
+                                     std::vector<unsigned char>& diff){
+    Result result;
+    result.differingPixels = 0;
+    result.totalPixels = (size_t)width * height;
+    result.maxDifference = 0.0f;
+    diff.resize(result.totalPixels * 3);
+
+    for(int y = 0; y < height; y++){
+        for(int x = 0; x < width; x++){
+            size_t offset = ((size_t)y * width + x) * 3;
+            const unsigned char* expected = &reference[offset];
+            const unsigned char* got = &actual[offset];
+            float difference = colourDifference(expected, got);
+            bool differs = difference > threshold
+                    && !hasCloseNeighbour(width, height, x, y, expected, actual, threshold)
+                    && !hasCloseNeighbour(width, height, x, y, got, reference, threshold);
+            if(differs){
+                result.differingPixels++;
+                result.maxDifference = std::max(result.maxDifference, difference);
+                diff[offset] = 255;
+                diff[offset + 1] = 0;
+                diff[offset + 2] = 0;
+            }
+            else {
+                // Faded so the red stands out
+                float luma = expected[0] * 0.299f + expected[1] * 0.587f + expected[2] * 0.114f;
+                unsigned char grey = (unsigned char)(255.0f - (255.0f - luma) * 0.25f);
+                diff[offset] = grey;
+                diff[offset + 1] = grey;
+                diff[offset + 2] = grey;
+            }
+        }
+    }
+    return result;
+}
+
+bool ImageDiff::isUniform(int width, int height, const std::vector<unsigned char>& rgb, float threshold){
+    size_t pixels = (size_t)width * height;
+    for(size_t i = 1; i < pixels; i++){
+        if(colourDifference(&rgb[0], &rgb[i * 3]) > threshold) return false;
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+#ifndef IMAGE_DIFF_H
+#define IMAGE_DIFF_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+    Compares a rendered image with a reference the way a person would see it, for the golden image test.
+
+    Colours are compared in YIQ space with brightness weighted most, as in pixelmatch, giving a difference from
+    0 (same) to 1 (black against white). A pixel only counts as different when no pixel around it in the other
+    image is within the threshold either, so edges moved by one pixel between GL implementations are let through.
+*/
+class ImageDiff {
+public:
+    struct Result {
+        size_t differingPixels;
+        size_t totalPixels;
+        float maxDifference;    // Of the differing pixels, 0 when there are none
+    };
+
+    // Perceptual difference of two 8 bit RGB colours, in [0, 1].
+    static float colourDifference(const unsigned char* a, const unsigned char* b);
+
+    // Both images 8 bit RGB of the same size. diff is filled with the reference faded to grey and the differing
+    // pixels in red.
+    static Result compare(int width, int height, const std::vector<unsigned char>& reference,
+                          const std::vector<unsigned char>& actual, float threshold,
+                          std::vector<unsigned char>& diff);
+
+    // Whether every pixel is within threshold of the first one, e.g. a blank image read from the wrong frame buffer.
+    // No view of the scene is, so such an image never passes as a reference or a render.
+    static bool isUniform(int width, int height, const std::vector<unsigned char>& rgb, float threshold);
+};
+
+#endif //IMAGE_DIFF_H
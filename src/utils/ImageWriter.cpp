@@ -0,0 +1,107 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdint.h>
+
+void ImageWriter::readPixels(int width, int height, std::vector<unsigned char>& rgb){
+    size_t row = (size_t)width * 3;
+    std::vector<unsigned char> flipped(row * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &flipped[0]);
+    // GL's first row is the bottom one
+    rgb.resize(flipped.size());
+    for(int y = 0; y < height; y++){
+        std::copy(flipped.begin() + (height - 1 - y) * row, flipped.begin() + (height - y) * row,
+                  rgb.begin() + y * row);
+    }
+}
+
+static uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0){
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if(!tableReady){
+        for(uint32_t n = 0; n < 256; n++){
+            uint32_t c = n;
+            for(int k = 0; k < 8; k++){
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        tableReady = true;
+    }
+    crc = ~crc;
+    for(size_t i = 0; i < size; i++){
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void appendBigEndian(std::vector<unsigned char>& out, uint32_t value){
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void appendChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data){
+    appendBigEndian(out, data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendBigEndian(out, crc32(&out[start], out.size() - start));
+}
+
+bool ImageWriter::writePNG(std::string filename, int width, int height, const std::vector<unsigned char>& rgb){
+    // Rows each start with filter type 0, none
+    size_t row = (size_t)width * 3;
+    std::vector<unsigned char> raw;
+    raw.reserve((row + 1) * height);
+    for(int y = 0; y < height; y++){
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + y * row, rgb.begin() + (y + 1) * row);
+    }
+
+    // zlib stream of stored deflate blocks, at most 65535 bytes each
+    std::vector<unsigned char> compressed;
+    compressed.push_back(0x78);
+    compressed.push_back(0x01);
+    const size_t MAX_BLOCK = 65535;
+    size_t offset = 0;
+    do {
+        size_t length = std::min(MAX_BLOCK, raw.size() - offset);
+        compressed.push_back(offset + length == raw.size() ? 1 : 0);
+        compressed.push_back(length & 0xFF);
+        compressed.push_back(length >> 8);
+        compressed.push_back(~length & 0xFF);
+        compressed.push_back((~length >> 8) & 0xFF);
+        compressed.insert(compressed.end(), raw.begin() + offset, raw.begin() + offset + length);
+        offset += length;
+    } while(offset < raw.size());
+    uint32_t a = 1, b = 0;
+    for(size_t i = 0; i < raw.size(); i++){
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(compressed, (b << 16) | a);
+
+    std::vector<unsigned char> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.push_back(8);    // Bits per channel
+    header.push_back(2);    // RGB
+    header.push_back(0);    // Deflate
+    header.push_back(0);    // Adaptive filtering
+    header.push_back(0);    // Not interlaced
+
+    const unsigned char SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<unsigned char> png(SIGNATURE, SIGNATURE + 8);
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", compressed);
+    appendChunk(png, "IEND", std::vector<unsigned char>());
+
+    FILE* file = fopen(filename.c_str(), "wb");
+    if(file == NULL) return false;
+    bool written = fwrite(&png[0], 1, png.size(), file) == png.size();
+    return fclose(file) == 0 && written;
+}
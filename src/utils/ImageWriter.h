@@ -0,0 +1,22 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#define _USE_MATH_DEFINES
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+
+// Saves rendered frames as images, without an image library.
+class ImageWriter {
+public:
+    // Colour of the bound framebuffer as 8 bit RGB, rows from the top down.
+    static void readPixels(int width, int height, std::vector<unsigned char>& rgb);
+    // 8 bit RGB, rows from the top down. The image data is stored uncompressed, so the file is a little larger
+    // than the pixels. False if the file cannot be written.
+    static bool writePNG(std::string filename, int width, int height, const std::vector<unsigned char>& rgb);
+};
+
+#endif //IMAGE_WRITER_H
@@ -0,0 +1,177 @@
+#include "InputLog.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+const uint32_t InputLog::VERSION = 1;
+
+static const char INPUT_MAGIC[4] = {'W', 'W', 'I', 'N'};
+
+InputLog::InputLog(): recording(NULL), cursor(0), replaying(false), seed(0) {
+}
+
+InputLog::~InputLog(){
+    stopRecording();
+}
+
+void InputLog::write(const void* data, size_t size){
+    if(fwrite(data, 1, size, recording) != size){
+        std::cerr << "[InputLog] Failed to write the recording" << std::endl;
+        exit(1);
+    }
+}
+
+void InputLog::read(void* data, size_t size){
+    if(cursor + size > replay.size()){
+        std::cerr << "[InputLog] Replay ends part way through a record" << std::endl;
+        exit(1);
+    }
+    memcpy(data, &replay[cursor], size);
+    cursor += size;
+}
+
+void InputLog::startRecording(std::string filename, uint32_t newSeed){
+    recording = fopen(filename.c_str(), "wb");
+    if(recording == NULL){
+        std::cerr << "[InputLog] Failed to open " << filename << " for writing" << std::endl;
+        exit(1);
+    }
+    seed = newSeed;
+    write(INPUT_MAGIC, sizeof(INPUT_MAGIC));
+    write(&VERSION, sizeof(VERSION));
+    write(&seed, sizeof(seed));
+}
+
+void InputLog::startReplay(std::string filename){
+    FILE* file = fopen(filename.c_str(), "rb");
+    if(file == NULL){
+        std::cerr << "[InputLog] Failed to open " << filename << std::endl;
+        exit(1);
+    }
+    unsigned char buffer[4096];
+    size_t count;
+    while((count = fread(buffer, 1, sizeof(buffer), file)) > 0){
+        replay.insert(replay.end(), buffer, buffer + count);
+    }
+    fclose(file);
+
+    char magic[4];
+    uint32_t version = 0;
+    if(replay.size() < sizeof(magic) + 2 * sizeof(uint32_t)){
+        std::cerr << "[InputLog] " << filename << " is too small to be an input log" << std::endl;
+        exit(1);
+    }
+    read(magic, sizeof(magic));
+    read(&version, sizeof(version));
+    if(memcmp(magic, INPUT_MAGIC, sizeof(INPUT_MAGIC)) != 0 || version != VERSION){
+        std::cerr << "[InputLog] " << filename << " is not a version " << VERSION << " input log" << std::endl;
+        exit(1);
+    }
+    read(&seed, sizeof(seed));
+    replaying = true;
+}
+
+void InputLog::stopRecording(){
+    if(recording != NULL){
+        if(fclose(recording) != 0){
+            std::cerr << "[InputLog] Failed to write the recording" << std::endl;
+        }
+        recording = NULL;
+    }
+}
+
+bool InputLog::isRecording() const {
+    return recording != NULL;
+}
+
+bool InputLog::isReplaying() const {
+    return replaying;
+}
+
+uint32_t InputLog::getSeed() const {
+    return seed;
+}
+
+void InputLog::recordFrame(double frameDt){
+    uint8_t type = FRAME;
+    write(&type, 1);
+    write(&frameDt, sizeof(frameDt));
+}
+
+void InputLog::recordKey(int key, int action, int mods){
+    uint8_t record[5] = {KEY, 0, 0, (uint8_t)action, (uint8_t)mods};
+    int16_t code = (int16_t)key;
+    memcpy(&record[1], &code, sizeof(code));
+    write(record, sizeof(record));
+}
+
+void InputLog::recordCursor(double x, double y){
+    uint8_t type = CURSOR;
+    float position[2] = {(float)x, (float)y};
+    write(&type, 1);
+    write(position, sizeof(position));
+}
+
+void InputLog::recordMouseButton(int button, int action, int mods){
+    uint8_t record[4] = {MOUSE_BUTTON, (uint8_t)button, (uint8_t)action, (uint8_t)mods};
+    write(record, sizeof(record));
+}
+
+void InputLog::recordScroll(double x, double y){
+    uint8_t type = SCROLL;
+    float offset[2] = {(float)x, (float)y};
+    write(&type, 1);
+    write(offset, sizeof(offset));
+}
+
+bool InputLog::readFrame(double& frameDt){
+    // Events of the previous frame that were not read are skipped
+    Event skipped;
+    while(readEvent(skipped));
+    if(cursor >= replay.size()) return false;
+    cursor++;   // The FRAME type
+    read(&frameDt, sizeof(frameDt));
+    return true;
+}
+
+bool InputLog::readEvent(Event& event){
+    if(cursor >= replay.size() || replay[cursor] == FRAME) return false;
+    uint8_t type;
+    read(&type, 1);
+    event.type = (EventType)type;
+    event.code = 0;
+    event.action = 0;
+    event.mods = 0;
+    event.x = 0.0f;
+    event.y = 0.0f;
+
+    uint8_t bytes[3];
+    float values[2];
+    int16_t code;
+    switch(event.type){
+        case KEY:
+            read(&code, sizeof(code));
+            read(bytes, 2);
+            event.code = code;
+            event.action = bytes[0];
+            event.mods = bytes[1];
+            break;
+        case MOUSE_BUTTON:
+            read(bytes, 3);
+            event.code = bytes[0];
+            event.action = bytes[1];
+            event.mods = bytes[2];
+            break;
+        case CURSOR:
+        case SCROLL:
+            read(values, sizeof(values));
+            event.x = values[0];
+            event.y = values[1];
+            break;
+        default:
+            std::cerr << "[InputLog] Unknown record type " << (int)type << " in the replay" << std::endl;
+            exit(1);
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <cstdio>
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+    Binary log of a play session's input, for replaying the same drive again.
+
+    Everything the simulation depends on is written: the random seed, the length of every frame and every input
+    event in the order the window delivered it. Replaying feeds the frame lengths to GameTime and the events to the
+    same callbacks, so the fixed steps see exactly the same input.
+
+    Layout, little endian and packed:
+        "WWIN", uint32 version, uint32 seed
+        then one record after another, each a uint8 type followed by
+            FRAME           float64 frame length in seconds, starts a frame
+            KEY             int16 key, uint8 action, uint8 mods
+            CURSOR          float32 x, float32 y
+            MOUSE_BUTTON    uint8 button, uint8 action, uint8 mods
+            SCROLL          float32 x offset, float32 y offset
+    Events follow the FRAME record of the frame they were polled at the end of.
+*/
+class InputLog {
+public:
+    static const uint32_t VERSION;
+
+    enum EventType {
+        FRAME = 0,
+        KEY = 1,
+        CURSOR = 2,
+        MOUSE_BUTTON = 3,
+        SCROLL = 4
+    };
+
+    struct Event {
+        EventType type;
+        int code;       // Key or mouse button
+        int action;
+        int mods;
+        float x, y;     // Cursor position or scroll offsets
+    };
+
+private:
+    FILE* recording;
+    std::vector<unsigned char> replay;
+    size_t cursor;      // Read position in replay
+    bool replaying;
+    uint32_t seed;
+
+    void write(const void* data, size_t size);
+    void read(void* data, size_t size);
+
+    InputLog(const InputLog&);
+    InputLog& operator=(const InputLog&);
+
+public:
+    InputLog();
+    ~InputLog();
+
+    // Both exit if the file cannot be opened, or for a replay, is not an input log of this version.
+    void startRecording(std::string filename, uint32_t seed);
+    void startReplay(std::string filename);
+    // Flushes and closes the recording.
+    void stopRecording();
+
+    bool isRecording() const;
+    bool isReplaying() const;
+    uint32_t getSeed() const;
+
+    void recordFrame(double frameDt);
+    void recordKey(int key, int action, int mods);
+    void recordCursor(double x, double y);
+    void recordMouseButton(int button, int action, int mods);
+    void recordScroll(double x, double y);
+
+    // Starts the next replayed frame. False once the log has no frames left.
+    bool readFrame(double& frameDt);
+    // Next event of the current frame, false when the frame has none left.
+    bool readEvent(Event& event);
+};
+
+#endif //INPUT_LOG_H
@@ -1,5 +1,8 @@
 #include "Loader.h"
 
+#include "Profiler.h"
+#include "RenderStats.h"
+
 #define VALS_PER_VERT 3
 #define VALS_PER_NORMAL 3
 #define VALS_PER_TEX 2
@@ -33,6 +36,25 @@ glm::vec3 Image::getPixel(int x, int y){
     return glm::vec3((float)data[offset] / 255, (float)data[offset + 1] / 255, (float)data[offset + 2] / 255);
 }
 
+HeightMap::HeightMap()
+        : width(-1), height(-1) {
+}
+
+HeightMap::HeightMap(std::vector<float> heights, int width, int height)
+        : heights(heights), width(width), height(height) {
+}
+
+float HeightMap::getSample(int x, int y) const {
+    if(x < 0 || x >= width || y < 0 || y >= height){
+        return -1.0f;   // Same convention as Image::getPixel, negative means off the map.
+    }
+    return heights[width * y + x];
+}
+
+size_t HeightMap::getByteSize() const {
+    return heights.size() * sizeof(float);
+}
+
 glm::vec3 getVertex(const std::vector<float>& vertices, int index){
     int pos = index*3;
     return glm::vec3(vertices[pos],
@@ -40,7 +62,9 @@ glm::vec3 getVertex(const std::vector<float>& vertices, int index){
                      vertices[pos+2]);
 }
 
-std::vector<float> Loader::generateNormals(std::vector<float> vertices, std::vector<unsigned int> indices){
+// Sums the unnormalised face normals into each vertex and normalises once at the end. The cross product is as long
+// as twice the triangle area, so larger faces weigh more, and no normalisation is repeated per face.
+std::vector<float> Loader::generateNormals(const std::vector<float>& vertices, const std::vector<unsigned int>& indices){
     std::vector<float> resultNormals(vertices.size(), 0.0f);
 
     // Iterate over each triangle as defined in indices
@@ -49,25 +73,25 @@ std::vector<float> Loader::generateNormals(std::vector<float> vertices, std::vec
         glm::vec3 vert2 = getVertex(vertices, indices[i+1]);
         glm::vec3 vert3 = getVertex(vertices, indices[i+2]);
 
-        glm::vec3 v1 = vert2 - vert1;
-        glm::vec3 v2 = vert3 - vert1;
-
-        glm::vec3 faceNormal = glm::cross(v1, v2);
-        faceNormal = glm::normalize(faceNormal);
+        glm::vec3 faceNormal = glm::cross(vert2 - vert1, vert3 - vert1);
 
-        // Iterate over each vertex in that triangle
+        // Add the current faces normal to each of its vertices
         for(size_t j = i; j < i+3; j++){
-            glm::vec3 vertNormal(resultNormals[indices[j] * 3],
-                                 resultNormals[(indices[j] * 3) + 1],
-                                 resultNormals[(indices[j] * 3) + 2]);
-
-            // Add the current faces normal to the vertexes normal
-            vertNormal = glm::normalize(vertNormal + faceNormal);
+            resultNormals[indices[j] * 3] += faceNormal.x;
+            resultNormals[(indices[j] * 3) + 1] += faceNormal.y;
+            resultNormals[(indices[j] * 3) + 2] += faceNormal.z;
+        }
+    }
 
-            resultNormals[indices[j] * 3] = vertNormal.x;
-            resultNormals[(indices[j] * 3) + 1] = vertNormal.y;
-            resultNormals[(indices[j] * 3) + 2] = vertNormal.z;
+    for(size_t i = 0; i < resultNormals.size(); i += 3){
+        glm::vec3 vertNormal(resultNormals[i], resultNormals[i + 1], resultNormals[i + 2]);
+        float length = glm::length(vertNormal);
+        if(length > 0.0f){
+            vertNormal /= length;
         }
+        resultNormals[i] = vertNormal.x;
+        resultNormals[i + 1] = vertNormal.y;
+        resultNormals[i + 2] = vertNormal.z;
     }
 
     return resultNormals;
@@ -81,6 +105,7 @@ inline bool Loader::fileExists(const std::string& name) {
 }
 
 Model Loader::loadModel(std::string filepath){
+    PROFILE_SCOPE("load model");
     // Declare containers for object values
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
@@ -131,7 +156,9 @@ ModelComponent Loader::loadModelComponent(tinyobj::shape_t shape, std::vector<ti
     }
     GLuint textureID = loadTexture(materialpath + material.diffuse_texname);
 
-    return ModelComponent(vao, numIndices, textureID, material);
+    ModelComponent component(vao, numIndices, textureID, material);
+    component.setMesh(std::make_shared<tinyobj::mesh_t>(std::move(shape.mesh)));
+    return component;
 }
 
 ModelComponent Loader::loadModelComponent(std::vector<float> vertices, std::vector<unsigned int> indices, std::vector<float> texCoords){
@@ -166,7 +193,7 @@ ModelComponent Loader::loadModelComponent(std::vector<float> vertices, std::vect
     return ModelComponent(vao, numIndices, textureID);
 }
 
-GLuint Loader::loadVAO(std::vector<float> vertices, std::vector<unsigned int> indices, std::vector<float> texCoords){
+GLuint Loader::loadVAO(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const std::vector<float>& texCoords){
     GLuint vaoHandle;
     glGenVertexArrays(1, &vaoHandle);
     glBindVertexArray(vaoHandle);
@@ -183,7 +210,7 @@ GLuint Loader::loadVAO(std::vector<float> vertices, std::vector<unsigned int> in
     return vaoHandle;
 }
 
-GLuint Loader::loadVAO(std::vector<float> vertices, std::vector<unsigned int> indices){
+GLuint Loader::loadVAO(const std::vector<float>& vertices, const std::vector<unsigned int>& indices){
     GLuint vaoHandle;
     glGenVertexArrays(1, &vaoHandle);
     glBindVertexArray(vaoHandle);
@@ -199,7 +226,13 @@ GLuint Loader::loadVAO(std::vector<float> vertices, std::vector<unsigned int> in
     return vaoHandle;
 }
 
-GLuint Loader::loadVAO(std::vector<float> vertices, std::vector<unsigned int> indices, std::vector<float> texCoords, std::vector<float> normals){
+GLuint Loader::loadVAO(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const std::vector<float>& texCoords, const std::vector<float>& normals){
+    return loadVAO(&vertices[0], vertices.size() / VALS_PER_VERT, &indices[0], indices.size(), &texCoords[0], &normals[0]);
+}
+
+// Same as above for data which does not live in std::vectors, such as meshes built in uninitialised storage.
+GLuint Loader::loadVAO(const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+        const float* texCoords, const float* normals){
     GLuint vaoHandle;
     glGenVertexArrays(1, &vaoHandle);
     glBindVertexArray(vaoHandle);
@@ -207,33 +240,43 @@ GLuint Loader::loadVAO(std::vector<float> vertices, std::vector<unsigned int> in
     unsigned int buffer[4];
     glGenBuffers(4, buffer);
 
-    setupBuffer(buffer[0], vertices, 0, VALS_PER_VERT);
-    setupBuffer(buffer[1], normals, 1, VALS_PER_NORMAL);
-    setupBuffer(buffer[2], texCoords, 2, VALS_PER_TEX);
-    setupIndicesBuffer(buffer[3], indices);
+    setupBuffer(buffer[0], vertices, vertexCount * VALS_PER_VERT, 0, VALS_PER_VERT);
+    setupBuffer(buffer[1], normals, vertexCount * VALS_PER_NORMAL, 1, VALS_PER_NORMAL);
+    setupBuffer(buffer[2], texCoords, vertexCount * VALS_PER_TEX, 2, VALS_PER_TEX);
+    setupIndicesBuffer(buffer[3], indices, indexCount);
 
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     return vaoHandle;
 }
 
-GLuint Loader::setupBuffer(unsigned int buffer, std::vector<float> values, int attributeIndex, int dataDimension){
+GLuint Loader::setupBuffer(unsigned int buffer, const std::vector<float>& values, int attributeIndex, int dataDimension){
+    return setupBuffer(buffer, &values[0], values.size(), attributeIndex, dataDimension);
+}
+
+GLuint Loader::setupBuffer(unsigned int buffer, const float* values, size_t count, int attributeIndex, int dataDimension){
     glBindBuffer(GL_ARRAY_BUFFER, buffer);
     glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(float) * values.size(),
-                 &values[0],
+                 sizeof(float) * count,
+                 values,
                  GL_STATIC_DRAW);
+    RenderStats::getRenderStats()->addBufferMemory(sizeof(float) * count);
     glVertexAttribPointer(attributeIndex, dataDimension, GL_FLOAT, GL_FALSE, 0, 0);
 
     return buffer;
 }
 
-GLuint Loader::setupIndicesBuffer(unsigned int buffer, std::vector<unsigned int> values){
+GLuint Loader::setupIndicesBuffer(unsigned int buffer, const std::vector<unsigned int>& values){
+    return setupIndicesBuffer(buffer, &values[0], values.size());
+}
+
+GLuint Loader::setupIndicesBuffer(unsigned int buffer, const unsigned int* values, size_t count){
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 sizeof(unsigned int) * values.size(),
-                 &values[0],
+                 sizeof(unsigned int) * count,
+                 values,
                  GL_STATIC_DRAW);
+    RenderStats::getRenderStats()->addBufferMemory(sizeof(unsigned int) * count);
     return buffer;
 }
 
@@ -254,6 +297,43 @@ GLuint Loader::loadVAO(tinyobj::shape_t shape){
                    shape.mesh.normals);
 }
 
+// Buffer feeding the given attribute of a VAO created by loadVAO, 0 if the attribute is unused.
+GLuint Loader::getVertexBuffer(GLuint vao, int attributeIndex){
+    GLint buffer = 0;
+    glBindVertexArray(vao);
+    glGetVertexAttribiv(attributeIndex, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &buffer);
+    glBindVertexArray(0);
+    return buffer;
+}
+
+// Deletes the VAO together with the vertex and index buffers attached to it by loadVAO.
+void Loader::deleteVAO(GLuint vao){
+    std::vector<GLuint> buffers;
+    for(GLuint attribute = 0; attribute < 3; attribute++){
+        GLuint buffer = getVertexBuffer(vao, attribute);
+        if(buffer != 0) buffers.push_back(buffer);
+    }
+
+    glBindVertexArray(vao);
+    GLint indexBuffer = 0;
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &indexBuffer);
+    if(indexBuffer != 0) buffers.push_back(indexBuffer);
+
+    glBindVertexArray(0);
+    // Bound to a target no VAO keeps, to read back their sizes
+    for(size_t i = 0; i < buffers.size(); i++){
+        GLint size = 0;
+        glBindBuffer(GL_COPY_READ_BUFFER, buffers[i]);
+        glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        RenderStats::getRenderStats()->addBufferMemory(-size);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    if(!buffers.empty()){
+        glDeleteBuffers(buffers.size(), &buffers[0]);
+    }
+    glDeleteVertexArrays(1, &vao);
+}
+
 Image Loader::loadImage(std::string filepath){
     int x, y, n;
     if (!fileExists(filepath)){
@@ -271,6 +351,101 @@ Image Loader::loadImage(std::string filepath){
     return Image(data, x,y,n);
 }
 
+// Loads a height map into normalised samples.
+// Supported formats:
+//   .r16        - raw square grid of little endian unsigned 16 bit values
+//   .r32, .raw  - raw square grid of 32 bit floats, already in [0, 1]
+//   anything else goes through stb_image. 16 bit PNGs keep their full precision,
+//   8 bit images average the RGB channels like the original terrain did.
+HeightMap Loader::loadHeightMap(std::string filepath){
+    PROFILE_SCOPE("load height map");
+    if (!fileExists(filepath)){
+        std::cerr << "[Loader] File " << filepath << " doesn't exist, exiting" << std::endl;
+        exit(1);
+    }
+
+    std::string extension = filepath.substr(filepath.find_last_of('.') + 1);
+    if(extension == "r16" || extension == "r32" || extension == "raw"){
+        std::ifstream file(filepath, std::ios::in | std::ios::binary | std::ios::ate);
+        if(!file.is_open()){
+            std::cerr << "[Loader][Error] Cannot open height map " << filepath << ", exiting" << std::endl;
+            exit(1);
+        }
+        std::streamoff end = file.tellg();
+        if(end <= 0){
+            std::cerr << "[Loader][Error] Raw height map " << filepath << " is empty." << std::endl;
+            exit(1);
+        }
+        size_t bytes = (size_t)end;
+        file.seekg(0);
+
+        size_t sampleSize = extension == "r16" ? sizeof(unsigned short) : sizeof(float);
+        int side = (int)std::sqrt((double)(bytes / sampleSize));
+        if(side == 0 || (size_t)side * side * sampleSize != bytes){
+            std::cerr << "[Loader][Error] Raw height map " << filepath << " is not a square grid." << std::endl;
+            exit(1);
+        }
+
+        std::vector<float> heights(side * side);
+        std::vector<unsigned char> raw;
+        char* destination = (char*)&heights[0];
+        if(extension == "r16"){
+            raw.resize(bytes);
+            destination = (char*)&raw[0];
+        }
+        if(!file.read(destination, bytes)){
+            std::cerr << "[Loader][Error] Could not read raw height map " << filepath << ", exiting" << std::endl;
+            exit(1);
+        }
+        if(extension == "r16"){
+            for(size_t i = 0; i < heights.size(); i++){
+                heights[i] = (float)(raw[2 * i] | (raw[2 * i + 1] << 8)) / 65535.0f;
+            }
+        }
+        return HeightMap(heights, side, side);
+    }
+
+    int x, y, n;
+    std::vector<float> heights;
+    if(stbi_is_16_bit(filepath.c_str())){
+        unsigned short *data = stbi_load_16(filepath.c_str(), &x, &y, &n, 0);
+        if(data == NULL){
+            std::cerr << "[Loader][Error] Could not read height map " << filepath << ": " << stbi_failure_reason()
+                      << ", exiting" << std::endl;
+            exit(1);
+        }
+        heights.resize(x * y);
+        int used = std::min(n, 3);
+        for(int i = 0; i < x * y; i++){
+            float sum = 0.0f;
+            for(int c = 0; c < used; c++){
+                sum += data[i * n + c];
+            }
+            heights[i] = sum / used / 65535.0f;
+        }
+        stbi_image_free(data);
+    } else {
+        unsigned char *data = stbi_load(filepath.c_str(), &x, &y, &n, 0);
+        if(data == NULL){
+            std::cerr << "[Loader][Error] Could not read height map " << filepath << ": " << stbi_failure_reason()
+                      << ", exiting" << std::endl;
+            exit(1);
+        }
+        heights.resize(x * y);
+        int used = std::min(n, 3);
+        for(int i = 0; i < x * y; i++){
+            float sum = 0.0f;
+            for(int c = 0; c < used; c++){
+                sum += (float)data[i * n + c] / 255;
+            }
+            heights[i] = sum / used;
+        }
+        stbi_image_free(data);
+    }
+
+    return HeightMap(heights, x, y);
+}
+
 GLuint Loader::loadCubemapTexture(std::vector<std::string> filenames){
     if(filenames.size() != 6){
         std::cerr << "[Loader][Error] Cubemap requires 6 texture files." << std::endl;
@@ -296,6 +471,7 @@ GLuint Loader::loadCubemapTexture(std::vector<std::string> filenames){
         }
 
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
+        RenderStats::getRenderStats()->addTextureMemory(4LL * image.width * image.height);
         stbi_image_free(image.data);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -308,6 +484,7 @@ GLuint Loader::loadCubemapTexture(std::vector<std::string> filenames){
 }
 
 GLuint Loader::loadTexture(std::string filepath){
+    PROFILE_SCOPE("load texture");
     if (loadedTextures.count(filepath)){
         std::cout << "[Loader] '" << filepath << "' already loaded, using cached texture." << std::endl;
         return loadedTextures[filepath];
@@ -353,6 +530,8 @@ GLuint Loader::loadTextureData(GLubyte *data, int x, int y, int n, GLenum textur
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glGenerateMipmap(GL_TEXTURE_2D);
+    // The mipmaps add a third
+    RenderStats::getRenderStats()->addTextureMemory(4LL * x * y * 4 / 3);
 
     return textureID;
 }
@@ -15,6 +15,8 @@
 #include <vector>
 #include <map>
 #include <iostream>
+#include <fstream>
+#include <cmath>
 #include <glm/glm.hpp>
 
 struct Image {
@@ -28,6 +30,19 @@ struct Image {
     glm::vec3 getPixel(int x, int y);
 };
 
+// Height samples normalised to [0, 1], stored row by row.
+// Unlike Image it owns its data, so it can be handed between threads and freed with the tile it belongs to.
+struct HeightMap {
+    std::vector<float> heights;
+    int width;
+    int height;
+
+    HeightMap();
+    HeightMap(std::vector<float> heights, int width, int height);
+    float getSample(int x, int y) const;
+    size_t getByteSize() const;
+};
+
 class Loader {
 private:
     static Loader* loader;
@@ -36,12 +51,14 @@ private:
     // Stores the file/id mapping for each loaded texture to use for caching.
     std::map<std::string, GLuint> loadedTextures;
     GLuint loadTextureData(GLubyte *data, int x, int y, int n, GLenum textureUnit);
-    GLuint setupBuffer(unsigned int buffer, std::vector<float> values, int attributeIndex, int dataDimension);
-    GLuint setupIndicesBuffer(unsigned int buffer, std::vector<unsigned int> values);
+    GLuint setupBuffer(unsigned int buffer, const std::vector<float>& values, int attributeIndex, int dataDimension);
+    GLuint setupBuffer(unsigned int buffer, const float* values, size_t count, int attributeIndex, int dataDimension);
+    GLuint setupIndicesBuffer(unsigned int buffer, const std::vector<unsigned int>& values);
+    GLuint setupIndicesBuffer(unsigned int buffer, const unsigned int* values, size_t count);
 public:
     static Loader* getLoader();
 
-    std::vector<float> generateNormals(std::vector<float> vertices, std::vector<unsigned int> indices);
+    std::vector<float> generateNormals(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
 
     bool fileExists(const std::string& name);
     Model loadModel(std::string filepath);
@@ -52,12 +69,17 @@ public:
     ModelComponent loadModelComponent(std::vector<float> vertices, std::vector<unsigned int> indices, std::vector<float> texCoords, std::string texturepath);
     ModelComponent loadModelComponent(std::vector<float> vertices, std::vector<unsigned int> indices, std::vector<float> texCoords, std::vector<float> normals, std::string texturepath);
 
-    GLuint loadVAO(std::vector<float> vertices, std::vector<unsigned int> indices);
-    GLuint loadVAO(std::vector<float> vertices, std::vector<unsigned int> indices, std::vector<float> texCoords);
-    GLuint loadVAO(std::vector<float> vertices, std::vector<unsigned int> indices, std::vector<float> texCoords, std::vector<float> normals);
+    GLuint loadVAO(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
+    GLuint loadVAO(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const std::vector<float>& texCoords);
+    GLuint loadVAO(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const std::vector<float>& texCoords, const std::vector<float>& normals);
+    GLuint loadVAO(const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+            const float* texCoords, const float* normals);
     GLuint loadVAO(tinyobj::shape_t);
+    void deleteVAO(GLuint vao);
+    GLuint getVertexBuffer(GLuint vao, int attributeIndex);
 
     Image loadImage(std::string filepath);
+    HeightMap loadHeightMap(std::string filepath);
     GLuint loadCubemapTexture(std::vector<std::string> filenames);
     GLuint loadTexture(std::string filepath);
     GLuint loadDefaultTexture();
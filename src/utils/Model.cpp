@@ -62,6 +62,14 @@ tinyobj::material_t ModelComponent::getMaterial() const{
     return material;
 }
 
+const tinyobj::mesh_t* ModelComponent::getMesh() const {
+    return mesh.get();
+}
+
+void ModelComponent::setMesh(std::shared_ptr<const tinyobj::mesh_t> mesh){
+    this->mesh = mesh;
+}
+
 Model::Model(std::vector<ModelComponent> components){
     this->components = components;
     for(int i = 0; i < 3; ++i){
@@ -71,7 +79,7 @@ Model::Model(std::vector<ModelComponent> components){
 }
 
 // Adds the vertices into the range stored for this model.
-void Model::addRange(std::vector<float> vertices){
+void Model::addRange(const std::vector<float>& vertices){
     for(int dim = 0; dim < 3; ++dim){
         for(size_t j = dim; j < vertices.size(); j += 3){
             maxRanges[2 * dim] = std::min(vertices[j], maxRanges[2 * dim]);
@@ -13,6 +13,7 @@
 #include <utility>
 #include <algorithm>
 #include <iostream>
+#include <memory>
 
 void initMaterial(tinyobj::material_t &material);
 
@@ -22,6 +23,7 @@ private:
     GLuint vaoID;
     int indexCount;
     tinyobj::material_t material;
+    std::shared_ptr<const tinyobj::mesh_t> mesh;   // CPU copy of the vertex data, kept for static batching
 
 public:
     GLuint textureID;
@@ -33,6 +35,8 @@ public:
     GLuint getVaoID() const;
     GLuint getTextureID() const;
     tinyobj::material_t getMaterial() const;
+    const tinyobj::mesh_t* getMesh() const;     // NULL for components built without a mesh
+    void setMesh(std::shared_ptr<const tinyobj::mesh_t> mesh);
 };
 
 // Represents a grouping of meshes/shapes/vaos/ModelComponents to form a larger object.
@@ -46,7 +50,7 @@ public:
     void addModelComponent(ModelComponent);
     std::vector<ModelComponent>* getModelComponents();
 
-    void addRange(std::vector<float> vertices);
+    void addRange(const std::vector<float>& vertices);
     std::pair<float, float> getRangeInDim(int dim);
 };
 
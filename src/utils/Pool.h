@@ -0,0 +1,122 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "Arena.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+/*
+    Reference to an object in a Pool. Each slot counts how often it has been reused, so a handle kept after its
+    object was destroyed no longer resolves, even if the slot holds a new object by then.
+*/
+template <typename T>
+struct PoolHandle {
+    unsigned int index;
+    unsigned int generation;    // 0 is never handed out, so a default handle is always invalid
+
+    PoolHandle(): index(0), generation(0) {}
+    PoolHandle(unsigned int index, unsigned int generation): index(index), generation(generation) {}
+
+    bool operator==(const PoolHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const PoolHandle& other) const { return !(*this == other); }
+};
+
+/*
+    Fixed number of objects of one type in storage taken from an Arena up front. Objects never move, so pointers
+    from get() stay valid until the object is destroyed. Creating and destroying objects does not touch the heap.
+*/
+template <typename T>
+class Pool {
+private:
+    T* objects;
+    unsigned int* generations;
+    bool* alive;
+    std::vector<unsigned int> freeSlots;
+    size_t capacity;
+
+    Pool(const Pool&);
+    Pool& operator=(const Pool&);
+
+public:
+    Pool(Arena& arena, size_t capacity);
+    ~Pool();
+
+    template <typename... Args>
+    PoolHandle<T> create(Args&&... args);
+    void destroy(PoolHandle<T> handle);
+
+    // NULL if the handle is stale or was never valid.
+    T* get(PoolHandle<T> handle) const;
+    bool isValid(PoolHandle<T> handle) const;
+
+    size_t size() const;
+    size_t getCapacity() const;
+};
+
+template <typename T>
+Pool<T>::Pool(Arena& arena, size_t capacity): capacity(capacity) {
+    objects = (T*)arena.allocate(sizeof(T) * capacity, alignof(T));
+    generations = (unsigned int*)arena.allocate(sizeof(unsigned int) * capacity, alignof(unsigned int));
+    alive = (bool*)arena.allocate(sizeof(bool) * capacity, alignof(bool));
+    freeSlots.reserve(capacity);
+    for(size_t i = 0; i < capacity; i++){
+        generations[i] = 0;
+        alive[i] = false;
+        freeSlots.push_back(capacity - 1 - i);  // Lowest slots are handed out first
+    }
+}
+
+template <typename T>
+Pool<T>::~Pool(){
+    for(size_t i = 0; i < capacity; i++){
+        if(alive[i]) objects[i].~T();
+    }
+}
+
+template <typename T>
+template <typename... Args>
+PoolHandle<T> Pool<T>::create(Args&&... args){
+    if(freeSlots.empty()){
+        std::cerr << "[Pool] Out of slots, capacity is " << capacity << std::endl;
+        exit(1);
+    }
+    unsigned int index = freeSlots.back();
+    freeSlots.pop_back();
+    new (&objects[index]) T(std::forward<Args>(args)...);
+    alive[index] = true;
+    generations[index]++;
+    return PoolHandle<T>(index, generations[index]);
+}
+
+template <typename T>
+void Pool<T>::destroy(PoolHandle<T> handle){
+    if(!isValid(handle)) return;
+    objects[handle.index].~T();
+    alive[handle.index] = false;
+    freeSlots.push_back(handle.index);
+}
+
+template <typename T>
+T* Pool<T>::get(PoolHandle<T> handle) const {
+    return isValid(handle) ? &objects[handle.index] : NULL;
+}
+
+template <typename T>
+bool Pool<T>::isValid(PoolHandle<T> handle) const {
+    return handle.index < capacity && alive[handle.index] && generations[handle.index] == handle.generation;
+}
+
+template <typename T>
+size_t Pool<T>::size() const {
+    return capacity - freeSlots.size();
+}
+
+template <typename T>
+size_t Pool<T>::getCapacity() const {
+    return capacity;
+}
+
+#endif //POOL_H
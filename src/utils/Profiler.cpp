@@ -0,0 +1,127 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+// Initialise Profiler singleton, up front because worker threads ask for it as soon as they start
+std::atomic<bool> Profiler::capturing(false);
+Profiler* Profiler::profiler = new Profiler();
+
+// The ring of the calling thread, NULL until it first records or is named
+static thread_local void* threadRing = NULL;
+
+// Events this close to being overwritten are left out of the trace, their thread may be writing over them.
+static const size_t RING_MARGIN = 256;
+
+Profiler::Profiler(): gpuRing(NULL), captureStart(0), frameStart(0), framesLeft(0) {
+}
+
+Profiler* Profiler::getProfiler(){
+    if(profiler == NULL){
+        profiler = new Profiler();
+    }
+    return profiler;
+}
+
+uint64_t Profiler::getTimestamp(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::ThreadRing* Profiler::addRing(const std::string& name){
+    ThreadRing* ring = new ThreadRing();
+    ring->written = 0;
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    ring->id = (int)threads.size();
+    ring->name = name.empty() ? "thread " + std::to_string(ring->id) : name;
+    threads.push_back(ring);
+    return ring;
+}
+
+Profiler::ThreadRing* Profiler::getThreadRing(){
+    if(threadRing == NULL){
+        threadRing = addRing("");
+    }
+    return (ThreadRing*)threadRing;
+}
+
+void Profiler::setThreadName(const char* name){
+    ThreadRing* ring = getThreadRing();
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    ring->name = name;
+}
+
+void Profiler::startCapture(int frames, std::string filename){
+    captureFilename = filename;
+    framesLeft = std::max(frames, 1);
+    captureStart = getTimestamp();
+    frameStart = captureStart;
+    capturing.store(true);
+}
+
+void Profiler::endFrame(){
+    if(!isCapturing()) return;
+    uint64_t frameEnd = getTimestamp();
+    record("frame", frameStart, frameEnd);
+    frameStart = frameEnd;
+    if(--framesLeft > 0) return;
+
+    capturing.store(false);
+    writeChromeTrace(captureFilename);
+    std::cout << "[Profiler] Trace written to " << captureFilename << std::endl;
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end){
+    write(getThreadRing(), name, start, end);
+}
+
+void Profiler::recordGpu(const char* name, uint64_t start, uint64_t end){
+    if(gpuRing == NULL){
+        gpuRing = addRing("GPU");
+    }
+    write(gpuRing, name, start, end);
+}
+
+// Only one thread ever writes to a ring, the reader finds the new event once written is increased.
+void Profiler::write(ThreadRing* ring, const char* name, uint64_t start, uint64_t end){
+    uint64_t index = ring->written.load(std::memory_order_relaxed);
+    Event& event = ring->events[index & (RING_SIZE - 1)];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+// Complete ("X") events in microseconds from the start of the capture, plus a name for every thread.
+void Profiler::writeChromeTrace(const std::string& filename){
+    FILE* file = fopen(filename.c_str(), "w");
+    if(file == NULL){
+        std::cerr << "[Profiler] Failed to open " << filename << " for writing" << std::endl;
+        return;
+    }
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    for(size_t t = 0; t < threads.size(); t++){
+        ThreadRing* ring = threads[t];
+        fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                "\"args\": {\"name\": \"%s\"}}", first ? "" : ",\n", ring->id, ring->name.c_str());
+        first = false;
+
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        uint64_t count = std::min(written, (uint64_t)(RING_SIZE - RING_MARGIN));
+        for(uint64_t i = written - count; i < written; i++){
+            const Event& event = ring->events[i & (RING_SIZE - 1)];
+            if(event.start < captureStart) continue;
+            fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                    "\"ts\": %.3f, \"dur\": %.3f}", event.name, ring->id, (event.start - captureStart) / 1000.0,
+                    event.duration / 1000.0);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    if(fclose(file) != 0){
+        std::cerr << "[Profiler] Failed to write " << filename << std::endl;
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+    Scoped CPU timings, saved as a Chrome trace (chrome://tracing or ui.perfetto.dev) for a number of frames.
+
+    PROFILE_SCOPE("name") times the rest of the enclosing block. Scopes nest, the trace viewer stacks them by time.
+    Names must be string literals, only the pointer is kept.
+
+    Every thread writes its scopes into its own ring of the last RING_SIZE scopes, which only that thread writes to,
+    so recording takes no lock. Outside a capture a scope is one relaxed atomic load, and built without
+    USE_PROFILER (cmake -DPROFILER=OFF) PROFILE_SCOPE compiles to nothing.
+
+    A thread's ring is allocated the first time it records or is named, and kept until the program exits. Long lived
+    threads name themselves with PROFILE_THREAD_NAME("name") when they start, so that this does not happen in the
+    middle of a frame. Without USE_PROFILER that compiles to nothing too, and no ring is allocated.
+*/
+class Profiler {
+public:
+    static const size_t RING_SIZE = 1 << 15;    // Per thread, a power of two
+
+private:
+    struct Event {
+        const char* name;
+        uint64_t start;     // ns on the steady clock
+        uint64_t duration;
+    };
+
+    struct ThreadRing {
+        std::string name;
+        int id;
+        std::atomic<uint64_t> written;  // Events ever written, the next one goes to written % RING_SIZE
+        Event events[RING_SIZE];
+    };
+
+    static Profiler* profiler;
+    Profiler();
+
+    std::mutex threadsMutex;
+    std::vector<ThreadRing*> threads;
+    ThreadRing* gpuRing;
+    static std::atomic<bool> capturing;
+    uint64_t captureStart;
+    uint64_t frameStart;
+    int framesLeft;
+    std::string captureFilename;
+
+    ThreadRing* getThreadRing();
+    ThreadRing* addRing(const std::string& name);
+    static void write(ThreadRing* ring, const char* name, uint64_t start, uint64_t end);
+    void writeChromeTrace(const std::string& filename);
+
+public:
+    static Profiler* getProfiler();
+    static uint64_t getTimestamp();     // ns
+
+    void setThreadName(const char* name);
+
+    // Records the next frames, counted by endFrame(), then writes them to the file and stops.
+    void startCapture(int frames, std::string filename);
+    static bool isCapturing(){ return capturing.load(std::memory_order_relaxed); }
+    // Should be called by the main loop once per frame. Records a "frame" scope since the previous call.
+    void endFrame();
+
+    void record(const char* name, uint64_t start, uint64_t end);
+    // Onto a separate GPU track, with GPU times already turned into steady clock ones. Main thread only.
+    void recordGpu(const char* name, uint64_t start, uint64_t end);
+};
+
+// Times its own lifetime, see PROFILE_SCOPE.
+class ProfileScope {
+private:
+    const char* name;
+    uint64_t start;     // 0 when not capturing
+public:
+    explicit ProfileScope(const char* name): name(name),
+            start(Profiler::isCapturing() ? Profiler::getTimestamp() : 0) {}
+    ~ProfileScope(){
+        if(start != 0) Profiler::getProfiler()->record(name, start, Profiler::getTimestamp());
+    }
+};
+
+#ifdef USE_PROFILER
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) Profiler::getProfiler()->setThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD_NAME(name)
+#endif
+
+#endif //PROFILER_H
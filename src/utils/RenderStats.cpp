@@ -0,0 +1,49 @@
+#include "RenderStats.h"
+
+#include <cstddef>
+
+// Initialise singleton
+RenderStats* RenderStats::renderStats = NULL;
+
+RenderStats::RenderStats(): glCallsCounted(false), textureBytes(0), bufferBytes(0) {
+    reset();
+}
+
+RenderStats* RenderStats::getRenderStats(){
+    if(renderStats == NULL){
+        renderStats = new RenderStats();
+    }
+
+    return renderStats;
+}
+
+void RenderStats::reset(){
+    drawCalls = 0;
+    triangles = 0;
+    terrainTilesDrawn = 0;
+    terrainTilesTotal = 0;
+    matricesRecomputed = 0;
+    allocations = 0;
+    entitiesDrawn = 0;
+    entitiesCulled = 0;
+    glDraws = 0;
+    glStateChanges = 0;
+    glTextureBinds = 0;
+    glUniformCalls = 0;
+    glBufferUploads = 0;
+    glBufferUploadBytes = 0;
+    glRedundantBinds = 0;
+}
+
+void RenderStats::addDraw(long long indexCount){
+    drawCalls++;
+    triangles += indexCount / 3;
+}
+
+void RenderStats::addTextureMemory(long long bytes){
+    textureBytes += bytes;
+}
+
+void RenderStats::addBufferMemory(long long bytes){
+    bufferBytes += bytes;
+}
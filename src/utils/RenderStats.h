@@ -0,0 +1,42 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+// Counters for what was submitted to the GPU, and the CPU work behind it, during the current frame.
+class RenderStats {
+private:
+    static RenderStats* renderStats;
+    RenderStats();
+public:
+    static RenderStats* getRenderStats();
+
+    int drawCalls;
+    long long triangles;
+    int terrainTilesDrawn;
+    int terrainTilesTotal;
+    int matricesRecomputed;     // Entity model matrices rebuilt because their transform changed
+    int allocations;            // Calls to operator new during the frame, set by the main loop
+    int entitiesDrawn;
+    int entitiesCulled;         // Entities and instances skipped by frustum culling
+
+    // GL calls, only counted when GLCallCounter is installed
+    bool glCallsCounted;
+    int glDraws;
+    int glStateChanges;         // Enables, binds other than textures, vertex attributes, texture parameters...
+    int glTextureBinds;
+    int glUniformCalls;
+    int glBufferUploads;
+    long long glBufferUploadBytes;
+    int glRedundantBinds;       // Binds of what was already bound
+
+    // Estimated GPU memory in use, kept across frames. RGB textures count four bytes a texel, plus their mipmaps.
+    long long textureBytes;
+    long long bufferBytes;
+
+    void reset();   // Should be called once per frame, before rendering
+    void addDraw(long long indexCount);
+    // Negative when memory is freed
+    void addTextureMemory(long long bytes);
+    void addBufferMemory(long long bytes);
+};
+
+#endif //RENDER_STATS_H
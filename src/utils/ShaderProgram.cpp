@@ -16,6 +16,33 @@ void ShaderProgram::disable(){
     glUseProgram(0);
 }
 
+// Lights are passed as an array of structs, each member has its own uniform named like lights[0].position
+void ShaderProgram::bindLightLocations(){
+    for(int i = 0; i < MAX_LIGHTS; i++){
+        std::ostringstream prefix;
+        prefix << "lights[" << i << "].";
+        LightLocations& locations = lightLocations[i];
+        locations.position = glGetUniformLocation(shaderID, (prefix.str() + "position").c_str());
+        locations.specular = glGetUniformLocation(shaderID, (prefix.str() + "specular").c_str());
+        locations.diffuse = glGetUniformLocation(shaderID, (prefix.str() + "diffuse").c_str());
+        locations.ambient = glGetUniformLocation(shaderID, (prefix.str() + "ambient").c_str());
+        locations.radius = glGetUniformLocation(shaderID, (prefix.str() + "radius").c_str());
+        locations.coneAngle = glGetUniformLocation(shaderID, (prefix.str() + "coneAngle").c_str());
+        locations.coneDirection = glGetUniformLocation(shaderID, (prefix.str() + "coneDirection").c_str());
+    }
+}
+
+void ShaderProgram::loadLight(const Light* light, int index){
+    const LightLocations& locations = lightLocations[index];
+    loadUniformValue(locations.position, light->position);
+    loadUniformValue(locations.specular, light->specular);
+    loadUniformValue(locations.diffuse, light->diffuse);
+    loadUniformValue(locations.ambient, light->ambient);
+    loadUniformValue(locations.radius, light->radius);
+    loadUniformValue(locations.coneAngle, light->coneAngle);
+    loadUniformValue(locations.coneDirection, light->coneDirection);
+}
+
 GLuint ShaderProgram::getShaderID() {
     return shaderID;
 }
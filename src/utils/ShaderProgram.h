@@ -16,11 +16,32 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
+#include "../objects/Light.h"
+
 // Abstract shader program class, holds all uniforms,
 class ShaderProgram {
 protected:
     GLuint shaderID;
 
+    // Same as MAX_LIGHTS in the shaders, lights past it are ignored.
+    static const int MAX_LIGHTS = 10;
+
+    // Locations of the members of lights[i], looked up once instead of by name every frame.
+    struct LightLocations {
+        GLuint position;
+        GLuint specular;
+        GLuint diffuse;
+        GLuint ambient;
+        GLuint radius;
+        GLuint coneAngle;
+        GLuint coneDirection;
+    };
+    LightLocations lightLocations[MAX_LIGHTS];
+
+    // Should be called from bindUniformLocations() by shaders with a lights array.
+    void bindLightLocations();
+    void loadLight(const Light* light, int index);
+
 private:
     // Taken from previous given shader loader.
     int compileShader(const char *ShaderPath, const GLuint ShaderID);
@@ -32,9 +53,6 @@ public:
     virtual void enable();
     virtual void disable();
 
-    template <typename T>
-    void loadLightUniform(std::string property, int index,const T& value);
-
     // Uniform loading helpers
     void loadUniformValue(GLuint uniformLocation, int value);
     void loadUniformValue(GLuint uniformLocation, float value);
@@ -50,17 +68,4 @@ public:
 };
 
 
-// Should generalise this to take 'lights' as a paramter
-template <typename T>
-void ShaderProgram::loadLightUniform(std::string property, int index, const T& value){
-    // Lights are passed as an array of structs. However these are essentially bound and send individually.
-    // They have special uniform name syntax though. ie uniform_name[i].property -> lights[0].position
-    std::ostringstream ss;
-    ss << "lights[" << index << "]." << property;
-    std::string uniformName = ss.str();
-
-    GLuint uniform_location = glGetUniformLocation(shaderID, uniformName.c_str());
-    loadUniformValue(uniform_location, value);
-}
-
 #endif //SHADERPROGRAM_H
\ No newline at end of file
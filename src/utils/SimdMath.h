@@ -0,0 +1,118 @@
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+// Vector versions of the few libm functions the batched loops need, on 4 (SSE2) or 8 (AVX2) floats at a time.
+// The AVX2 functions carry the target attribute, so only call them after checking the CPU supports AVX2.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_MATH_X86
+#include <cmath>
+#include <immintrin.h>
+
+// Sine and cosine polynomials on [-pi/4, pi/4] from Cephes, after reducing by the nearest multiple of pi/2.
+static const float PIO2_1 = 1.5703125f;                     // pi/2 split in three for an exact reduction
+static const float PIO2_2 = 4.837512969970703125e-4f;
+static const float PIO2_3 = 7.54978995489188216e-8f;
+static const float TWO_OVER_PI = 0.636619772367581343f;
+static const float SIN_P0 = -1.9515295891e-4f;
+static const float SIN_P1 = 8.3321608736e-3f;
+static const float SIN_P2 = -1.6666654611e-1f;
+static const float COS_P0 = 2.443315711809948e-5f;
+static const float COS_P1 = -1.388731625493765e-3f;
+static const float COS_P2 = 4.166664568298827e-2f;
+
+static inline void sincos_sse2(__m128 x, __m128* s, __m128* c){
+    __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)));
+    __m128 qf = _mm_cvtepi32_ps(q);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(PIO2_1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(PIO2_2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(PIO2_3)));
+    __m128 r2 = _mm_mul_ps(r, r);
+
+    __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_P0), r2), _mm_set1_ps(SIN_P1));
+    ps = _mm_add_ps(_mm_mul_ps(ps, r2), _mm_set1_ps(SIN_P2));
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, r2), r), r);
+    __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_P0), r2), _mm_set1_ps(COS_P1));
+    pc = _mm_add_ps(_mm_mul_ps(pc, r2), _mm_set1_ps(COS_P2));
+    pc = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(pc, r2), r2), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))));
+
+    // Odd quadrants swap sine and cosine, quadrants 2 and 3 negate the sine, 1 and 2 the cosine.
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)),
+                                                                   _mm_set1_epi32(2)), 30));
+    __m128 sinValue = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+    __m128 cosValue = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+    *s = _mm_xor_ps(sinValue, sinSign);
+    *c = _mm_xor_ps(cosValue, cosSign);
+}
+
+__attribute__((target("avx2")))
+static inline void sincos_avx2(__m256 x, __m256* s, __m256* c){
+    __m256i q = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(TWO_OVER_PI)));
+    __m256 qf = _mm256_cvtepi32_ps(q);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(qf, _mm256_set1_ps(PIO2_1)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(qf, _mm256_set1_ps(PIO2_2)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(qf, _mm256_set1_ps(PIO2_3)));
+    __m256 r2 = _mm256_mul_ps(r, r);
+
+    __m256 ps = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_P0), r2), _mm256_set1_ps(SIN_P1));
+    ps = _mm256_add_ps(_mm256_mul_ps(ps, r2), _mm256_set1_ps(SIN_P2));
+    ps = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ps, r2), r), r);
+    __m256 pc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_P0), r2), _mm256_set1_ps(COS_P1));
+    pc = _mm256_add_ps(_mm256_mul_ps(pc, r2), _mm256_set1_ps(COS_P2));
+    pc = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(pc, r2), r2),
+                       _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(r2, _mm256_set1_ps(0.5f))));
+
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)),
+                                                         _mm256_set1_epi32(1)));
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+            _mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+    __m256 sinValue = _mm256_blendv_ps(ps, pc, swap);
+    __m256 cosValue = _mm256_blendv_ps(pc, ps, swap);
+    *s = _mm256_xor_ps(sinValue, sinSign);
+    *c = _mm256_xor_ps(cosValue, cosSign);
+}
+
+// Arc tangent from Cephes, reduced to [0, tan(pi/8)] using atan(x) = pi/4 + atan((x - 1) / (x + 1)) and
+// atan(x) = pi/2 - atan(1 / x). Within a couple of float ulps of atanf.
+static const float TAN_3PI_8 = 2.414213562373095f;
+static const float TAN_PI_8 = 0.4142135623730950f;
+static const float ATAN_P0 = 8.05374449538e-2f;
+static const float ATAN_P1 = -1.38776856032e-1f;
+static const float ATAN_P2 = 1.99777106478e-1f;
+static const float ATAN_P3 = -3.33329491539e-1f;
+
+__attribute__((target("avx2")))
+static inline __m256 atan_avx2(__m256 x){
+    __m256 signBit = _mm256_set1_ps(-0.0f);
+    __m256 sign = _mm256_and_ps(x, signBit);
+    __m256 a = _mm256_andnot_ps(signBit, x);
+
+    __m256 large = _mm256_cmp_ps(a, _mm256_set1_ps(TAN_3PI_8), _CMP_GT_OQ);
+    __m256 medium = _mm256_andnot_ps(large, _mm256_cmp_ps(a, _mm256_set1_ps(TAN_PI_8), _CMP_GT_OQ));
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 r = a;
+    r = _mm256_blendv_ps(r, _mm256_div_ps(_mm256_sub_ps(a, one), _mm256_add_ps(a, one)), medium);
+    r = _mm256_blendv_ps(r, _mm256_div_ps(_mm256_set1_ps(-1.0f), a), large);
+    __m256 offset = _mm256_and_ps(medium, _mm256_set1_ps((float)M_PI_4));
+    offset = _mm256_blendv_ps(offset, _mm256_set1_ps((float)M_PI_2), large);
+
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(ATAN_P0), r2), _mm256_set1_ps(ATAN_P1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(ATAN_P2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(ATAN_P3));
+    p = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, r2), r), r);
+    return _mm256_xor_ps(_mm256_add_ps(offset, p), sign);
+}
+
+// atan2(y, x) for x >= 0, i.e. angles in [-pi/2, pi/2]. atan2(0, 0) is 0 like libm.
+__attribute__((target("avx2")))
+static inline __m256 atan2_nonnegative_x_avx2(__m256 y, __m256 x){
+    return atan_avx2(_mm256_div_ps(y, _mm256_max_ps(x, _mm256_set1_ps(1e-30f))));
+}
+
+#endif //SIMD_MATH_X86
+
+#endif //SIMD_MATH_H
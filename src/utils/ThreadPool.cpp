@@ -0,0 +1,111 @@
+#include "ThreadPool.h"
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+// Initialise ThreadPool singleton
+ThreadPool* ThreadPool::threadPool = NULL;
+
+// Chunks handed out per thread, more than one so that uneven chunks still balance out.
+const int CHUNKS_PER_THREAD = 4;
+
+ThreadPool::ThreadPool() : stopping(false) {
+    // The calling thread takes part in parallelFor, so one thread less is spawned.
+    int count = std::max((int)std::thread::hardware_concurrency() - 1, 0);
+    for(int i = 0; i < count; i++){
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobsChanged.notify_all();
+    for(size_t i = 0; i < workers.size(); i++){
+        workers[i].join();
+    }
+}
+
+ThreadPool* ThreadPool::getThreadPool() {
+    if(threadPool == NULL){
+        threadPool = new ThreadPool();
+    }
+
+    return threadPool;
+}
+
+int ThreadPool::getThreadCount() const {
+    return workers.size() + 1;
+}
+
+void ThreadPool::workerLoop() {
+    PROFILE_THREAD_NAME("worker");
+    while(true){
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobsChanged.wait(lock, [this]{ return stopping || !jobs.empty(); });
+            if(stopping) return;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)>& body) {
+    if(end <= begin) return;
+
+    int chunks = std::min(getThreadCount() * CHUNKS_PER_THREAD, end - begin);
+    if(chunks <= 1 || workers.empty()){
+        body(begin, end);
+        return;
+    }
+
+    // Chunks are claimed through a shared counter by the workers and by this thread alike. The state is shared
+    // so that a helper which only gets to run after everything is done finds no chunk left and touches nothing else.
+    struct State {
+        std::atomic<int> nextChunk;
+        std::atomic<int> chunksDone;
+        std::mutex doneMutex;
+        std::condition_variable allDone;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->nextChunk = 0;
+    state->chunksDone = 0;
+
+    const std::function<void(int, int)>* work = &body;
+    int total = end - begin;
+    auto runChunks = [state, work, begin, total, chunks]() {
+        int chunk;
+        while((chunk = state->nextChunk.fetch_add(1)) < chunks){
+            int chunkBegin = begin + (int)((long long)total * chunk / chunks);
+            int chunkEnd = begin + (int)((long long)total * (chunk + 1) / chunks);
+            PROFILE_SCOPE("parallelFor chunk");
+            (*work)(chunkBegin, chunkEnd);
+            if(state->chunksDone.fetch_add(1) + 1 == chunks){
+                std::lock_guard<std::mutex> lock(state->doneMutex);
+                state->allDone.notify_all();
+            }
+        }
+    };
+
+    int helpers = std::min((int)workers.size(), chunks - 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(int i = 0; i < helpers; i++){
+            jobs.push_back(runChunks);
+        }
+    }
+    jobsChanged.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->allDone.wait(lock, [&]{ return state->chunksDone.load() == chunks; });
+}
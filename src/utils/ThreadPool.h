@@ -0,0 +1,35 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads shared by the whole program, used to split loops such as mesh generation.
+class ThreadPool {
+private:
+    static ThreadPool* threadPool;
+    ThreadPool();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > jobs;
+    std::mutex mutex;
+    std::condition_variable jobsChanged;
+    bool stopping;
+
+    void workerLoop();
+public:
+    static ThreadPool* getThreadPool();
+    ~ThreadPool();
+
+    int getThreadCount() const;
+
+    // Calls body(chunkBegin, chunkEnd) for consecutive chunks covering [begin, end) on all threads,
+    // including the calling one, and returns once every chunk is done.
+    void parallelFor(int begin, int end, const std::function<void(int, int)>& body);
+};
+
+#endif //THREAD_POOL_H
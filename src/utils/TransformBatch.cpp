@@ -0,0 +1,193 @@
+#include "TransformBatch.h"
+
+#include <cmath>
+
+#include "SimdMath.h"
+
+void TransformSoA::resize(size_t count){
+    positionX.resize(count);
+    positionY.resize(count);
+    positionZ.resize(count);
+    rotationX.resize(count);
+    rotationY.resize(count);
+    rotationZ.resize(count);
+    scaleX.resize(count);
+    scaleY.resize(count);
+    scaleZ.resize(count);
+}
+
+size_t TransformSoA::size() const {
+    return positionX.size();
+}
+
+void TransformSoA::set(size_t i, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale){
+    positionX[i] = position.x;
+    positionY[i] = position.y;
+    positionZ[i] = position.z;
+    rotationX[i] = rotation.x;
+    rotationY[i] = rotation.y;
+    rotationZ[i] = rotation.z;
+    scaleX[i] = scale.x;
+    scaleY[i] = scale.y;
+    scaleZ[i] = scale.z;
+}
+
+/*
+    Rotation is Ry * Rx * Rz, as in Entity::calculateRotationMatrix. Multiplied out, the columns are
+        ( cy cz + sy sx sz,  cx sz,  cy sx sz - sy cz)
+        ( sy sx cz - cy sz,  cx cz,  sy sz + cy sx cz)
+        ( sy cx,            -sx,     cy cx)
+    each scaled by the matching scale component, with the position as the last column.
+*/
+static void calculateScalar(const TransformSoA& in, glm::mat4* out, size_t begin, size_t end){
+    for(size_t i = begin; i < end; i++){
+        float sx = std::sin(in.rotationX[i]), cx = std::cos(in.rotationX[i]);
+        float sy = std::sin(in.rotationY[i]), cy = std::cos(in.rotationY[i]);
+        float sz = std::sin(in.rotationZ[i]), cz = std::cos(in.rotationZ[i]);
+        float syx = sy * sx;
+        float cyx = cy * sx;
+
+        glm::mat4& m = out[i];
+        m[0] = glm::vec4(cy * cz + syx * sz, cx * sz, cyx * sz - sy * cz, 0.0f) * in.scaleX[i];
+        m[1] = glm::vec4(syx * cz - cy * sz, cx * cz, sy * sz + cyx * cz, 0.0f) * in.scaleY[i];
+        m[2] = glm::vec4(sy * cx, -sx, cy * cx, 0.0f) * in.scaleZ[i];
+        m[3] = glm::vec4(in.positionX[i], in.positionY[i], in.positionZ[i], 1.0f);
+    }
+}
+
+#ifdef SIMD_MATH_X86
+
+// Turns one matrix column held as x, y, z, w across four entities into that column of each entity's matrix.
+static inline void storeColumn_sse2(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* out, int column){
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(&out[0][column][0], x);
+    _mm_storeu_ps(&out[1][column][0], y);
+    _mm_storeu_ps(&out[2][column][0], z);
+    _mm_storeu_ps(&out[3][column][0], w);
+}
+
+static void calculateSSE2(const TransformSoA& in, glm::mat4* out, size_t begin, size_t end){
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    size_t i = begin;
+    for(; i + 4 <= end; i += 4){
+        __m128 sx, cx, sy, cy, sz, cz;
+        sincos_sse2(_mm_loadu_ps(&in.rotationX[i]), &sx, &cx);
+        sincos_sse2(_mm_loadu_ps(&in.rotationY[i]), &sy, &cy);
+        sincos_sse2(_mm_loadu_ps(&in.rotationZ[i]), &sz, &cz);
+        __m128 syx = _mm_mul_ps(sy, sx);
+        __m128 cyx = _mm_mul_ps(cy, sx);
+        __m128 scaleX = _mm_loadu_ps(&in.scaleX[i]);
+        __m128 scaleY = _mm_loadu_ps(&in.scaleY[i]);
+        __m128 scaleZ = _mm_loadu_ps(&in.scaleZ[i]);
+
+        storeColumn_sse2(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(cy, cz), _mm_mul_ps(syx, sz)), scaleX),
+                         _mm_mul_ps(_mm_mul_ps(cx, sz), scaleX),
+                         _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cyx, sz), _mm_mul_ps(sy, cz)), scaleX),
+                         zero, out + i, 0);
+        storeColumn_sse2(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(syx, cz), _mm_mul_ps(cy, sz)), scaleY),
+                         _mm_mul_ps(_mm_mul_ps(cx, cz), scaleY),
+                         _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sy, sz), _mm_mul_ps(cyx, cz)), scaleY),
+                         zero, out + i, 1);
+        storeColumn_sse2(_mm_mul_ps(_mm_mul_ps(sy, cx), scaleZ),
+                         _mm_mul_ps(_mm_sub_ps(zero, sx), scaleZ),
+                         _mm_mul_ps(_mm_mul_ps(cy, cx), scaleZ),
+                         zero, out + i, 2);
+        storeColumn_sse2(_mm_loadu_ps(&in.positionX[i]), _mm_loadu_ps(&in.positionY[i]),
+                         _mm_loadu_ps(&in.positionZ[i]), one, out + i, 3);
+    }
+    calculateScalar(in, out, i, end);
+}
+
+// As storeColumn_sse2 for eight entities, the low 128 bit lane holds entities 0-3 and the high one 4-7.
+__attribute__((target("avx2")))
+static inline void storeColumn_avx2(__m256 x, __m256 y, __m256 z, __m256 w, glm::mat4* out, int column){
+    __m256 t0 = _mm256_unpacklo_ps(x, y);
+    __m256 t1 = _mm256_unpackhi_ps(x, y);
+    __m256 t2 = _mm256_unpacklo_ps(z, w);
+    __m256 t3 = _mm256_unpackhi_ps(z, w);
+    __m256 r0 = _mm256_shuffle_ps(t0, t2, 0x44);
+    __m256 r1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    __m256 r2 = _mm256_shuffle_ps(t1, t3, 0x44);
+    __m256 r3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    _mm_storeu_ps(&out[0][column][0], _mm256_castps256_ps128(r0));
+    _mm_storeu_ps(&out[1][column][0], _mm256_castps256_ps128(r1));
+    _mm_storeu_ps(&out[2][column][0], _mm256_castps256_ps128(r2));
+    _mm_storeu_ps(&out[3][column][0], _mm256_castps256_ps128(r3));
+    _mm_storeu_ps(&out[4][column][0], _mm256_extractf128_ps(r0, 1));
+    _mm_storeu_ps(&out[5][column][0], _mm256_extractf128_ps(r1, 1));
+    _mm_storeu_ps(&out[6][column][0], _mm256_extractf128_ps(r2, 1));
+    _mm_storeu_ps(&out[7][column][0], _mm256_extractf128_ps(r3, 1));
+}
+
+__attribute__((target("avx2")))
+static void calculateAVX2(const TransformSoA& in, glm::mat4* out, size_t begin, size_t end){
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = begin;
+    for(; i + 8 <= end; i += 8){
+        __m256 sx, cx, sy, cy, sz, cz;
+        sincos_avx2(_mm256_loadu_ps(&in.rotationX[i]), &sx, &cx);
+        sincos_avx2(_mm256_loadu_ps(&in.rotationY[i]), &sy, &cy);
+        sincos_avx2(_mm256_loadu_ps(&in.rotationZ[i]), &sz, &cz);
+        __m256 syx = _mm256_mul_ps(sy, sx);
+        __m256 cyx = _mm256_mul_ps(cy, sx);
+        __m256 scaleX = _mm256_loadu_ps(&in.scaleX[i]);
+        __m256 scaleY = _mm256_loadu_ps(&in.scaleY[i]);
+        __m256 scaleZ = _mm256_loadu_ps(&in.scaleZ[i]);
+
+        storeColumn_avx2(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(cy, cz), _mm256_mul_ps(syx, sz)), scaleX),
+                         _mm256_mul_ps(_mm256_mul_ps(cx, sz), scaleX),
+                         _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(cyx, sz), _mm256_mul_ps(sy, cz)), scaleX),
+                         zero, out + i, 0);
+        storeColumn_avx2(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(syx, cz), _mm256_mul_ps(cy, sz)), scaleY),
+                         _mm256_mul_ps(_mm256_mul_ps(cx, cz), scaleY),
+                         _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sy, sz), _mm256_mul_ps(cyx, cz)), scaleY),
+                         zero, out + i, 1);
+        storeColumn_avx2(_mm256_mul_ps(_mm256_mul_ps(sy, cx), scaleZ),
+                         _mm256_mul_ps(_mm256_sub_ps(zero, sx), scaleZ),
+                         _mm256_mul_ps(_mm256_mul_ps(cy, cx), scaleZ),
+                         zero, out + i, 2);
+        storeColumn_avx2(_mm256_loadu_ps(&in.positionX[i]), _mm256_loadu_ps(&in.positionY[i]),
+                         _mm256_loadu_ps(&in.positionZ[i]), one, out + i, 3);
+    }
+    // Up to seven left over, four of them can still go through SSE.
+    calculateSSE2(in, out, i, end);
+}
+
+#endif //SIMD_MATH_X86
+
+TransformBatch::Path TransformBatch::getBestPath(){
+#ifdef SIMD_MATH_X86
+    static const Path best = __builtin_cpu_supports("avx2") ? AVX2 : SSE2;
+    return best;
+#else
+    return SCALAR;
+#endif
+}
+
+const char* TransformBatch::getPathName(Path path){
+    switch(path){
+        case AVX2: return "AVX2";
+        case SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+void TransformBatch::calculateModelMatrices(const TransformSoA& in, glm::mat4* out){
+    calculateModelMatrices(in, out, getBestPath());
+}
+
+void TransformBatch::calculateModelMatrices(const TransformSoA& in, glm::mat4* out, Path path){
+#ifdef SIMD_MATH_X86
+    if(path == AVX2){
+        calculateAVX2(in, out, 0, in.size());
+        return;
+    }
+    if(path == SSE2){
+        calculateSSE2(in, out, 0, in.size());
+        return;
+    }
+#endif
+    calculateScalar(in, out, 0, in.size());
+}
@@ -0,0 +1,44 @@
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+#include <vector>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// Transforms of many entities, one array per component so they can be loaded straight into vector registers.
+struct TransformSoA {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ;    // Angles in radians, applied like Entity
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    void resize(size_t count);
+    size_t size() const;
+    void set(size_t i, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale);
+};
+
+/*
+    Builds model matrices for a batch of entities, several at a time with SSE or AVX2 when the CPU has them.
+
+    The result matches Entity::calculateModelMatrix(position, Entity::calculateRotationMatrix(...), scale) to
+    within a few float ulps. The vector paths use their own sine / cosine, so they are not bit for bit equal
+    to the scalar path.
+*/
+class TransformBatch {
+public:
+    enum Path {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    // Fastest path supported by the CPU, detected once.
+    static Path getBestPath();
+    static const char* getPathName(Path path);
+
+    // Writes in.size() matrices to out.
+    static void calculateModelMatrices(const TransformSoA& in, glm::mat4* out);
+    static void calculateModelMatrices(const TransformSoA& in, glm::mat4* out, Path path);
+};
+
+#endif //TRANSFORM_BATCH_H
@@ -0,0 +1,114 @@
+// Headless driver for VehicleSim: steps thousands of cars with randomised tuning and inputs as fast as it can,
+// for tuning the car model and for training AI drivers, and reports how many steps per second it manages.
+//
+//     ./vehicle_sim [--cars 10000] [--seconds 60] [--step 0.008333] [--path scalar|avx2] [--seed 1]
+
+#include "physics/VehicleSim.h"
+#include "utils/ThreadPool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static const char* USAGE =
+        "Usage: ./vehicle_sim [--cars 10000] [--seconds 60] [--step 0.008333] [--path scalar|avx2] [--seed 1]";
+
+int main(int argc, char** argv){
+    size_t cars = 10000;
+    double seconds = 60.0;
+    float dt = 1.0f / 120.0f;
+    VehicleSim::Path path = VehicleSim::getBestPath();
+    unsigned int seed = 1;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--cars" && i + 1 < argc){
+            cars = strtoul(argv[++i], NULL, 10);
+        }
+        else if(arg == "--seconds" && i + 1 < argc){
+            seconds = atof(argv[++i]);
+        }
+        else if(arg == "--step" && i + 1 < argc){
+            dt = (float)atof(argv[++i]);
+        }
+        else if(arg == "--path" && i + 1 < argc){
+            const char* name = argv[++i];
+            if(strcmp(name, "scalar") == 0){
+                path = VehicleSim::SCALAR;
+            }
+            else if(strcmp(name, "avx2") == 0){
+                path = VehicleSim::AVX2;
+            }
+            else {
+                std::cerr << "[vehicle_sim] Unknown path " << name << std::endl << USAGE << std::endl;
+                exit(1);
+            }
+        }
+        else if(arg == "--seed" && i + 1 < argc){
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else {
+            std::cerr << "[vehicle_sim] Unknown argument " << arg << std::endl << USAGE << std::endl;
+            exit(1);
+        }
+    }
+    if(path == VehicleSim::AVX2 && VehicleSim::getBestPath() != VehicleSim::AVX2){
+        std::cerr << "[vehicle_sim] This CPU has no AVX2" << std::endl;
+        exit(1);
+    }
+
+    // Every car gets its own variation on the default tuning and a spot on a large grid.
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> variation(0.8f, 1.2f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    VehicleSim sim;
+    sim.reserve(cars);
+    for(size_t i = 0; i < cars; i++){
+        VehicleParams params;
+        params.mass *= variation(random);
+        params.engineForce *= variation(random);
+        params.tireGrip *= variation(random);
+        params.cornerStiffnessRear *= variation(random);
+        glm::vec2 position((float)(i % 100) * 20.0f, (float)(i / 100) * 20.0f);
+        sim.add(params, position, unit(random) * 6.2831853f);
+    }
+
+    // Drivers change their minds once a simulated second, the inputs are set outside the timed steps.
+    const int stepsPerInput = std::max(1, (int)(1.0f / dt + 0.5f));
+    const long long totalSteps = (long long)(seconds / dt + 0.5);
+    std::vector<VehicleInput> inputs(cars);
+    double stepTime = 0.0;
+    for(long long step = 0; step < totalSteps; step++){
+        if(step % stepsPerInput == 0){
+            for(size_t i = 0; i < cars; i++){
+                float roll = unit(random);
+                inputs[i].throttle = roll < 0.7f ? 1.0f : 0.0f;
+                inputs[i].brake = roll > 0.9f ? 1.0f : 0.0f;
+                inputs[i].ebrake = unit(random) < 0.05f ? 1.0f : 0.0f;
+                inputs[i].steer = (unit(random) - 0.5f) * 1.2f;
+                sim.setInput(i, inputs[i]);
+            }
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        sim.step(dt, path);
+        stepTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double meanSpeed = 0.0;
+    for(size_t i = 0; i < cars; i++){
+        meanSpeed += sim.getSpeed(i);
+    }
+    meanSpeed /= std::max(cars, (size_t)1);
+
+    printf("%zu cars, %lld steps of %.4f s on %d threads, %s path\n", cars, totalSteps, dt,
+           ThreadPool::getThreadPool()->getThreadCount(), VehicleSim::getPathName(path));
+    printf("%.3f s for %.1f simulated seconds, %.1fx real time\n", stepTime, totalSteps * dt,
+           stepTime > 0.0 ? totalSteps * dt / stepTime : 0.0);
+    printf("%.0f steps/s, %.3g car steps/s\n", totalSteps / stepTime, totalSteps * (double)cars / stepTime);
+    printf("mean speed at the end %.2f m/s\n", meanSpeed);
+    return 0;
+}